@@ -1,2 +1,18 @@
 #pragma once
 #include "bsp/bsp_hope.h"
+#include "bsp/bsp_gpio_fast.h"
+#include "bsp/bsp_gesture.h"
+#include "bsp/bsp_led_pwm.h"
+#include "bsp/bsp_color.h"
+#include "bsp/bsp_led_fx.h"
+#include "bsp/bsp_led_async.h"
+#include "bsp/bsp_led_strip_ext.h"
+#include "bsp/bsp_audio.h"
+#include "bsp/bsp_power.h"
+#include "bsp/bsp_settings.h"
+#include "bsp/bsp_evlog.h"
+#include "bsp/bsp_load.h"
+#include "bsp/bsp_sched.h"
+#include "bsp/bsp_metrics.h"
+#include "bsp/bsp_monitor.h"
+#include "bsp/bsp_trace.h"
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: audio input pipeline
+ *
+ * With CONFIG_BSP_AUDIO an analog microphone on CONFIG_BSP_AUDIO_ADC_GPIO is
+ * sampled by the ADC in continuous mode. DMA fills the ADC driver's ring
+ * buffer and the conversion-done interrupt only wakes the audio task. The task
+ * collects BSP_AUDIO_FFT_SIZE samples, removes DC, runs the fixed-point
+ * analysis of bsp_audio_dsp.h and publishes BSP_AUDIO_BANDS levels (0-255,
+ * automatic gain) to a callback and to bsp_audio_get_levels().
+ *
+ * Analysis takes well under a millisecond per frame on the ESP32-C3. Run the
+ * task below the input handling tasks: when it falls behind, the ring buffer
+ * drops the oldest samples (counted in the audio.overflows metric), the rest
+ * of the system is not delayed.
+ *
+ * bsp_led_fx_spectrum() draws the levels on the RGB LEDs.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED when CONFIG_BSP_AUDIO is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "bsp/bsp_audio_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_AUDIO_TASK_STACK_SIZE   3072
+
+/**
+ * @brief Level callback, called from the audio task once per analysis frame
+ *
+ * @param levels Level per band, 0-255, lowest band first
+ * @param arg User argument
+ */
+typedef void (*bsp_audio_cb_t)(const uint8_t levels[BSP_AUDIO_BANDS], void *arg);
+
+/**
+ * @brief Audio pipeline configuration
+ */
+typedef struct {
+    uint8_t task_priority;      /*!< Audio task priority */
+    bsp_audio_cb_t callback;    /*!< Level callback, may be NULL */
+    void *user_arg;             /*!< Argument passed to the callback */
+} bsp_audio_config_t;
+
+/**
+ * @brief Start sampling and analysis
+ *
+ * @param config Pipeline configuration
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config is NULL or the GPIO is not an ADC1 pin
+ *      - ESP_ERR_INVALID_STATE if already running
+ *      - ESP_ERR_NO_MEM if the task cannot be created
+ *      - Other errors from the ADC driver
+ */
+esp_err_t bsp_audio_start(const bsp_audio_config_t *config);
+
+/**
+ * @brief Stop sampling and release the ADC
+ *
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_audio_stop(void);
+
+/**
+ * @brief Get the levels of the last analysis frame
+ *
+ * @param[out] levels Level per band, 0-255
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if levels is NULL
+ */
+esp_err_t bsp_audio_get_levels(uint8_t levels[BSP_AUDIO_BANDS]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: fixed-point audio analysis
+ *
+ * Windowed 256-point FFT and band energy extraction in Q15 integer math,
+ * used by the audio input pipeline (bsp_audio.h). This part has no ESP-IDF
+ * dependencies, so it also builds on the host: tools/audio_bands.c runs it
+ * on recorded sample files.
+ *
+ * The FFT scales by 1/2 per stage, so its output is the transform divided by
+ * BSP_AUDIO_FFT_SIZE and cannot overflow.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_AUDIO_FFT_LOG2      8
+#define BSP_AUDIO_FFT_SIZE      (1 << BSP_AUDIO_FFT_LOG2)   /*!< Samples per analysis frame */
+#define BSP_AUDIO_BANDS         8                           /*!< Octave-spaced bands, top octave halved */
+#define BSP_AUDIO_AGC_FLOOR     64                          /*!< Band energy shown as full scale at least */
+#define BSP_AUDIO_AGC_RANGE_LOG2 3                          /*!< Bands gain at most 8x over the loudest one */
+#define BSP_AUDIO_AGC_LEAK_LOG2 5                           /*!< Bands below 1/32 of the loudest are dark */
+#define BSP_AUDIO_AGC_GATE      16                          /*!< Band energy below this is dark (noise) */
+
+/**
+ * @brief Automatic gain state, one decaying peak per band
+ */
+typedef struct {
+    uint32_t peak[BSP_AUDIO_BANDS];
+} bsp_audio_agc_t;
+
+/**
+ * @brief In-place radix-2 FFT on Q15 data
+ *
+ * @param re Real parts, BSP_AUDIO_FFT_SIZE values
+ * @param im Imaginary parts, BSP_AUDIO_FFT_SIZE values
+ */
+void bsp_audio_fft(int16_t *re, int16_t *im);
+
+/**
+ * @brief Window one frame, transform it and sum the bin magnitudes per band
+ *
+ * Bands 0-5 cover FFT bins [2^b, 2^(b+1)). The top octave is split in two:
+ * band 6 covers bins [64, 96) and band 7 runs from bin 96 up to half the
+ * sample rate. At 20 kHz a bin is 78 Hz wide and band 0 starts at 78 Hz.
+ *
+ * @param samples BSP_AUDIO_FFT_SIZE samples, DC removed, Q15
+ * @param[out] bands Energy per band
+ */
+void bsp_audio_analyze(const int16_t *samples, uint32_t bands[BSP_AUDIO_BANDS]);
+
+/**
+ * @brief Turn band energies into 0-255 levels relative to a decaying peak
+ *
+ * Each band follows its own peak, so quiet treble shows as well as loud bass,
+ * but no band is amplified more than 2^BSP_AUDIO_AGC_RANGE_LOG2 times beyond
+ * the loudest band. Window leakage next to a loud band (energy below
+ * 2^-BSP_AUDIO_AGC_LEAK_LOG2 of the loudest band in the frame) and noise
+ * below BSP_AUDIO_AGC_GATE are shown as 0.
+ *
+ * @param agc Gain state, zero-initialize before the first call
+ * @param bands Energy per band, from bsp_audio_analyze()
+ * @param[out] levels Level per band, 0-255
+ */
+void bsp_audio_agc_update(bsp_audio_agc_t *agc, const uint32_t bands[BSP_AUDIO_BANDS],
+                          uint8_t levels[BSP_AUDIO_BANDS]);
+
+#ifdef __cplusplus
+}
+#endif
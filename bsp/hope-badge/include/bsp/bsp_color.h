@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: fixed-point color math
+ *
+ * 8-bit integer color primitives for the RGB LEDs. The ESP32-C3 has no FPU, so
+ * everything here works on uint8_t channels with 16-bit intermediates: HSV to
+ * RGB, scaling, blending, 16-entry palettes with interpolation and table-driven
+ * sine and easing curves. No function allocates or takes a lock; all are safe
+ * to call per pixel at full frame rate.
+ *
+ * Hue, angles and fractions are 0-255 for a full turn or range: hue 0 is red,
+ * 85 green, 170 blue, and 256 wraps back to red.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief RGB color, channel order as written to the LEDs
+ */
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} bsp_rgb_t;
+
+/**
+ * @brief 16-entry color palette, see bsp_color_from_palette()
+ */
+typedef struct {
+    bsp_rgb_t entries[16];
+} bsp_palette16_t;
+
+#define BSP_RGB(red, green, blue)   ((bsp_rgb_t){.r = (red), .g = (green), .b = (blue)})
+#define BSP_RGB_BLACK               BSP_RGB(0, 0, 0)
+
+extern const bsp_palette16_t bsp_palette_rainbow;   /*!< Full hue circle */
+extern const bsp_palette16_t bsp_palette_heat;      /*!< Black, red, yellow, white */
+extern const bsp_palette16_t bsp_palette_ocean;     /*!< Blues and cyans */
+
+/**
+ * @brief Scale a value by @p scale / 256, 255 keeps the value unchanged
+ */
+FORCE_INLINE_ATTR uint8_t bsp_scale8(uint8_t value, uint8_t scale)
+{
+    return ((uint16_t)value * ((uint16_t)scale + 1)) >> 8;
+}
+
+/**
+ * @brief Interpolate from @p a (frac 0) to @p b (frac 255)
+ */
+FORCE_INLINE_ATTR uint8_t bsp_lerp8(uint8_t a, uint8_t b, uint8_t frac)
+{
+    return ((uint16_t)a * (255 - frac) + (uint16_t)b * frac + 127) / 255;
+}
+
+/**
+ * @brief Add two values, saturating at 255
+ */
+FORCE_INLINE_ATTR uint8_t bsp_qadd8(uint8_t a, uint8_t b)
+{
+    uint16_t sum = (uint16_t)a + b;
+    return (sum > 255) ? 255 : sum;
+}
+
+/**
+ * @brief Perceptual brightness correction (square law, as the status LED)
+ */
+FORCE_INLINE_ATTR uint8_t bsp_gamma8(uint8_t value)
+{
+    return ((uint16_t)value * value + 255) >> 8;
+}
+
+/**
+ * @brief Scale all channels of a color
+ */
+FORCE_INLINE_ATTR bsp_rgb_t bsp_color_scale(bsp_rgb_t color, uint8_t scale)
+{
+    return BSP_RGB(bsp_scale8(color.r, scale), bsp_scale8(color.g, scale), bsp_scale8(color.b, scale));
+}
+
+/**
+ * @brief Blend two colors, @p amount 0 gives @p a and 255 gives @p b
+ */
+FORCE_INLINE_ATTR bsp_rgb_t bsp_color_blend(bsp_rgb_t a, bsp_rgb_t b, uint8_t amount)
+{
+    return BSP_RGB(bsp_lerp8(a.r, b.r, amount), bsp_lerp8(a.g, b.g, amount), bsp_lerp8(a.b, b.b, amount));
+}
+
+/**
+ * @brief Add two colors channel by channel, saturating
+ */
+FORCE_INLINE_ATTR bsp_rgb_t bsp_color_add(bsp_rgb_t a, bsp_rgb_t b)
+{
+    return BSP_RGB(bsp_qadd8(a.r, b.r), bsp_qadd8(a.g, b.g), bsp_qadd8(a.b, b.b));
+}
+
+/**
+ * @brief Convert HSV to RGB
+ *
+ * @param hue Hue, 0-255 for a full turn
+ * @param sat Saturation, 0 (white) to 255 (pure color)
+ * @param val Value, 0 (black) to 255 (full)
+ * @return RGB color
+ */
+bsp_rgb_t bsp_color_hsv(uint8_t hue, uint8_t sat, uint8_t val);
+
+/**
+ * @brief Look up a palette color, interpolating between neighbouring entries
+ *
+ * The top 4 bits of @p index select the entry, the low 4 bits blend towards
+ * the next one, wrapping from the last entry back to the first.
+ *
+ * @param palette Palette
+ * @param index Position in the palette, 0-255
+ * @param brightness Scale applied to the result, 255 for full
+ * @return RGB color
+ */
+bsp_rgb_t bsp_color_from_palette(const bsp_palette16_t *palette, uint8_t index, uint8_t brightness);
+
+/**
+ * @brief Sine from a precomputed table
+ *
+ * @param theta Angle, 0-255 for a full turn
+ * @return 128 + 127 * sin(theta), so 1 to 255 with 128 at 0
+ */
+uint8_t bsp_sin8(uint8_t theta);
+
+/**
+ * @brief Ease-in-out (cubic) curve from a precomputed table
+ *
+ * @param x Position, 0-255
+ * @return Eased position, 0-255
+ */
+uint8_t bsp_ease8(uint8_t x);
+
+#ifdef __cplusplus
+}
+#endif
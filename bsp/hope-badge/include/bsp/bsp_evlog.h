@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: persistent event log
+ *
+ * With CONFIG_BSP_EVLOG the BSP keeps an append-only circular log of compact
+ * 16-byte records in a dedicated data partition (CONFIG_BSP_EVLOG_PARTITION),
+ * so the cause of a failure in the field survives the reboot. The BSP logs
+ * the reset reason at every boot, fuel gauge and PCF8574 I2C errors and a
+ * battery sample every CONFIG_BSP_EVLOG_BATTERY_INTERVAL_S; applications add
+ * their own records from BSP_EVLOG_USER upwards.
+ *
+ * Flash layout: every sector starts with a header holding a sequence number
+ * and the boot counter, followed by records. Records are collected in RAM and
+ * written a page at a time by the BSP worker task, never by the writer; when
+ * a sector is full the oldest one is erased and reused, so each sector is
+ * erased once per pass over the partition. Every record carries a CRC-8: a
+ * write torn by power loss leaves a record that readers skip, and
+ * the next boot continues after it. Erased flash (all 0xFF) marks the end.
+ *
+ * Records still buffered in RAM are lost on a crash or power loss. Resets
+ * and brownouts are written immediately, the rest at the latest after
+ * CONFIG_BSP_EVLOG_FLUSH_INTERVAL_S, and bsp_deep_sleep_start() flushes.
+ *
+ * Read the partition with
+ *   parttool.py read_partition --partition-name bsp_log --output bsp_log.bin
+ * and decode it with tools/bsp_evlog_decode.py.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED when CONFIG_BSP_EVLOG is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_EVLOG_MAGIC         0x4C505342  /*!< "BSPL" little-endian, sector header */
+#define BSP_EVLOG_VERSION       1
+#define BSP_EVLOG_HEADER_SIZE   16
+#define BSP_EVLOG_RECORD_SIZE   16
+
+/**
+ * @brief Record types
+ */
+typedef enum {
+    BSP_EVLOG_RESET = 1,        /*!< Boot, arg0 = esp_reset_reason_t */
+    BSP_EVLOG_BROWNOUT = 2,     /*!< Boot after a brownout reset, arg0 = last battery sample in mV or 0 */
+    BSP_EVLOG_I2C_ERROR = 3,    /*!< arg0 = 7-bit address, arg1 = esp_err_t */
+    BSP_EVLOG_BATTERY = 4,      /*!< arg0 = cell voltage in mV */
+    BSP_EVLOG_LOAD = 5,         /*!< Load shedding level change, arg0 = bsp_load_level_t, arg1 = budget in mA */
+    BSP_EVLOG_USER = 0x80,      /*!< First application-defined type, up to 0xFE */
+} bsp_evlog_type_t;
+
+/**
+ * @brief One log record as stored in flash
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;           /*!< Milliseconds since boot */
+    uint16_t boot;              /*!< Boot counter, increments with every mount */
+    uint8_t type;               /*!< bsp_evlog_type_t */
+    uint8_t crc;                /*!< CRC-8 (polynomial 0x07) over the other 15 bytes */
+    uint32_t arg0;
+    uint32_t arg1;
+} bsp_evlog_record_t;
+
+_Static_assert(sizeof(bsp_evlog_record_t) == BSP_EVLOG_RECORD_SIZE, "Record size is part of the flash format");
+
+/**
+ * @brief Mount the log partition and record the reset reason
+ *
+ * Called by bsp_init().
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the partition does not exist
+ *      - ESP_ERR_INVALID_SIZE if the partition is smaller than two sectors
+ *      - Other errors from flash access
+ */
+esp_err_t bsp_evlog_init(void);
+
+/**
+ * @brief Append a record
+ *
+ * The record goes to the RAM buffer and the call never waits for flash; a
+ * full buffer is handed to the BSP worker task. While it is being written,
+ * new records are dropped. Not callable from interrupts.
+ *
+ * @param type Record type, not 0xFF
+ * @param arg0 First argument
+ * @param arg1 Second argument
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG for type 0xFF
+ *      - ESP_ERR_INVALID_STATE if the log is not mounted
+ *      - ESP_ERR_NO_MEM if the buffer is full, the record is dropped
+ */
+esp_err_t bsp_evlog_write(uint8_t type, uint32_t arg0, uint32_t arg1);
+
+/**
+ * @brief Write buffered records to flash
+ *
+ * @return
+ *      - ESP_OK on success or if nothing is buffered
+ *      - ESP_ERR_INVALID_STATE if the log is not mounted
+ *      - Other errors from flash access
+ */
+esp_err_t bsp_evlog_flush(void);
+
+/**
+ * @brief Print all records in flash to the console, oldest first
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the log is not mounted
+ */
+esp_err_t bsp_evlog_dump(void);
+
+/**
+ * @brief Erase the whole log
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the log is not mounted
+ *      - Other errors from flash access
+ */
+esp_err_t bsp_evlog_erase(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: button gesture recognizer
+ *
+ * With CONFIG_BSP_GESTURE the BSP reads the buttons itself instead of
+ * creating iot_button devices (bsp_get_button_handle() returns NULL). One
+ * task takes the debounced edges of all buttons and, optionally, of the
+ * PCF8574 inputs, and runs them through a table of gestures supplied by the
+ * application: single presses, multi-clicks, long presses, chords, sequences
+ * and hold-while-press combos.
+ *
+ * The task sleeps until an input interrupt or the nearest gesture timeout.
+ * Button pins are armed with a level interrupt for their next transition,
+ * which doubles as the light-sleep wake-up source, so no timer runs while
+ * the buttons are idle.
+ *
+ * Inputs are identified by bits in a 32-bit mask, see BSP_GESTURE_BUTTON(),
+ * BSP_GESTURE_EXPANDER() and BSP_GESTURE_ADDON(). A set bit means pressed
+ * (active level for buttons, LOW for expander inputs).
+ *
+ * Every entry whose pattern matches fires, in table order: a combo's trigger
+ * button also fires a BSP_GESTURE_PRESS entry for that button.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED (or 0) when CONFIG_BSP_GESTURE
+ * is not set.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_GESTURE_TASK_STACK_SIZE 3072
+
+#define BSP_GESTURE_BUTTON(index)   (1UL << (index))            /*!< Button, BSP_BUTTON_x_GPIO_INDEX */
+#define BSP_GESTURE_EXPANDER(pin)   (1UL << (8 + (pin)))        /*!< Badge PCF8574 input P0-P7 */
+#define BSP_GESTURE_ADDON(pin)      (1UL << (16 + (pin)))       /*!< First add-on expander input, P00-P17 */
+
+/**
+ * @brief Gesture types
+ */
+typedef enum {
+    BSP_GESTURE_PRESS = 0,      /*!< Any input of `inputs` pressed */
+    BSP_GESTURE_MULTI_PRESS,    /*!< `count` presses of `inputs`, each within `time_ms` of the previous one */
+    BSP_GESTURE_LONG_PRESS,     /*!< All of `inputs` held for `time_ms`, no other input pressed meanwhile */
+    BSP_GESTURE_CHORD,          /*!< All of `inputs` pressed within `time_ms` of the first, nothing else */
+    BSP_GESTURE_SEQUENCE,       /*!< `sequence[0..count-1]` pressed in order, steps `time_ms` apart at most */
+    BSP_GESTURE_COMBO,          /*!< `trigger` pressed while all of `inputs` are held */
+} bsp_gesture_type_t;
+
+typedef struct bsp_gesture bsp_gesture_t;
+
+/**
+ * @brief Gesture callback, called from the gesture task
+ *
+ * @param gesture Table entry that matched
+ * @param arg User argument of the entry
+ */
+typedef void (*bsp_gesture_cb_t)(const bsp_gesture_t *gesture, void *arg);
+
+/**
+ * @brief Gesture table entry
+ */
+struct bsp_gesture {
+    bsp_gesture_type_t type;
+    uint32_t inputs;            /*!< Inputs of the gesture; COMBO: inputs to hold */
+    uint32_t trigger;           /*!< COMBO: inputs to press while holding */
+    const uint32_t *sequence;   /*!< SEQUENCE: inputs per step, several bits for a chord step */
+    uint8_t count;              /*!< MULTI_PRESS: presses, SEQUENCE: steps */
+    uint16_t time_ms;           /*!< Timing as described per type, 0 for the Kconfig default */
+    bsp_gesture_cb_t callback;  /*!< Called when the gesture is recognized */
+    void *user_arg;             /*!< Argument passed to the callback */
+};
+
+/**
+ * @brief Input callback, called from the gesture task for every debounced change
+ *
+ * @param pressed Inputs pressed now
+ * @param changed Inputs that changed
+ * @param arg User argument
+ */
+typedef void (*bsp_gesture_input_cb_t)(uint32_t pressed, uint32_t changed, void *arg);
+
+/**
+ * @brief Recognizer configuration
+ */
+typedef struct {
+    const bsp_gesture_t *gestures;      /*!< Gesture table, must stay valid while running */
+    size_t num_gestures;                /*!< Entries, up to CONFIG_BSP_GESTURE_MAX */
+    bool expanders;                     /*!< Also take the PCF8574 inputs, uses bsp_pcf8574_start_events() */
+    uint8_t task_priority;              /*!< Gesture task priority */
+    bsp_gesture_input_cb_t input_cb;    /*!< Debounced input changes, may be NULL */
+    void *user_arg;                     /*!< Argument passed to input_cb */
+} bsp_gesture_config_t;
+
+/**
+ * @brief Start the recognizer
+ *
+ * @param config Recognizer configuration
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config is NULL or the table is invalid or too large
+ *      - ESP_ERR_INVALID_STATE if already running
+ *      - ESP_ERR_NO_MEM if the task cannot be created
+ *      - Other errors from the GPIO driver or bsp_pcf8574_start_events()
+ */
+esp_err_t bsp_gesture_start(const bsp_gesture_config_t *config);
+
+/**
+ * @brief Stop the recognizer and release the button interrupts
+ *
+ * May be called from a gesture or input callback: the task then exits once
+ * the callback returns, and bsp_gesture_start() returns ESP_ERR_INVALID_STATE
+ * until it has.
+ *
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_gesture_stop(void);
+
+/**
+ * @brief Get the debounced inputs
+ *
+ * @return Inputs pressed now, 0 while stopped
+ */
+uint32_t bsp_gesture_get_inputs(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: Fast-path GPIO output
+ *
+ * Inline accessors that write the GPIO output set/clear registers directly,
+ * without the range check, logging and driver call of bsp_gpio_set_level().
+ * Intended for blinking, software PWM and bit-banged protocols.
+ *
+ * The accessors do not check their arguments. Only use them on pins that were
+ * validated once by bsp_gpio_fast_init(), or on BSP_LED_IO / BSP_VIBRAMOTOR_IO
+ * after bsp_led_init() / vibramotor_init(). Writing the vibration motor pin
+ * while a pattern is running races with the vibramotor task.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+#include "driver/gpio.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* All ESP32-C3 pins live in the single 32-bit GPIO_OUT register */
+_Static_assert(SOC_GPIO_PIN_COUNT <= 32, "Fast-path GPIO only supports targets with up to 32 GPIOs");
+
+#define BSP_GPIO_FAST_BIT(gpio)         (1UL << (gpio))
+
+/**
+ * @brief Validate and configure pins for the fast path
+ *
+ * Pins that are not owned by the BSP are configured as push-pull outputs and
+ * driven low. BSP_LED_IO and BSP_VIBRAMOTOR_IO are accepted as-is, they are
+ * configured by their own init functions. Calling it again adds pins.
+ *
+ * @param mask Bit mask of GPIOs, BSP_GPIO_FAST_BIT(gpio) for each pin
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a pin is not output capable or is used by another BSP function
+ */
+esp_err_t bsp_gpio_fast_init(uint32_t mask);
+
+/**
+ * @brief Get the mask of pins accepted by bsp_gpio_fast_init() so far
+ */
+uint32_t bsp_gpio_fast_get_mask(void);
+
+/**
+ * @brief Drive a pin high
+ */
+FORCE_INLINE_ATTR void bsp_gpio_fast_set(gpio_num_t gpio)
+{
+    REG_WRITE(GPIO_OUT_W1TS_REG, BSP_GPIO_FAST_BIT(gpio));
+}
+
+/**
+ * @brief Drive a pin low
+ */
+FORCE_INLINE_ATTR void bsp_gpio_fast_clear(gpio_num_t gpio)
+{
+    REG_WRITE(GPIO_OUT_W1TC_REG, BSP_GPIO_FAST_BIT(gpio));
+}
+
+/**
+ * @brief Drive a pin to @p level
+ */
+FORCE_INLINE_ATTR void bsp_gpio_fast_write(gpio_num_t gpio, bool level)
+{
+    REG_WRITE(level ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, BSP_GPIO_FAST_BIT(gpio));
+}
+
+/**
+ * @brief Read the input level of a pin
+ */
+FORCE_INLINE_ATTR bool bsp_gpio_fast_read(gpio_num_t gpio)
+{
+    return (REG_READ(GPIO_IN_REG) >> gpio) & 1;
+}
+
+/**
+ * @brief Write several pins at once
+ *
+ * Pins in @p mask are driven to the matching bit of @p value, other pins are
+ * left alone. Set and clear are two register writes, so the pins going high
+ * change one APB cycle before the pins going low.
+ *
+ * @param mask Pins to write, BSP_GPIO_FAST_BIT(gpio) for each pin
+ * @param value New levels, same bit layout as @p mask
+ */
+FORCE_INLINE_ATTR void bsp_gpio_fast_write_mask(uint32_t mask, uint32_t value)
+{
+    REG_WRITE(GPIO_OUT_W1TS_REG, value & mask);
+    REG_WRITE(GPIO_OUT_W1TC_REG, ~value & mask);
+}
+
+#if CONFIG_BSP_LED_GPIO >= 0
+/**
+ * @brief Switch the single status LED (BSP_LED_IO), honoring CONFIG_BSP_LED_ACTIVE_LEVEL
+ */
+FORCE_INLINE_ATTR void bsp_led_fast_set(bool on)
+{
+    bsp_gpio_fast_write((gpio_num_t)CONFIG_BSP_LED_GPIO, on == (CONFIG_BSP_LED_ACTIVE_LEVEL != 0));
+}
+#endif
+
+#if CONFIG_BSP_VIBRATION_MOTOR_GPIO >= 0
+/**
+ * @brief Drive the vibration motor pin (BSP_VIBRAMOTOR_IO) directly
+ */
+FORCE_INLINE_ATTR void bsp_vibramotor_fast_set(bool on)
+{
+    bsp_gpio_fast_write((gpio_num_t)CONFIG_BSP_VIBRATION_MOTOR_GPIO, on);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "sdkconfig.h"
 #include "driver/gpio.h"
 
@@ -7,10 +10,52 @@
 #include "led_strip.h"
 #include "max17048.h"
 #include "pcf8574.h"
+#include "pcf8574_group.h"
+#include "pcf8574_pattern.h"
 
 /**************************************************************************************************
  *  BSP Capabilities
  **************************************************************************************************/
+/*
+ * One description per HW revision: fitted optional peripherals (drivers for absent ones are compiled
+ * out; the LED and the RGB LEDs are on every revision), expander address and number of RGB LEDs fitted. Pins are set in Kconfig and checked in
+ * bsp_board.c. Only 0.8.15 has been verified on hardware; the 0.8.16 and 0.8.17 entries repeat its
+ * values until someone checks a board, so a difference found there is a change to that block only.
+ */
+#if CONFIG_BSP_HW_VERSION_0_8_15
+#define BSP_HW_VERSION_NAME         "0.8.15"
+#define BSP_CAPS_VIBRAMOTOR         1
+#define BSP_CAPS_FUEL_GAUGE         1
+#define BSP_CAPS_PCF8574            1
+#define BSP_CAPS_IRDA               0       /* Pins routed, no driver yet */
+#define BSP_PCF8574_I2C_ADDR        0       /* PCF8574 (0x20) or PCF8574A (0x38) fitted, probed at init */
+#define BSP_LED_RGB_PIXELS_FITTED   16
+#elif CONFIG_BSP_HW_VERSION_0_8_16
+#define BSP_HW_VERSION_NAME         "0.8.16"    /* Unverified, values of 0.8.15 */
+#define BSP_CAPS_VIBRAMOTOR         1
+#define BSP_CAPS_FUEL_GAUGE         1
+#define BSP_CAPS_PCF8574            1
+#define BSP_CAPS_IRDA               0
+#define BSP_PCF8574_I2C_ADDR        0
+#define BSP_LED_RGB_PIXELS_FITTED   16
+#elif CONFIG_BSP_HW_VERSION_0_8_17
+#define BSP_HW_VERSION_NAME         "0.8.17"    /* Unverified, values of 0.8.15 */
+#define BSP_CAPS_VIBRAMOTOR         1
+#define BSP_CAPS_FUEL_GAUGE         1
+#define BSP_CAPS_PCF8574            1
+#define BSP_CAPS_IRDA               0
+#define BSP_PCF8574_I2C_ADDR        0
+#define BSP_LED_RGB_PIXELS_FITTED   16
+#else
+#error "Unknown HOPE badge HW version"
+#endif
+
+/* Buttons 3 and 4 share the USB D-/D+ pins */
+#if CONFIG_BSP_BUTTONS_3_4
+#define BSP_CAPS_BUTTONS        4
+#else
+#define BSP_CAPS_BUTTONS        2
+#endif
 
 /**************************************************************************************************
  *  Pinout
@@ -51,6 +96,10 @@
 #define BSP_IRDA_TX_IO          (CONFIG_BSP_IRDA_TX_GPIO)
 #define BSP_IRDA_RX_IO          (CONFIG_BSP_IRDA_RX_GPIO)
 
+/* Interrupt lines (-1 when not wired) */
+#define BSP_PCF8574_INT_IO      (CONFIG_BSP_PCF8574_INT_GPIO)
+#define BSP_FUEL_GAUGE_ALRT_IO  (CONFIG_BSP_FUEL_GAUGE_ALRT_GPIO)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -61,6 +110,32 @@ extern "C" {
  *
  **************************************************************************************************/
 
+/**
+ * @brief bsp_init() stages
+ */
+typedef enum {
+    BSP_INIT_STAGE_I2C = 0,     /*!< I2C bus */
+    BSP_INIT_STAGE_I2C_SCAN,    /*!< I2C device discovery */
+    BSP_INIT_STAGE_LED,         /*!< Single GPIO LED */
+    BSP_INIT_STAGE_LED_RGB,     /*!< RGB LED strip */
+    BSP_INIT_STAGE_BUTTONS,     /*!< Buttons */
+    BSP_INIT_STAGE_FUEL_GAUGE,  /*!< MAX17048 fuel gauge */
+    BSP_INIT_STAGE_PCF8574,     /*!< PCF8574 I/O expander */
+    BSP_INIT_STAGE_POWER,       /*!< Power management */
+    BSP_INIT_STAGE_MAX,
+} bsp_init_stage_id_t;
+
+/**
+ * @brief Timing record of one bsp_init() stage
+ */
+typedef struct {
+    const char *name;       /*!< Stage name */
+    bool done;              /*!< Stage has run; a failed lazy stage stays not done and is retried */
+    int64_t start_us;       /*!< Start time, microseconds since boot */
+    int64_t duration_us;    /*!< Duration in microseconds */
+    esp_err_t err;          /*!< Stage result */
+} bsp_init_stage_t;
+
 /**
  * @brief Initialize BSP
  *
@@ -70,9 +145,71 @@ extern "C" {
  *      - ESP_FAIL              BSP initialization error
  *
  * @note This function initializes the I2C driver, buttons, LEDs, and other BSP components.
+ *       With CONFIG_BSP_INIT_LAZY the RGB LED, fuel gauge and PCF8574 are initialized on
+ *       first use instead; a stage that fails is retried on a later use, at most once a second.
  */
  esp_err_t bsp_init(void);
 
+/**
+ * @brief Get the bsp_init() stage timing records
+ *
+ * @return Array of BSP_INIT_STAGE_MAX records, indexed by bsp_init_stage_id_t
+ */
+const bsp_init_stage_t *bsp_init_get_stages(void);
+
+/**
+ * @brief Log the bsp_init() stage timing records
+ */
+void bsp_init_print_stages(void);
+
+/**
+ * @brief Board description of the selected HW revision
+ *
+ * Built at compile time from CONFIG_BSP_HW_VERSION and the pin configuration.
+ * GPIOs are -1 when the function is not wired or not enabled.
+ */
+typedef struct {
+    const char *hw_version;             /*!< HW revision name, e.g. "0.8.15" */
+    struct {
+        int8_t scl;
+        int8_t sda;
+    } i2c;                              /*!< I2C bus pins */
+    struct {
+        int8_t gpio;
+        uint8_t active_level;
+    } buttons[BSP_BUTTON_NUM];          /*!< Buttons, indexed by BSP_BUTTON_x_GPIO_INDEX */
+    struct {
+        int8_t gpio;
+        uint8_t active_level;
+    } led;                              /*!< Single GPIO LED */
+    struct {
+        int8_t gpio;
+        uint16_t pixels;
+    } led_rgb;                          /*!< WS2812 RGB LED strip */
+    int8_t vibramotor_gpio;             /*!< Vibration motor */
+    struct {
+        int8_t tx;
+        int8_t rx;
+    } irda;                             /*!< IrDA transceiver */
+    int8_t pcf8574_int_gpio;            /*!< PCF8574 INT line */
+    int8_t fuel_gauge_alrt_gpio;        /*!< MAX17048 ALRT line */
+    uint8_t pcf8574_addr;               /*!< PCF8574 address, 0 = probed at init */
+    struct {
+        bool vibramotor;
+        bool fuel_gauge;
+        bool pcf8574;
+        bool irda;
+    } has;                              /*!< Fitted optional peripherals, the LEDs are on every revision */
+} bsp_board_desc_t;
+
+/**
+ * @brief Get the board description of the selected HW revision
+ *
+ * @return
+ *      - Board description (never NULL)
+ */
+const bsp_board_desc_t *bsp_get_board_desc(void);
+
 /**************************************************************************************************
  *
  * GPIO
@@ -129,6 +266,54 @@ esp_err_t bsp_i2c_init(void);
  */
 esp_err_t bsp_i2c_deinit(void);
 
+/**
+ * @brief Get the I2C bus handle
+ *
+ * @return
+ *      - I2C bus handle if initialized
+ *      - NULL if not initialized
+ */
+i2c_bus_handle_t bsp_i2c_get_handle(void);
+
+/**
+ * @brief Discover the I2C devices present on the badge
+ *
+ * Probes every address a BSP driver knows about in a single bus scan and builds a
+ * presence map. With CONFIG_BSP_I2C_SCAN_CACHE the map is stored in NVS, keyed by
+ * HW version, and later boots load it instead of scanning, after probing the badge
+ * devices to check that it is still valid. The application initializes NVS. Drivers
+ * use the map to attach directly, without probing absent addresses.
+ *
+ * @param rescan Ignore the cached map and scan the bus again
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE I2C bus is not initialized
+ */
+esp_err_t bsp_i2c_scan(bool rescan);
+
+/**
+ * @brief Check whether a device answered at the given address
+ *
+ * Runs bsp_i2c_scan(false) if no presence map is available yet.
+ *
+ * @param addr 7-bit I2C address
+ *
+ * @return
+ *      - true if the device is present
+ */
+bool bsp_i2c_device_present(uint8_t addr);
+
+/**
+ * @brief Drop the cached presence map so the next boot scans the bus again
+ *
+ * Called by the BSP when a device from the cached map stops answering.
+ *
+ * @return
+ *      - ESP_OK                On success
+ */
+esp_err_t bsp_i2c_scan_invalidate(void);
+
 /**************************************************************************************************
  *
  * Button
@@ -163,6 +348,7 @@ esp_err_t bsp_register_button_callbacks(void);
  * @return
  *      - Button handle if successful
  *      - NULL if the button number is invalid or the button is not initialized
+ *      - NULL with CONFIG_BSP_GESTURE, see bsp/bsp_gesture.h
  */
 button_handle_t bsp_get_button_handle(uint8_t btn_num);
 
@@ -201,6 +387,46 @@ esp_err_t bsp_init_led_rgb(void);
 
 led_strip_handle_t bsp_get_led_rgb_handle(void);
 
+/**
+ * @brief Set an RGB LED pixel
+ *
+ * Writes through to the LED strip and keeps a BSP copy of the frame, which is
+ * retained across deep sleep. Call bsp_led_rgb_refresh() to show the frame.
+ *
+ * @param index Pixel index (0 to BSP_LED_RGB_PIXELS - 1)
+ * @param red Red component (0-255)
+ * @param green Green component (0-255)
+ * @param blue Blue component (0-255)
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Pixel index out of range
+ *      - ESP_ERR_INVALID_STATE RGB LED is not initialized
+ */
+esp_err_t bsp_led_rgb_set_pixel(uint32_t index, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * @brief Turn off all RGB LED pixels
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE RGB LED is not initialized
+ */
+esp_err_t bsp_led_rgb_clear(void);
+
+/**
+ * @brief Refresh the RGB LED strip
+ *
+ * Wraps `led_strip_refresh()` and holds the BSP LED PM lock while the frame
+ * is being shifted out.
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE RGB LED is not initialized
+ *      - ESP_FAIL              Refresh error
+ */
+esp_err_t bsp_led_rgb_refresh(void);
+
 /**************************************************************************************************
  *
  * Fuel Gauge
@@ -272,6 +498,85 @@ pcf8574_handle_t bsp_pcf8574_get_handle(void);
  */
 esp_err_t bsp_pcf8574_read_ios(uint8_t *data);
 
+/**
+ * @brief Get the number of PCF8574 expanders found by bsp_pcf8574_init()
+ *
+ * Up to CONFIG_BSP_PCF8574_MAX_DEVICES: the badge expander plus add-on boards.
+ *
+ * @return
+ *      - Number of expanders, 0 if none is initialized
+ */
+uint8_t bsp_pcf8574_get_count(void);
+
+/**
+ * @brief Get an expander handle by index
+ *
+ * @param index 0 for the badge expander (same as bsp_pcf8574_get_handle()),
+ *              1 .. bsp_pcf8574_get_count() - 1 for add-on expanders
+ *
+ * @return
+ *      - PCF8574 handle
+ *      - NULL if the index is out of range
+ */
+pcf8574_handle_t bsp_pcf8574_get_handle_at(uint8_t index);
+
+/**
+ * @brief Report input changes of all expanders from the shared INT line
+ *
+ * Creates a pcf8574 group on BSP_PCF8574_INT_IO with every expander: the INT
+ * line going LOW triggers one read per expander, and @p callback is called
+ * from the group task for each expander whose inputs changed. With
+ * CONFIG_BSP_PM_LIGHT_SLEEP the group also arms the line as light-sleep
+ * wake-up source.
+ *
+ * @param callback Change callback
+ * @param arg User argument passed to the callback
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_NOT_SUPPORTED The INT line is not wired
+ *      - ESP_ERR_INVALID_STATE Already started, or no expander is initialized
+ *      - ESP_FAIL              Read operation failed
+ */
+esp_err_t bsp_pcf8574_start_events(pcf8574_group_cb_t callback, void *arg);
+
+/**
+ * @brief Stop the change events started by bsp_pcf8574_start_events()
+ *
+ * @return
+ *      - ESP_OK                On success
+ */
+esp_err_t bsp_pcf8574_stop_events(void);
+
+/**
+ * @brief Start the output pattern engine of the badge expander
+ *
+ * Creates a pcf8574 pattern engine on the badge expander (index 0). Its
+ * outputs can then blink, dim or play sequences with pcf8574_pattern_set_*()
+ * at one port write per tick at most. Pins configured as inputs are rejected
+ * by the engine.
+ *
+ * @param config Engine configuration
+ * @param[out] ret_handle Engine handle, owned by the BSP
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Invalid configuration
+ *      - ESP_ERR_INVALID_STATE Already started, or the expander is not initialized
+ *      - ESP_ERR_NO_MEM        Allocation failed
+ */
+esp_err_t bsp_pcf8574_start_patterns(const pcf8574_pattern_config_t *config, pcf8574_pattern_handle_t *ret_handle);
+
+/**
+ * @brief Stop the pattern engine started by bsp_pcf8574_start_patterns()
+ *
+ * Pins keep the level of the last tick.
+ *
+ * @return
+ *      - ESP_OK                On success
+ */
+esp_err_t bsp_pcf8574_stop_patterns(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: double-buffered RGB LED frames with asynchronous refresh
+ *
+ * With CONFIG_BSP_LED_RGB_ASYNC the application renders into a BSP-owned back
+ * buffer and calls bsp_led_rgb_swap(). The swap copies the back buffer into the
+ * strip's front buffer and hands the transfer to a refresh task, so the caller
+ * can render the next frame while the RMT shifts out the current one.
+ *
+ * The front buffer is locked from the swap until the transfer has finished:
+ * the next swap, bsp_led_rgb_set_pixel(), bsp_led_rgb_clear() and
+ * bsp_led_rgb_refresh() wait for it, so a frame is never modified while it is
+ * being sent. The back buffer is not touched by the transfer and keeps the
+ * frame just swapped, so effects that build on the previous frame work as is.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED (or NULL) when
+ * CONFIG_BSP_LED_RGB_ASYNC is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "bsp/bsp_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_LED_RGB_ASYNC_TASK_STACK_SIZE   2048
+#define BSP_LED_RGB_WAIT_FOREVER            UINT32_MAX  /*!< Timeout value to wait without limit */
+
+/**
+ * @brief Transfer completion callback, called from the refresh task
+ *
+ * @param result Result of the transfer
+ * @param arg User argument
+ */
+typedef void (*bsp_led_rgb_done_cb_t)(esp_err_t result, void *arg);
+
+/**
+ * @brief Get the back buffer
+ *
+ * @return BSP_LED_RGB_PIXELS pixels to render into, NULL if not supported
+ */
+bsp_rgb_t *bsp_led_rgb_get_back_buffer(void);
+
+/**
+ * @brief Queue the back buffer for display
+ *
+ * Waits for the previous transfer to finish, copies the back buffer into the
+ * front buffer and returns while the new frame is sent.
+ *
+ * @param timeout_ms Longest wait for the previous transfer
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_TIMEOUT if the previous transfer did not finish in time
+ *      - ESP_ERR_INVALID_STATE RGB LED is not initialized
+ */
+esp_err_t bsp_led_rgb_swap(uint32_t timeout_ms);
+
+/**
+ * @brief Wait until the last queued frame has been sent
+ *
+ * @param timeout_ms Longest wait
+ * @return
+ *      - ESP_OK when no transfer is pending
+ *      - ESP_ERR_TIMEOUT if the transfer did not finish in time
+ */
+esp_err_t bsp_led_rgb_wait_done(uint32_t timeout_ms);
+
+/**
+ * @brief Set a callback for the end of every transfer queued by bsp_led_rgb_swap()
+ *
+ * @param callback Callback, NULL to remove
+ * @param arg User argument
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_led_rgb_set_done_callback(bsp_led_rgb_done_cb_t callback, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
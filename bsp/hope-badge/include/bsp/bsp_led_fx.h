@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: stock RGB LED effects
+ *
+ * Each effect renders one frame into a caller-owned bsp_rgb_t array from a
+ * time or step value, using the fixed-point primitives of bsp_color.h. The
+ * render functions keep no state, so the animation speed is independent of
+ * the frame rate and effects can be layered by rendering several into the
+ * same frame. bsp_led_rgb_show() sends a frame to the RGB LEDs.
+ *
+ * @code{c}
+ * bsp_rgb_t frame[BSP_LED_RGB_PIXELS];
+ * while (1) {
+ *     bsp_led_fx_rainbow(frame, BSP_LED_RGB_PIXELS, esp_log_timestamp(), 2000, 64);
+ *     bsp_led_rgb_show(frame, BSP_LED_RGB_PIXELS);
+ *     vTaskDelay(pdMS_TO_TICKS(16));
+ * }
+ * @endcode
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "bsp/bsp_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Send a frame to the RGB LEDs and refresh the strip
+ *
+ * @param frame Pixel colors
+ * @param count Number of pixels, at most BSP_LED_RGB_PIXELS
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if frame is NULL or count is out of range
+ *      - ESP_ERR_INVALID_STATE RGB LED is not initialized
+ */
+esp_err_t bsp_led_rgb_show(const bsp_rgb_t *frame, uint32_t count);
+
+/**
+ * @brief Ring chase: one lit pixel with a fading tail
+ *
+ * @param frame Frame to render into
+ * @param count Number of pixels
+ * @param step Head position, taken modulo @p count
+ * @param color Head color
+ * @param tail Number of trailing pixels, eased down to off
+ */
+void bsp_led_fx_chase(bsp_rgb_t *frame, uint32_t count, uint32_t step, bsp_rgb_t color, uint8_t tail);
+
+/**
+ * @brief Breathe: all pixels follow a sine brightness curve
+ *
+ * @param frame Frame to render into
+ * @param count Number of pixels
+ * @param time_ms Current time in milliseconds
+ * @param period_ms Breath period in milliseconds
+ * @param color Color at full brightness
+ */
+void bsp_led_fx_breathe(bsp_rgb_t *frame, uint32_t count, uint32_t time_ms, uint32_t period_ms, bsp_rgb_t color);
+
+/**
+ * @brief Rainbow: the hue circle spread over the pixels and rotating
+ *
+ * @param frame Frame to render into
+ * @param count Number of pixels
+ * @param time_ms Current time in milliseconds
+ * @param period_ms Time for one full rotation in milliseconds
+ * @param brightness Brightness, 0-255
+ */
+void bsp_led_fx_rainbow(bsp_rgb_t *frame, uint32_t count, uint32_t time_ms, uint32_t period_ms,
+                        uint8_t brightness);
+
+/**
+ * @brief Sparkle: random pixels flash and fade out
+ *
+ * Unlike the other effects this one fades the previous frame, so keep the
+ * frame between calls.
+ *
+ * @param frame Frame to render into, holding the previous frame
+ * @param count Number of pixels
+ * @param color Sparkle color
+ * @param chance Chance per call of a new sparkle, in 1/256
+ * @param fade Brightness kept per call, 255 for no fading
+ * @param[in,out] seed Random state, any non-zero start value
+ */
+void bsp_led_fx_sparkle(bsp_rgb_t *frame, uint32_t count, bsp_rgb_t color, uint8_t chance, uint8_t fade,
+                        uint32_t *seed);
+
+/**
+ * @brief Spectrum: pixels light up with the level of their band
+ *
+ * The levels are spread over the pixels, so each band drives a run of
+ * neighbouring pixels. Colors follow the palette from the first to the last
+ * band, typically with levels from bsp_audio_get_levels().
+ *
+ * @param frame Frame to render into
+ * @param count Number of pixels
+ * @param levels Level per band, 0-255
+ * @param num_levels Number of levels
+ * @param palette Band colors
+ */
+void bsp_led_fx_spectrum(bsp_rgb_t *frame, uint32_t count, const uint8_t *levels, uint32_t num_levels,
+                         const bsp_palette16_t *palette);
+
+#ifdef __cplusplus
+}
+#endif
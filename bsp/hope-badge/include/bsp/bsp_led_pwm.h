@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: LEDC-driven status LED
+ *
+ * With CONFIG_BSP_LED_PWM, bsp_led_init() routes BSP_LED_IO to an LEDC channel
+ * instead of configuring it as a plain GPIO. Brightness, fades and blinking then
+ * run in the LEDC peripheral without CPU involvement. The LEDC timer is clocked
+ * from RC_FAST and kept alive in light sleep, so the LED keeps animating while
+ * the CPU sleeps and is unaffected by DFS.
+ *
+ * The output is inverted according to CONFIG_BSP_LED_ACTIVE_LEVEL, brightness 0
+ * is always off. Each call replaces the pattern that was running.
+ *
+ * Brightness levels are scaled by the BSP_SETTING_LED_BRIGHTNESS setting
+ * (bsp_settings.h) when the call is made; bsp_led_blink() always switches
+ * between off and full on.
+ *
+ * While LEDC owns the pin, bsp_gpio_set_level() and the fast-path GPIO
+ * accessors have no visible effect on the LED.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED when CONFIG_BSP_LED_PWM is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest hardware blink period; the LEDC timer cannot divide RC_FAST below 2 Hz */
+#define BSP_LED_BLINK_PERIOD_MAX_MS     500
+
+/**
+ * @brief Set the LED brightness
+ *
+ * @param brightness 0 (off) to 255 (BSP_SETTING_LED_BRIGHTNESS, full by default), gamma corrected
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the LED is not initialized
+ */
+esp_err_t bsp_led_set_brightness(uint8_t brightness);
+
+/**
+ * @brief Fade from the current to a new brightness in hardware
+ *
+ * Returns immediately, the fade runs in the LEDC peripheral.
+ *
+ * @param brightness Target brightness, 0 to 255
+ * @param time_ms Fade duration in milliseconds
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the LED is not initialized
+ */
+esp_err_t bsp_led_fade_to(uint8_t brightness, uint32_t time_ms);
+
+/**
+ * @brief Blink the LED in hardware
+ *
+ * The LEDC timer is slowed down to the blink rate, so the period is rounded to
+ * a whole number of Hz (500, 333, 250, 200 ... ms).
+ *
+ * @param period_ms Blink period, 1 to BSP_LED_BLINK_PERIOD_MAX_MS
+ * @param on_percent Part of the period the LED is on, 1 to 99
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is out of range
+ *      - ESP_ERR_INVALID_STATE if the LED is not initialized
+ */
+esp_err_t bsp_led_blink(uint32_t period_ms, uint8_t on_percent);
+
+/**
+ * @brief Breathe: fade up and down continuously
+ *
+ * Each ramp runs in hardware. The LEDC on the ESP32-C3 can only ramp in one
+ * direction, so the LEDC fade-end interrupt starts the next ramp, deferred to
+ * the timer service task: two short wake-ups per breath.
+ *
+ * @param period_ms Duration of one full breath (up and down), at least 100 ms
+ * @param max_brightness Peak brightness, 1 to 255
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is out of range
+ *      - ESP_ERR_INVALID_STATE if the LED is not initialized
+ */
+esp_err_t bsp_led_breathe(uint32_t period_ms, uint8_t max_brightness);
+
+#ifdef __cplusplus
+}
+#endif
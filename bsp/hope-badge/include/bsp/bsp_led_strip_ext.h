@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: long external WS2812 strips with streaming encoding
+ *
+ * With CONFIG_BSP_LED_STRIP_EXT an external strip of up to
+ * CONFIG_BSP_LED_STRIP_EXT_PIXELS_NUM pixels is driven on
+ * CONFIG_BSP_LED_STRIP_EXT_GPIO, next to the on-board ring.
+ *
+ * The strip has no pixel buffer. During a refresh the RMT encoder asks the
+ * application for each pixel just before it is sent, one RMT memory half at
+ * a time. RAM use is the same for 10 or 1000 pixels. The pixel callback can
+ * compute colors (e.g. with bsp_color.h), look them up in a palette from a
+ * one-byte-per-pixel index buffer, or read them from an application buffer.
+ *
+ * The pixel callback runs in the RMT interrupt: it must be short (a pixel is
+ * on the wire for 30 us), must not block, and must be in IRAM together with
+ * everything it calls, since the strip selects CONFIG_RMT_ISR_IRAM_SAFE. The
+ * channel takes two RMT memory blocks (one of the two TX blocks left after the
+ * on-board ring, plus one RX block) or uses DMA where available. State it reads
+ * should not change during bsp_led_strip_ext_refresh(), or the frame tears.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED when CONFIG_BSP_LED_STRIP_EXT
+ * is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "bsp/bsp_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Pixel source, called from the RMT interrupt
+ *
+ * @param index Pixel index, 0 is the pixel nearest the badge
+ * @param arg User argument
+ * @return Color of the pixel
+ */
+typedef bsp_rgb_t (*bsp_led_strip_ext_pixel_cb_t)(uint32_t index, void *arg);
+
+/**
+ * @brief Set up the RMT channel for the external strip
+ *
+ * @param pixel_cb Pixel source
+ * @param arg User argument passed to @p pixel_cb
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if pixel_cb is NULL or the GPIO is not configured
+ *      - ESP_ERR_INVALID_STATE if already initialized
+ *      - Other errors from the RMT driver
+ */
+esp_err_t bsp_led_strip_ext_init(bsp_led_strip_ext_pixel_cb_t pixel_cb, void *arg);
+
+/**
+ * @brief Release the RMT channel
+ *
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_led_strip_ext_deinit(void);
+
+/**
+ * @brief Send one frame and wait until it is latched
+ *
+ * @param count Number of pixels to send, at most CONFIG_BSP_LED_STRIP_EXT_PIXELS_NUM
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if count is out of range
+ *      - ESP_ERR_INVALID_STATE if the strip is not initialized
+ *      - ESP_ERR_TIMEOUT if the transfer did not finish
+ */
+esp_err_t bsp_led_strip_ext_refresh(uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: brownout-aware load shedding
+ *
+ * The RGB LED ring at full brightness and the vibration motor together draw
+ * enough current to pull a tired cell below the brownout level. With
+ * CONFIG_BSP_LOAD_SHED the BSP estimates what its consumers draw (the LED
+ * frame content, the motor while driven, a fixed base load) and periodically
+ * samples the cell voltage. Through the cell and wiring resistance
+ * (CONFIG_BSP_LOAD_CELL_MOHM) it derives the unloaded cell voltage, follows
+ * its trend, and computes the current the cell can deliver without sagging
+ * below CONFIG_BSP_LOAD_MIN_MV:
+ *
+ *     budget_mA = (predicted unloaded mV - CONFIG_BSP_LOAD_MIN_MV) / cell ohms
+ *
+ * Loads are shed in order as the budget shrinks:
+ *  - BSP_LOAD_REDUCED: RGB LED frames are dimmed so their estimated current
+ *    fits the budget left after the base load and the motor.
+ *  - BSP_LOAD_CRITICAL: the motor is held off (vibramotor_set_hold()) and the
+ *    LEDs get what is left.
+ *
+ * Loads the BSP does not drive, such as the radio, follow the level through
+ * the callback. bsp_load_get_budget_ma() lets them size their own bursts.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED (or BSP_LOAD_NORMAL and 0)
+ * when CONFIG_BSP_LOAD_SHED is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load shedding level, from no shedding to the strongest
+ */
+typedef enum {
+    BSP_LOAD_NORMAL = 0,        /*!< Budget covers all BSP loads at full power */
+    BSP_LOAD_REDUCED,           /*!< RGB LEDs dimmed */
+    BSP_LOAD_CRITICAL,          /*!< Haptics held off, RGB LEDs dimmed */
+} bsp_load_level_t;
+
+/**
+ * @brief Level change callback, called from the BSP worker task
+ *
+ * The worker also writes settings and the event log: keep the callback short
+ * and do not block in it.
+ *
+ * @param level New level
+ * @param budget_ma Current budget in mA
+ * @param arg User argument
+ */
+typedef void (*bsp_load_cb_t)(bsp_load_level_t level, uint32_t budget_ma, void *arg);
+
+/**
+ * @brief Start sampling the battery every CONFIG_BSP_LOAD_SAMPLE_PERIOD_MS
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the battery voltage cannot be read
+ *      - ESP_ERR_NO_MEM if the timer cannot be created
+ */
+esp_err_t bsp_load_start(void);
+
+/**
+ * @brief Stop sampling and lift all shedding
+ *
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_load_stop(void);
+
+/**
+ * @brief Get the current level
+ *
+ * @return Level, BSP_LOAD_NORMAL while stopped
+ */
+bsp_load_level_t bsp_load_get_level(void);
+
+/**
+ * @brief Get the current budget
+ *
+ * @return Current the cell can deliver above CONFIG_BSP_LOAD_MIN_MV, in mA; 0 while stopped
+ */
+uint32_t bsp_load_get_budget_ma(void);
+
+/**
+ * @brief Get the estimated current of the BSP loads
+ *
+ * @return Base load plus the last RGB LED frame and the motor if driven, in mA
+ */
+uint32_t bsp_load_get_estimate_ma(void);
+
+/**
+ * @brief Register a level change callback, replacing the previous one
+ *
+ * @param cb Callback, NULL to remove
+ * @param arg User argument
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_load_set_callback(bsp_load_cb_t cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: Runtime metrics
+ *
+ * Fixed-slot counters, gauges and latency histograms fed by the BSP drivers.
+ * Updates are relaxed atomic operations, safe from any task. The PCF8574 and
+ * vibramotor counters are kept by their components and copied in when the
+ * metrics are read.
+ *
+ * All update functions are no-ops when CONFIG_BSP_METRICS is not set.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* X(id, name) */
+#define BSP_METRICS_COUNTERS(X) \
+    X(I2C_SCANS,            "i2c.scans") \
+    X(LED_RGB_REFRESHES,    "led_rgb.refreshes") \
+    X(LED_RGB_ERRORS,       "led_rgb.errors") \
+    X(BUTTON_EVENTS,        "button.events") \
+    X(GESTURES,             "gesture.matches") \
+    X(FUEL_GAUGE_READS,     "fuel_gauge.reads") \
+    X(FUEL_GAUGE_ERRORS,    "fuel_gauge.errors") \
+    X(PCF8574_READS,        "pcf8574.reads") \
+    X(PCF8574_WRITES,       "pcf8574.writes") \
+    X(PCF8574_ERRORS,       "pcf8574.errors") \
+    X(PCF8574_INTERRUPTS,   "pcf8574.interrupts") \
+    X(VIBRAMOTOR_RUNS,      "vibramotor.runs") \
+    X(VIBRAMOTOR_STOPS,     "vibramotor.stops") \
+    X(VIBRAMOTOR_ON_MS,     "vibramotor.on_ms") \
+    X(AUDIO_FRAMES,         "audio.frames") \
+    X(AUDIO_OVERFLOWS,      "audio.overflows") \
+    X(SETTINGS_COMMITS,     "settings.commits") \
+    X(SETTINGS_WRITES,      "settings.writes") \
+    X(SCHED_RUNS,           "sched.runs")
+
+#define BSP_METRICS_GAUGES(X) \
+    X(INIT_US,              "init.us") \
+    X(BATTERY_MV,           "battery.mv") \
+    X(BATTERY_PCT,          "battery.pct") \
+    X(HEAP_FREE,            "heap.free") \
+    X(HEAP_MIN_FREE,        "heap.min_free") \
+    X(HEAP_LARGEST,         "heap.largest") \
+    X(STACK_MIN_FREE,       "stack.min_free") \
+    X(LOAD_BUDGET_MA,       "load.budget_ma") \
+    X(LOAD_ESTIMATE_MA,     "load.estimate_ma")
+
+#define BSP_METRICS_HISTOGRAMS(X) \
+    X(I2C_SCAN_US,          "i2c.scan_us") \
+    X(LED_RGB_REFRESH_US,   "led_rgb.refresh_us") \
+    X(FUEL_GAUGE_READ_US,   "fuel_gauge.read_us") \
+    X(PCF8574_READ_US,      "pcf8574.read_us") \
+    X(AUDIO_ANALYZE_US,     "audio.analyze_us") \
+    X(SCHED_RUN_US,         "sched.run_us") \
+    X(SCHED_LATE_US,        "sched.late_us")
+
+#define BSP_METRIC_ENUM(id, name) BSP_METRIC_##id,
+
+/**
+ * @brief Metric slots: counters first, then gauges, then histograms
+ */
+typedef enum {
+    BSP_METRICS_COUNTERS(BSP_METRIC_ENUM)
+    BSP_METRIC_GAUGE_FIRST,
+    BSP_METRIC_GAUGE_BASE = BSP_METRIC_GAUGE_FIRST - 1,
+    BSP_METRICS_GAUGES(BSP_METRIC_ENUM)
+    BSP_METRIC_HISTOGRAM_FIRST,
+    BSP_METRIC_HISTOGRAM_BASE = BSP_METRIC_HISTOGRAM_FIRST - 1,
+    BSP_METRICS_HISTOGRAMS(BSP_METRIC_ENUM)
+    BSP_METRIC_MAX,
+} bsp_metric_id_t;
+
+#undef BSP_METRIC_ENUM
+
+/**
+ * @brief Histogram buckets: < 16 us, < 64 us, < 256 us, ... (x4 per bucket), last one open-ended
+ */
+#define BSP_METRICS_HIST_BUCKETS    8
+
+#define BSP_METRICS_SNAPSHOT_MAGIC      0x4D42  /* "BM" */
+#define BSP_METRICS_SNAPSHOT_VERSION    1
+
+/**
+ * @brief Histogram contents
+ */
+typedef struct {
+    uint32_t count;                                 /*!< Number of samples */
+    uint32_t sum_us;                                /*!< Sum of all samples */
+    uint32_t max_us;                                /*!< Largest sample */
+    uint32_t buckets[BSP_METRICS_HIST_BUCKETS];     /*!< Samples per bucket */
+} bsp_metrics_hist_t;
+
+/**
+ * @brief Add to a counter
+ */
+void bsp_metrics_add(bsp_metric_id_t id, uint32_t n);
+
+/**
+ * @brief Increment a counter by one
+ */
+static inline void bsp_metrics_inc(bsp_metric_id_t id)
+{
+    bsp_metrics_add(id, 1);
+}
+
+/**
+ * @brief Set a gauge (or overwrite a counter)
+ */
+void bsp_metrics_set(bsp_metric_id_t id, int32_t value);
+
+/**
+ * @brief Record a duration in a histogram
+ */
+void bsp_metrics_record_us(bsp_metric_id_t id, uint32_t us);
+
+/**
+ * @brief Get the value of a counter or gauge
+ */
+int64_t bsp_metrics_get(bsp_metric_id_t id);
+
+/**
+ * @brief Copy a histogram
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if id is not a histogram or out is NULL
+ *      - ESP_ERR_NOT_SUPPORTED if CONFIG_BSP_METRICS is not set
+ */
+esp_err_t bsp_metrics_get_hist(bsp_metric_id_t id, bsp_metrics_hist_t *out);
+
+/**
+ * @brief Get the name of a metric, e.g. "led_rgb.refreshes"
+ */
+const char *bsp_metrics_name(bsp_metric_id_t id);
+
+/**
+ * @brief Clear all metrics
+ *
+ * The PCF8574 and vibramotor metrics are reported relative to the reset; the
+ * counters kept by those components (pcf8574_get_stats(), vibramotor_get_stats())
+ * are left unchanged.
+ */
+void bsp_metrics_reset(void);
+
+/**
+ * @brief Log all metrics
+ */
+void bsp_metrics_print(void);
+
+/**
+ * @brief Write a compact little-endian snapshot of all metrics
+ *
+ * Layout: u16 magic, u8 version, u8 metric count, u64 uptime in us, then per metric
+ * u8 id, u8 type (0 counter, 1 gauge, 2 histogram) and either a u32 value or
+ * the histogram as u32 count, sum_us, max_us and BSP_METRICS_HIST_BUCKETS buckets.
+ *
+ * @param buf Output buffer, may be NULL to query the size
+ * @param len Size of buf
+ * @return Number of bytes needed; nothing is written if it is larger than len
+ */
+size_t bsp_metrics_snapshot(uint8_t *buf, size_t len);
+
+/**
+ * @brief Register the "bsp_metrics" console command
+ *
+ * "bsp_metrics" logs all metrics, "bsp_metrics -b" prints the binary snapshot
+ * as one hex line prefixed with "BSPM:", "bsp_metrics -r" clears them.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_SUPPORTED if CONFIG_BSP_METRICS is not set
+ */
+esp_err_t bsp_metrics_register_console(void);
+
+#ifdef __cplusplus
+}
+#endif
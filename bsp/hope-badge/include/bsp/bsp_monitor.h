@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: Stack and heap watermark monitor
+ *
+ * Periodically samples the stack high-water mark of registered tasks and the
+ * heap (free, minimum free, largest free block), logs a warning when headroom
+ * drops below the configured thresholds and publishes the values as metrics.
+ *
+ * The BSP-owned tasks (vibramotor, deferred logging) are registered by bsp_monitor_start().
+ * The monitor is set up by bsp_init(); before that the functions return
+ * ESP_ERR_INVALID_STATE. The periodic sample runs in the esp_timer task and is
+ * skipped for a period in which a task is using the monitor.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED when CONFIG_BSP_MONITOR is not set.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register a task to be monitored
+ *
+ * A task must be removed with bsp_monitor_remove_task() before it is deleted.
+ *
+ * @param task Task handle
+ * @param stack_size Stack size the task was created with, in bytes (0 if unknown)
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if task is NULL
+ *      - ESP_ERR_NO_MEM if CONFIG_BSP_MONITOR_MAX_TASKS tasks are already registered
+ */
+esp_err_t bsp_monitor_add_task(TaskHandle_t task, uint32_t stack_size);
+
+/**
+ * @brief Stop monitoring a task
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the task is not registered
+ */
+esp_err_t bsp_monitor_remove_task(TaskHandle_t task);
+
+/**
+ * @brief Start sampling every @p period_ms milliseconds
+ */
+esp_err_t bsp_monitor_start(uint32_t period_ms);
+
+/**
+ * @brief Stop periodic sampling
+ */
+esp_err_t bsp_monitor_stop(void);
+
+/**
+ * @brief Take one sample now
+ */
+esp_err_t bsp_monitor_sample(void);
+
+/**
+ * @brief Log the lowest stack headroom of every registered task and the heap statistics
+ */
+esp_err_t bsp_monitor_print(void);
+
+#ifdef __cplusplus
+}
+#endif
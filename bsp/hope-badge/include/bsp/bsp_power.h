@@ -0,0 +1,120 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: Power management
+ *
+ * Configures dynamic frequency scaling (DFS) and automatic light sleep, enables
+ * GPIO wake-up from light sleep and provides PM locks that BSP drivers hold
+ * only while a peripheral is busy.
+ *
+ * The PM functions are no-ops returning ESP_OK when CONFIG_BSP_PM_ENABLE is not set.
+ *
+ * With CONFIG_BSP_DEEP_SLEEP_RETENTION, bsp_deep_sleep_start() stores the
+ * discovered BSP state in RTC memory and the next bsp_init() restores it
+ * instead of probing the hardware again.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief PM lock owners
+ *
+ * Each consumer has its own reference-counted lock so `esp_pm_dump_locks()`
+ * shows which subsystem keeps the chip awake.
+ */
+typedef enum {
+    BSP_PM_LOCK_LED = 0,    /*!< RGB LED refresh in progress */
+    BSP_PM_LOCK_I2C,        /*!< I2C transfer in progress */
+    BSP_PM_LOCK_MAX,
+} bsp_pm_lock_t;
+
+/**
+ * @brief Initialize BSP power management
+ *
+ * Creates the PM locks, configures DFS and automatic light sleep and enables
+ * GPIO wake-up. The pins are armed by their owners: buttons are created with
+ * `enable_power_save` (or armed by bsp_gesture), and the PCF8574 INT line is
+ * armed by the expander group of bsp_pcf8574_start_events(). The MAX17048
+ * ALRT line is not a light-sleep wake-up source.
+ *
+ * @note The vibramotor component holds its own PM lock while a pattern is running.
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_FAIL              PM configuration error
+ */
+esp_err_t bsp_power_init(void);
+
+/**
+ * @brief Release the BSP PM locks
+ *
+ * @return
+ *      - ESP_OK                On success
+ */
+esp_err_t bsp_power_deinit(void);
+
+/**
+ * @brief Acquire a BSP PM lock (prevents light sleep)
+ *
+ * The locks are ESP_PM_NO_LIGHT_SLEEP locks: DFS may still lower the CPU
+ * frequency while one is held. Locks are reference counted; every acquire
+ * must be paired with a release.
+ *
+ * @param lock Lock owner
+ *
+ * @return
+ *      - ESP_OK                On success (or if power management is not initialized)
+ *      - ESP_ERR_INVALID_ARG   Invalid lock
+ */
+esp_err_t bsp_power_lock_acquire(bsp_pm_lock_t lock);
+
+/**
+ * @brief Release a BSP PM lock
+ *
+ * @param lock Lock owner
+ *
+ * @return
+ *      - ESP_OK                On success (or if power management is not initialized)
+ *      - ESP_ERR_INVALID_ARG   Invalid lock
+ */
+esp_err_t bsp_power_lock_release(bsp_pm_lock_t lock);
+
+/**
+ * @brief Enter deep sleep, retaining the BSP state for a fast resume
+ *
+ * Saves the expander address, its output/direction state and the last RGB
+ * LED frame to RTC memory, arms the buttons, the PCF8574 INT and the
+ * MAX17048 ALRT lines as wake-up sources and enters deep sleep.
+ *
+ * @note On the ESP32-C3 only GPIO0-5 can wake the chip from deep sleep;
+ *       lines wired to other GPIOs are skipped.
+ *
+ * @param wakeup_time_us Timer wake-up in microseconds, 0 to wake on GPIO only
+ *
+ * @return Does not return on success
+ *      - ESP_ERR_INVALID_STATE No wake-up source available
+ *      - ESP_FAIL              Wake-up source configuration error
+ */
+esp_err_t bsp_deep_sleep_start(uint64_t wakeup_time_us);
+
+/**
+ * @brief Check whether this boot is a resume from bsp_deep_sleep_start()
+ *
+ * @return
+ *      - true if the retained BSP state is valid and will be used by bsp_init()
+ *      - false on a cold boot or if retention is disabled
+ */
+bool bsp_deep_sleep_is_resume(void);
+
+#ifdef __cplusplus
+}
+#endif
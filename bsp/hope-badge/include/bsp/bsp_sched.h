@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: cooperative job scheduler
+ *
+ * With CONFIG_BSP_SCHED one task runs application jobs as run-to-completion
+ * callbacks, in place of one FreeRTOS task (and stack) per periodic activity.
+ * A job is a caller-owned bsp_sched_job_t that can be
+ *  - run once after a delay (bsp_sched_after()),
+ *  - run periodically (bsp_sched_every()); periods are kept from the previous
+ *    deadline, not from the end of the callback, so they do not drift,
+ *  - posted as an event to run as soon as possible (bsp_sched_post(), also
+ *    from interrupts and from other tasks such as the gesture or PCF8574
+ *    group callbacks).
+ *
+ * Armed jobs are kept in a list ordered by deadline. The task sleeps until
+ * the earliest deadline or a post, so an idle scheduler causes no wake-ups.
+ * Posted jobs run before due timers are checked again, in posting order;
+ * posting a job that is already pending runs it once.
+ *
+ * Callbacks share the scheduler stack (CONFIG_BSP_SCHED_TASK_STACK_SIZE) and
+ * must not block: a callback that waits delays every other job. Run times
+ * go to the sched.run_us metric and lateness to sched.late_us.
+ *
+ * All functions return ESP_ERR_NOT_SUPPORTED when CONFIG_BSP_SCHED is not set.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bsp_sched_job bsp_sched_job_t;
+
+/**
+ * @brief Job callback, called from the scheduler task
+ *
+ * @param job The job, may be re-armed or cancelled from here
+ * @param arg User argument of the job
+ */
+typedef void (*bsp_sched_cb_t)(bsp_sched_job_t *job, void *arg);
+
+/**
+ * @brief Job, owned by the caller; initialize with BSP_SCHED_JOB_INIT() and treat the rest as private
+ */
+struct bsp_sched_job {
+    bsp_sched_cb_t callback;
+    void *arg;
+    const char *name;
+    /* Private */
+    int64_t deadline_us;
+    int64_t period_us;
+    bool armed;
+    bool pending;
+    bsp_sched_job_t *next_timer;
+    bsp_sched_job_t *next_ready;
+};
+
+#define BSP_SCHED_JOB_INIT(cb, user_arg, job_name) {.callback = (cb), .arg = (user_arg), .name = (job_name)}
+
+/**
+ * @brief Scheduler configuration
+ */
+typedef struct {
+    uint8_t task_priority;      /*!< Scheduler task priority */
+} bsp_sched_config_t;
+
+/**
+ * @brief Start the scheduler task
+ *
+ * Jobs may be armed before the start; they run once the task is up.
+ *
+ * @param config Scheduler configuration
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config is NULL
+ *      - ESP_ERR_INVALID_STATE if already running
+ *      - ESP_ERR_NO_MEM if the task cannot be created
+ */
+esp_err_t bsp_sched_start(const bsp_sched_config_t *config);
+
+/**
+ * @brief Stop the scheduler task after the running callback returns
+ *
+ * Armed and posted jobs are kept and continue after the next start.
+ * From a job it returns at once and the task exits when the job returns;
+ * bsp_sched_start() returns ESP_ERR_INVALID_STATE until it has.
+ *
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t bsp_sched_stop(void);
+
+/**
+ * @brief Run a job once, delay_ms from now; replaces an earlier timing of the job
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if job or its callback is NULL
+ */
+esp_err_t bsp_sched_after(bsp_sched_job_t *job, uint32_t delay_ms);
+
+/**
+ * @brief Run a job every period_ms, first period_ms from now; replaces an earlier timing of the job
+ *
+ * Periods missed while other callbacks ran are skipped, not caught up.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if job or its callback is NULL or period_ms is 0
+ */
+esp_err_t bsp_sched_every(bsp_sched_job_t *job, uint32_t period_ms);
+
+/**
+ * @brief Run a job as soon as possible, independent of its timing
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if job or its callback is NULL
+ */
+esp_err_t bsp_sched_post(bsp_sched_job_t *job);
+
+/**
+ * @brief bsp_sched_post() for interrupt handlers
+ *
+ * @param job Job to post
+ * @param[out] woken Set to pdTRUE if a context switch is needed at the end of the ISR
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if job or its callback is NULL
+ */
+esp_err_t bsp_sched_post_from_isr(bsp_sched_job_t *job, BaseType_t *woken);
+
+/**
+ * @brief Disarm a job and drop a pending post
+ *
+ * A callback already running in the scheduler task completes.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if job is NULL
+ */
+esp_err_t bsp_sched_cancel(bsp_sched_job_t *job);
+
+/**
+ * @brief Get the scheduler task, e.g. for bsp_monitor_add_task()
+ *
+ * @return Task handle, NULL while stopped
+ */
+TaskHandle_t bsp_sched_get_task_handle(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: persistent settings
+ *
+ * Typed, range-checked settings kept in RAM and backed by NVS. bsp_init()
+ * loads them once; bsp_settings_get() is a plain memory read afterwards.
+ *
+ * The application must call nvs_flash_init() before bsp_init() for the
+ * settings to persist; without it they run on defaults in RAM.
+ *
+ * bsp_settings_set() only updates the RAM copy and arms a commit timer that
+ * is restarted by every further change (CONFIG_BSP_SETTINGS_COMMIT_DELAY_MS),
+ * but never postponed beyond CONFIG_BSP_SETTINGS_COMMIT_MAX_DELAY_MS after the
+ * first unsaved change. The commit runs in the low-priority BSP worker task,
+ * not in the esp_timer task. It writes all changed settings with a single
+ * nvs_commit() and skips values that are back to what flash holds, so a user
+ * scrolling through brightness levels costs one write, not one per step.
+ * bsp_deep_sleep_start() commits pending changes before powering down.
+ *
+ * Without CONFIG_BSP_SETTINGS, bsp_settings_get() returns the defaults and the
+ * other functions return ESP_ERR_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * X(id, key, default, min, max), key is the NVS key (at most 15 characters).
+ * LED_BRIGHTNESS scales the levels of bsp_led_set_brightness(), fade_to()
+ * and breathe(), from the next call on. LED_RGB_BRIGHTNESS scales every RGB
+ * LED frame, from the next refresh on. A PCF8574 address of 0 means the
+ * address found by probing; a stored address that no longer answers falls
+ * back to probing as well.
+ */
+#define BSP_SETTINGS_LIST(X) \
+    X(LED_BRIGHTNESS,       "led_bright",   255,    0,      255) \
+    X(LED_RGB_BRIGHTNESS,   "rgb_bright",   255,    0,      255) \
+    X(PCF8574_ADDR,         "pcf_addr",     0,      0,      0x7F)
+
+#define BSP_SETTING_ENUM(id, key, def, min, max) BSP_SETTING_##id,
+
+/**
+ * @brief Setting identifiers
+ */
+typedef enum {
+    BSP_SETTINGS_LIST(BSP_SETTING_ENUM)
+    BSP_SETTING_MAX,
+} bsp_setting_id_t;
+
+#undef BSP_SETTING_ENUM
+
+/**
+ * @brief Load all settings from NVS into RAM
+ *
+ * Settings missing from NVS or out of range take their default. Called by
+ * bsp_init(); calling it again is a no-op. NVS is not initialized here.
+ *
+ * @return
+ *      - ESP_OK on success, also when NVS is not available (defaults are used)
+ */
+esp_err_t bsp_settings_init(void);
+
+/**
+ * @brief Get a setting
+ *
+ * @param id Setting
+ * @return Current value, 0 for an invalid id
+ */
+int32_t bsp_settings_get(bsp_setting_id_t id);
+
+/**
+ * @brief Change a setting, persisted by the next commit
+ *
+ * @param id Setting
+ * @param value New value
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG for an invalid id or a value out of range
+ *      - ESP_ERR_INVALID_STATE if bsp_settings_init() has not run
+ */
+esp_err_t bsp_settings_set(bsp_setting_id_t id, int32_t value);
+
+/**
+ * @brief Restore the default of a setting
+ *
+ * @param id Setting
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG for an invalid id
+ *      - ESP_ERR_INVALID_STATE if bsp_settings_init() has not run
+ */
+esp_err_t bsp_settings_reset(bsp_setting_id_t id);
+
+/**
+ * @brief Write pending changes to NVS now
+ *
+ * @return
+ *      - ESP_OK on success or if nothing is pending
+ *      - ESP_ERR_INVALID_STATE if bsp_settings_init() has not run
+ *      - Other errors from NVS, the changes stay pending
+ */
+esp_err_t bsp_settings_commit(void);
+
+/**
+ * @brief Get the NVS key of a setting
+ *
+ * @param id Setting
+ * @return Key, or NULL for an invalid id
+ */
+const char *bsp_settings_key(bsp_setting_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
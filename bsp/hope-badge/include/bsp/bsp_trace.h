@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief HOPE Badge BSP: Event trace
+ *
+ * Compact timestamped events (I2C transfers, RGB LED refresh, vibramotor steps,
+ * buttons, I/O expander interrupts) written into a lock-free ring. The ring is
+ * drained as packets, either printed as hex lines on the console or streamed
+ * with app_trace over USB-JTAG, and turned into a timeline on the host with
+ * tools/bsp_trace_decode.py.
+ *
+ * Recording starts with bsp_trace_start(). When CONFIG_BSP_TRACE is not set,
+ * bsp_trace_event() is an empty inline function and the rest return
+ * ESP_ERR_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Trace event types
+ */
+typedef enum {
+    BSP_TRACE_I2C_START = 1,        /*!< arg0: 7-bit address (0 for a bus scan) */
+    BSP_TRACE_I2C_DONE,             /*!< arg0: address, arg1: esp_err_t */
+    BSP_TRACE_LED_REFRESH_START,
+    BSP_TRACE_LED_REFRESH_DONE,     /*!< arg1: esp_err_t */
+    BSP_TRACE_HAPTIC_ON,
+    BSP_TRACE_HAPTIC_OFF,
+    BSP_TRACE_BUTTON_DOWN,          /*!< arg0: button index */
+    BSP_TRACE_BUTTON_UP,            /*!< arg0: button index */
+    BSP_TRACE_EXPANDER_INT,         /*!< arg0: expander address */
+    BSP_TRACE_USER = 0x80,          /*!< First application-defined event */
+} bsp_trace_event_id_t;
+
+/**
+ * @brief One trace record (8 bytes, little-endian on the wire)
+ */
+typedef struct {
+    uint32_t timestamp_us;          /*!< Low 32 bits of esp_timer_get_time() */
+    uint8_t event;                  /*!< bsp_trace_event_id_t */
+    uint8_t arg0;
+    uint16_t arg1;
+} bsp_trace_record_t;
+
+#define BSP_TRACE_PACKET_MAGIC      0x5442  /* "BT" */
+#define BSP_TRACE_PACKET_VERSION    1
+
+#if CONFIG_BSP_TRACE
+/**
+ * @brief Record an event
+ *
+ * Safe from tasks and ISRs. Does nothing unless tracing is started.
+ */
+void bsp_trace_event(uint8_t event, uint8_t arg0, uint16_t arg1);
+#else
+static inline void bsp_trace_event(uint8_t event, uint8_t arg0, uint16_t arg1)
+{
+}
+#endif
+
+/**
+ * @brief Start recording events
+ */
+esp_err_t bsp_trace_start(void);
+
+/**
+ * @brief Stop recording events; recorded events can still be read
+ */
+esp_err_t bsp_trace_stop(void);
+
+/**
+ * @brief Drain recorded events into a packet
+ *
+ * Packet layout: u16 magic, u8 version, u8 record count, u32 records lost
+ * since the previous packet, then the records.
+ *
+ * @param buf Output buffer
+ * @param len Size of buf, at least 8 + sizeof(bsp_trace_record_t)
+ * @return Packet length in bytes, 0 if there was nothing to drain
+ */
+size_t bsp_trace_read_packet(uint8_t *buf, size_t len);
+
+/**
+ * @brief Print all recorded events as "BSPT:" hex lines on stdout
+ */
+esp_err_t bsp_trace_dump(void);
+
+/**
+ * @brief Send all recorded events over app_trace (USB-JTAG)
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_SUPPORTED if CONFIG_BSP_TRACE_APPTRACE is not set
+ *      - Error returned by esp_apptrace_write() otherwise
+ */
+esp_err_t bsp_trace_flush_apptrace(uint32_t timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
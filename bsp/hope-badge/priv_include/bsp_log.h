@@ -0,0 +1,51 @@
+/*
+ * Deferred logging for BSP hot paths.
+ *
+ * With CONFIG_BSP_LOG_DEFERRED, BSP_LOGx_FAST() pushes a small record (level, tag,
+ * format string pointer, one int argument and an error code) into a lock-free ring
+ * and returns. A low-priority task formats the records and rate-limits repeated
+ * messages from the same call site. Otherwise the message is written immediately.
+ *
+ * The format may use at most one int conversion. A non-ESP_OK error code is
+ * appended as ": <esp_err_to_name(err)>". Not for use from ISRs.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_LOG_TASK_STACK_SIZE         3072
+
+#define BSP_LOGE_FAST(fmt, err, arg)    bsp_log_fast(ESP_LOG_ERROR, TAG, fmt, err, arg)
+#define BSP_LOGW_FAST(fmt, err, arg)    bsp_log_fast(ESP_LOG_WARN, TAG, fmt, err, arg)
+
+/**
+ * @brief Queue a log record, see BSP_LOGE_FAST()
+ *
+ * @param fmt Format string; must be a string literal (only the pointer is stored)
+ */
+void bsp_log_fast(esp_log_level_t level, const char *tag, const char *fmt, esp_err_t err, int arg);
+
+/**
+ * @brief Start the log task
+ *
+ * Records logged before this are written immediately.
+ */
+esp_err_t bsp_log_init(void);
+
+/**
+ * @brief Get the log task handle, NULL if it is not running
+ */
+TaskHandle_t bsp_log_get_task_handle(void);
+
+#ifdef __cplusplus
+}
+#endif
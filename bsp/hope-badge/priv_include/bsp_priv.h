@@ -0,0 +1,171 @@
+/*
+ * Internal interfaces shared between the BSP source files.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_color.h"
+#include "bsp/bsp_led_async.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_WORKER_TASK_STACK_SIZE  3072
+
+/**
+ * @brief Work run by the BSP worker task, one bit each
+ */
+typedef enum {
+    BSP_WORK_SETTINGS_COMMIT = 1 << 0,      /*!< bsp_settings_commit() */
+    BSP_WORK_EVLOG_FLUSH = 1 << 1,          /*!< bsp_evlog_flush() */
+    BSP_WORK_LOAD_SAMPLE = 1 << 2,          /*!< bsp_load_sample() */
+} bsp_work_t;
+
+/**
+ * @brief BSP state kept in RTC memory across deep sleep
+ */
+typedef struct {
+    uint32_t magic;                                     /*!< BSP_RETAINED_MAGIC when valid */
+    uint8_t pcf8574_addr;                               /*!< Expander address, 0 if not present */
+    uint8_t pcf8574_output;                             /*!< Expander output latch */
+    uint8_t pcf8574_input_mask;                         /*!< Expander direction mask (1 = input) */
+    uint8_t led_rgb_frame[BSP_LED_RGB_PIXELS * 3];      /*!< Last RGB frame, R/G/B per pixel */
+    uint32_t i2c_presence[4];                           /*!< I2C presence map, one bit per address */
+    uint32_t crc;                                       /*!< CRC32 of all preceding fields */
+} bsp_retained_state_t;
+
+/**
+ * @brief Get the state retained before deep sleep
+ *
+ * @return
+ *      - Retained state if the chip woke from bsp_deep_sleep_start() and the state is intact
+ *      - NULL on any other boot
+ */
+const bsp_retained_state_t *bsp_sleep_get_resume_state(void);
+
+/**
+ * @brief Copy the current I2C presence map (one bit per 7-bit address)
+ *
+ * @return
+ *      - true if a map is available
+ */
+bool bsp_i2c_get_presence(uint32_t map[4]);
+
+/**
+ * @brief Get the BSP shadow copy of the RGB LED frame (BSP_LED_RGB_PIXELS * 3 bytes, RGB order)
+ */
+const uint8_t *bsp_led_rgb_get_frame(void);
+
+/**
+ * @brief Write a frame into the strip and the shadow copy; front buffer lock held
+ */
+esp_err_t bsp_led_rgb_write_frame(const bsp_rgb_t *frame, uint32_t count);
+
+/**
+ * @brief Send the strip buffer to the LEDs; front buffer lock held
+ */
+esp_err_t bsp_led_rgb_refresh_locked(void);
+
+/**
+ * @brief Create the refresh task and front buffer lock, with CONFIG_BSP_LED_RGB_ASYNC
+ */
+esp_err_t bsp_led_rgb_async_init(void);
+
+/**
+ * @brief Lock the strip buffer against an in-flight transfer (no-op without CONFIG_BSP_LED_RGB_ASYNC)
+ *
+ * @return
+ *      - ESP_OK once the lock is held
+ *      - ESP_ERR_TIMEOUT if a transfer is still in flight after @p timeout_ms
+ */
+esp_err_t bsp_led_rgb_front_take(uint32_t timeout_ms);
+
+/**
+ * @brief Release the lock taken with bsp_led_rgb_front_take()
+ */
+void bsp_led_rgb_front_give(void);
+
+/**
+ * @brief Route BSP_LED_IO to LEDC, used by bsp_led_init() with CONFIG_BSP_LED_PWM
+ */
+esp_err_t bsp_led_pwm_init(void);
+
+/**
+ * @brief Copy the counters kept by the PCF8574 and vibramotor components into the metrics
+ */
+void bsp_metrics_collect_sources(void);
+
+/**
+ * @brief Create the monitor lock, from bsp_init() before any task can use the monitor
+ */
+esp_err_t bsp_monitor_init(void);
+
+/**
+ * @brief Create the worker task, from bsp_init() with CONFIG_BSP_WORKER
+ *
+ * The worker runs just above idle priority and does the flash and bus work
+ * that esp_timer callbacks must not do themselves.
+ */
+esp_err_t bsp_worker_init(void);
+
+/**
+ * @brief Request work from the worker task, from any task or esp_timer callback
+ *
+ * Requests for the same work coalesce until the worker runs it.
+ *
+ * @param work One or more bsp_work_t bits
+ */
+void bsp_worker_post(uint32_t work);
+
+/**
+ * @brief Get the worker task handle, NULL if it is not running
+ */
+TaskHandle_t bsp_worker_get_task_handle(void);
+
+/**
+ * @brief Take the current component counters as the zero of the metrics, for bsp_metrics_reset()
+ */
+void bsp_metrics_reset_sources(void);
+
+/**
+ * @brief Configure the button GPIOs for the gesture recognizer instead of iot_button
+ */
+esp_err_t bsp_gesture_buttons_init(void);
+
+/**
+ * @brief Scale for an RGB LED frame so its estimated current fits the load budget
+ *
+ * @param brightness Scale the frame is shown at without a cap
+ * @return @p brightness while no cap applies (always without CONFIG_BSP_LOAD_SHED), less otherwise
+ */
+uint8_t bsp_load_led_scale(const uint8_t *frame, size_t len, uint8_t brightness);
+
+/**
+ * @brief Read the battery and update the load level, from the worker task only
+ */
+void bsp_load_sample(void);
+
+/**
+ * @brief Log a battery sample, at most every CONFIG_BSP_EVLOG_BATTERY_INTERVAL_S (no-op without CONFIG_BSP_EVLOG)
+ */
+void bsp_evlog_battery_sample(uint32_t mv);
+
+/**
+ * @brief Log a failed I2C transfer (no-op without CONFIG_BSP_EVLOG)
+ *
+ * Only buffers the record, never waits for flash; not callable from interrupts.
+ */
+void bsp_evlog_i2c_error(uint8_t addr, esp_err_t err);
+
+#ifdef __cplusplus
+}
+#endif
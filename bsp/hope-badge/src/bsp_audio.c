@@ -0,0 +1,250 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_audio.h"
+
+#if CONFIG_BSP_AUDIO
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_continuous.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "bsp/bsp_metrics.h"
+
+static const char *TAG = "BSP-AUDIO";
+
+/* One DMA conversion frame per analysis frame */
+#define BSP_AUDIO_CONV_FRAME_BYTES  (BSP_AUDIO_FFT_SIZE * SOC_ADC_DIGI_RESULT_BYTES)
+#define BSP_AUDIO_POOL_BYTES        (4 * BSP_AUDIO_CONV_FRAME_BYTES)
+/* 12-bit samples around mid-scale to Q15 at half full scale, headroom for the window */
+#define BSP_AUDIO_SAMPLE_SHIFT      3
+
+static adc_continuous_handle_t adc_handle = NULL;
+static TaskHandle_t audio_task = NULL;
+static volatile bool audio_stop = false;
+static bsp_audio_config_t audio_config;
+static uint8_t audio_raw[BSP_AUDIO_CONV_FRAME_BYTES];
+static uint16_t audio_frame[BSP_AUDIO_FFT_SIZE];
+static uint32_t audio_frame_len = 0;
+static bsp_audio_agc_t audio_agc;
+static uint8_t audio_levels[BSP_AUDIO_BANDS];
+static portMUX_TYPE audio_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t audio_overflows = 0;
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t audio_task_buf;
+static StackType_t audio_task_stack[BSP_AUDIO_TASK_STACK_SIZE];
+#endif
+
+static bool IRAM_ATTR bsp_audio_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                             void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(audio_task, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR bsp_audio_pool_ovf_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                            void *user_data)
+{
+    // Counted here, reported to the metrics from the task
+    portENTER_CRITICAL_ISR(&audio_lock);
+    audio_overflows++;
+    portEXIT_CRITICAL_ISR(&audio_lock);
+    return false;
+}
+
+static void bsp_audio_process_frame(void)
+{
+    int16_t samples[BSP_AUDIO_FFT_SIZE];
+    uint32_t bands[BSP_AUDIO_BANDS];
+    uint8_t levels[BSP_AUDIO_BANDS];
+    int64_t start = esp_timer_get_time();
+
+    // Remove DC with the frame mean: the microphone bias sits anywhere in the ADC range
+    uint32_t sum = 0;
+    for (int i = 0; i < BSP_AUDIO_FFT_SIZE; i++) {
+        sum += audio_frame[i];
+    }
+    const int32_t mean = sum / BSP_AUDIO_FFT_SIZE;
+    for (int i = 0; i < BSP_AUDIO_FFT_SIZE; i++) {
+        samples[i] = (int16_t)(((int32_t)audio_frame[i] - mean) * (1 << BSP_AUDIO_SAMPLE_SHIFT));
+    }
+
+    bsp_audio_analyze(samples, bands);
+    bsp_audio_agc_update(&audio_agc, bands, levels);
+
+    taskENTER_CRITICAL(&audio_lock);
+    memcpy(audio_levels, levels, sizeof(audio_levels));
+    taskEXIT_CRITICAL(&audio_lock);
+
+    bsp_metrics_record_us(BSP_METRIC_AUDIO_ANALYZE_US, (uint32_t)(esp_timer_get_time() - start));
+    bsp_metrics_inc(BSP_METRIC_AUDIO_FRAMES);
+    taskENTER_CRITICAL(&audio_lock);
+    const uint32_t overflows = audio_overflows;
+    audio_overflows = 0;
+    taskEXIT_CRITICAL(&audio_lock);
+    if (overflows != 0) {
+        bsp_metrics_add(BSP_METRIC_AUDIO_OVERFLOWS, overflows);
+    }
+
+    if (audio_config.callback) {
+        audio_config.callback(levels, audio_config.user_arg);
+    }
+}
+
+static void bsp_audio_task(void *arg)
+{
+    while (!audio_stop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Drain everything the DMA has delivered since the last wake-up
+        uint32_t len = 0;
+        while (!audio_stop &&
+                adc_continuous_read(adc_handle, audio_raw, sizeof(audio_raw), &len, 0) == ESP_OK) {
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&audio_raw[i];
+                audio_frame[audio_frame_len++] = p->type2.data;
+                if (audio_frame_len == BSP_AUDIO_FFT_SIZE) {
+                    bsp_audio_process_frame();
+                    audio_frame_len = 0;
+                }
+            }
+        }
+    }
+
+    audio_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t bsp_audio_start(const bsp_audio_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config != NULL, ESP_ERR_INVALID_ARG, TAG, "Config is required");
+    ESP_RETURN_ON_FALSE(adc_handle == NULL, ESP_ERR_INVALID_STATE, TAG, "Already running");
+
+    adc_unit_t unit;
+    adc_channel_t channel;
+    ESP_RETURN_ON_FALSE(CONFIG_BSP_AUDIO_ADC_GPIO >= 0 &&
+                        adc_continuous_io_to_channel(CONFIG_BSP_AUDIO_ADC_GPIO, &unit, &channel) == ESP_OK &&
+                        unit == ADC_UNIT_1, ESP_ERR_INVALID_ARG, TAG, "GPIO %d is not an ADC1 pin",
+                        CONFIG_BSP_AUDIO_ADC_GPIO);
+
+    audio_config = *config;
+    audio_stop = false;
+    audio_frame_len = 0;
+    memset(&audio_agc, 0, sizeof(audio_agc));
+
+    const adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = BSP_AUDIO_POOL_BYTES,
+        .conv_frame_size = BSP_AUDIO_CONV_FRAME_BYTES,
+        .flags.flush_pool = true,   // Drop the oldest samples when the task falls behind
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_new_handle(&handle_config, &adc_handle), TAG, "Failed to create ADC handle");
+
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,
+        .channel = channel,
+        .unit = unit,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    const adc_continuous_config_t adc_config = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = CONFIG_BSP_AUDIO_SAMPLE_RATE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    const adc_continuous_evt_cbs_t callbacks = {
+        .on_conv_done = bsp_audio_conv_done_cb,
+        .on_pool_ovf = bsp_audio_pool_ovf_cb,
+    };
+    esp_err_t ret = adc_continuous_config(adc_handle, &adc_config);
+    if (ret == ESP_OK) {
+        ret = adc_continuous_register_event_callbacks(adc_handle, &callbacks, NULL);
+    }
+    if (ret == ESP_OK) {
+        TaskHandle_t task = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+        task = xTaskCreateStatic(bsp_audio_task, "bsp_audio", BSP_AUDIO_TASK_STACK_SIZE, NULL, config->task_priority,
+                                 audio_task_stack, &audio_task_buf);
+#else
+        xTaskCreate(bsp_audio_task, "bsp_audio", BSP_AUDIO_TASK_STACK_SIZE, NULL, config->task_priority, &task);
+#endif
+        audio_task = task;
+        if (task == NULL) {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (ret == ESP_OK) {
+        ret = adc_continuous_start(adc_handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start audio input: %s", esp_err_to_name(ret));
+        bsp_audio_stop();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Audio input on GPIO %d at %d Hz", CONFIG_BSP_AUDIO_ADC_GPIO, CONFIG_BSP_AUDIO_SAMPLE_RATE_HZ);
+    return ESP_OK;
+}
+
+esp_err_t bsp_audio_stop(void)
+{
+    if (adc_handle == NULL) {
+        return ESP_OK;
+    }
+
+    adc_continuous_stop(adc_handle);
+    // Let the task finish the frame in progress, it may be inside the callback
+    audio_stop = true;
+    TaskHandle_t task;
+    while ((task = audio_task) != NULL) {
+        xTaskNotifyGive(task);
+        vTaskDelay(1);
+    }
+    adc_continuous_deinit(adc_handle);
+    adc_handle = NULL;
+    return ESP_OK;
+}
+
+esp_err_t bsp_audio_get_levels(uint8_t levels[BSP_AUDIO_BANDS])
+{
+    ESP_RETURN_ON_FALSE(levels != NULL, ESP_ERR_INVALID_ARG, TAG, "Levels buffer is required");
+
+    taskENTER_CRITICAL(&audio_lock);
+    memcpy(levels, audio_levels, sizeof(audio_levels));
+    taskEXIT_CRITICAL(&audio_lock);
+    return ESP_OK;
+}
+
+#else /* !CONFIG_BSP_AUDIO */
+
+esp_err_t bsp_audio_start(const bsp_audio_config_t *config)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_audio_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_audio_get_levels(uint8_t levels[BSP_AUDIO_BANDS])
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_AUDIO */
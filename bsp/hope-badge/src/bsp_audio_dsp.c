@@ -0,0 +1,168 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdint.h>
+
+#include "bsp/bsp_audio_dsp.h"
+
+/* 32767 * sin(i * 90° / 64): a quarter of the FFT twiddle circle */
+static const int16_t sin_q15[65] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,
+     7179,  7962,  8739,  9512, 10278, 11039, 11793, 12539, 13279,
+    14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519,
+    20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898,
+    29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580,
+    31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728,
+    32757, 32767,
+};
+
+/* First FFT bin of each band, plus the end of the last band. The top octave is split in two. */
+static const uint16_t band_edges[BSP_AUDIO_BANDS + 1] = {1, 2, 4, 8, 16, 32, 64, 96, BSP_AUDIO_FFT_SIZE / 2};
+
+/* sin(2π k / BSP_AUDIO_FFT_SIZE) in Q15 */
+static int16_t bsp_audio_sin(uint32_t k)
+{
+    k &= BSP_AUDIO_FFT_SIZE - 1;
+    const uint32_t quarter = BSP_AUDIO_FFT_SIZE / 4;
+    const uint32_t offset = k % quarter;
+    switch (k / quarter) {
+    case 0:
+        return sin_q15[offset];
+    case 1:
+        return sin_q15[quarter - offset];
+    case 2:
+        return -sin_q15[offset];
+    default:
+        return -sin_q15[quarter - offset];
+    }
+}
+
+static inline int16_t bsp_audio_cos(uint32_t k)
+{
+    return bsp_audio_sin(k + BSP_AUDIO_FFT_SIZE / 4);
+}
+
+static inline int16_t bsp_audio_mul_q15(int16_t a, int16_t b)
+{
+    return (int16_t)(((int32_t)a * b) >> 15);
+}
+
+void bsp_audio_fft(int16_t *re, int16_t *im)
+{
+    const uint32_t n = BSP_AUDIO_FFT_SIZE;
+
+    // Bit-reversal permutation
+    for (uint32_t i = 1, j = 0; i < n; i++) {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int16_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+
+    // Decimation in time, halving every stage so the butterflies cannot overflow
+    for (uint32_t len = 2; len <= n; len <<= 1) {
+        const uint32_t half = len >> 1;
+        const uint32_t step = n / len;
+        for (uint32_t start = 0; start < n; start += len) {
+            for (uint32_t k = 0; k < half; k++) {
+                const int16_t wr = bsp_audio_cos(k * step);
+                const int16_t wi = -bsp_audio_sin(k * step);
+                const uint32_t a = start + k;
+                const uint32_t b = a + half;
+                const int32_t tr = ((int32_t)re[b] * wr - (int32_t)im[b] * wi) >> 15;
+                const int32_t ti = ((int32_t)re[b] * wi + (int32_t)im[b] * wr) >> 15;
+                re[b] = (int16_t)((re[a] - tr) >> 1);
+                im[b] = (int16_t)((im[a] - ti) >> 1);
+                re[a] = (int16_t)((re[a] + tr) >> 1);
+                im[a] = (int16_t)((im[a] + ti) >> 1);
+            }
+        }
+    }
+}
+
+void bsp_audio_analyze(const int16_t *samples, uint32_t bands[BSP_AUDIO_BANDS])
+{
+    int16_t re[BSP_AUDIO_FFT_SIZE];
+    int16_t im[BSP_AUDIO_FFT_SIZE];
+
+    // Hann window: (1 - cos(2π n / N)) / 2
+    for (uint32_t i = 0; i < BSP_AUDIO_FFT_SIZE; i++) {
+        const int16_t w = (int16_t)((32767 - bsp_audio_cos(i)) >> 1);
+        re[i] = bsp_audio_mul_q15(samples[i], w);
+        im[i] = 0;
+    }
+
+    bsp_audio_fft(re, im);
+
+    for (int b = 0; b < BSP_AUDIO_BANDS; b++) {
+        uint32_t sum = 0;
+        for (uint32_t bin = band_edges[b]; bin < band_edges[b + 1]; bin++) {
+            // |z| ~ max + 3/8 min, within 7% and no square root
+            uint32_t x = (re[bin] < 0) ? -re[bin] : re[bin];
+            uint32_t y = (im[bin] < 0) ? -im[bin] : im[bin];
+            sum += (x > y) ? x + (y >> 2) + (y >> 3) : y + (x >> 2) + (x >> 3);
+        }
+        bands[b] = sum;
+    }
+}
+
+void bsp_audio_agc_update(bsp_audio_agc_t *agc, const uint32_t bands[BSP_AUDIO_BANDS],
+                          uint8_t levels[BSP_AUDIO_BANDS])
+{
+    uint32_t loudest = 0;
+    for (int b = 0; b < BSP_AUDIO_BANDS; b++) {
+        // Jump up to new peaks, decay by 1/64 per frame (about a second at 20 kHz)
+        uint32_t peak = agc->peak[b] - (agc->peak[b] >> 6);
+        if (bands[b] > peak) {
+            peak = bands[b];
+        }
+        agc->peak[b] = peak;
+        if (peak > loudest) {
+            loudest = peak;
+        }
+    }
+
+    // Quiet bands are scaled against the loudest one, not their own noise
+    uint32_t min_peak = loudest >> BSP_AUDIO_AGC_RANGE_LOG2;
+    if (min_peak < BSP_AUDIO_AGC_FLOOR) {
+        min_peak = BSP_AUDIO_AGC_FLOOR;
+    }
+
+    /*
+     * Window sidelobes put about 1/60 of a tone into the neighbouring bands. Energy below 1/32 of
+     * the loudest band of this frame, or below the noise gate, is not shown. The gate stays below
+     * min_peak, which is at least 1/8 of the loudest peak.
+     */
+    uint32_t frame_loudest = 0;
+    for (int b = 0; b < BSP_AUDIO_BANDS; b++) {
+        if (bands[b] > frame_loudest) {
+            frame_loudest = bands[b];
+        }
+    }
+    uint32_t gate = frame_loudest >> BSP_AUDIO_AGC_LEAK_LOG2;
+    if (gate < BSP_AUDIO_AGC_GATE) {
+        gate = BSP_AUDIO_AGC_GATE;
+    }
+
+    for (int b = 0; b < BSP_AUDIO_BANDS; b++) {
+        const uint32_t peak = (agc->peak[b] > min_peak) ? agc->peak[b] : min_peak;
+        const uint32_t band = (bands[b] < peak) ? bands[b] : peak;
+        // band * 255 fits in 32 bits: a band sums at most 32 bins of 45000
+        levels[b] = (band > gate) ? (uint8_t)(((band - gate) * 255) / (peak - gate)) : 0;
+    }
+}
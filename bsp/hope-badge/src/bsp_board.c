@@ -0,0 +1,104 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include "bsp/bsp_hope.h"
+
+/*
+ * Compile-time pin conflict check. The sum of (1 << pin) over all used pins equals
+ * their bitwise OR only if no pin is used twice. Unused pins (-1) contribute nothing.
+ */
+#define BSP_PIN_BIT(gpio)   (((gpio) >= 0) ? (1ULL << (gpio)) : 0ULL)
+
+#if CONFIG_BSP_BUTTONS_3_4
+#define BSP_BUTTON_3_PIN    BSP_BUTTON_3_GPIO
+#define BSP_BUTTON_4_PIN    BSP_BUTTON_4_GPIO
+#else
+#define BSP_BUTTON_3_PIN    (-1)
+#define BSP_BUTTON_4_PIN    (-1)
+#endif
+
+#if CONFIG_BSP_LED_STRIP_EXT
+#define BSP_STRIP_EXT_PIN   CONFIG_BSP_LED_STRIP_EXT_GPIO
+#else
+#define BSP_STRIP_EXT_PIN   (-1)
+#endif
+
+#if CONFIG_BSP_AUDIO
+#define BSP_AUDIO_PIN       CONFIG_BSP_AUDIO_ADC_GPIO
+#else
+#define BSP_AUDIO_PIN       (-1)
+#endif
+
+#define BSP_LED_PIN         BSP_LED_IO
+#define BSP_LED_RGB_PIN     BSP_LED_RGB_IO
+#define BSP_VIBRAMOTOR_PIN  (BSP_CAPS_VIBRAMOTOR ? BSP_VIBRAMOTOR_IO : -1)
+#define BSP_PCF8574_INT_PIN (BSP_CAPS_PCF8574 ? BSP_PCF8574_INT_IO : -1)
+#define BSP_ALRT_PIN        (BSP_CAPS_FUEL_GAUGE ? BSP_FUEL_GAUGE_ALRT_IO : -1)
+#define BSP_IRDA_TX_PIN     (BSP_CAPS_IRDA ? BSP_IRDA_TX_IO : -1)
+#define BSP_IRDA_RX_PIN     (BSP_CAPS_IRDA ? BSP_IRDA_RX_IO : -1)
+
+#define BSP_PIN_LIST(X) \
+    X(BSP_I2C_SCL) X(BSP_I2C_SDA) \
+    X(BSP_BUTTON_1_GPIO) X(BSP_BUTTON_2_GPIO) X(BSP_BUTTON_3_PIN) X(BSP_BUTTON_4_PIN) \
+    X(BSP_LED_PIN) X(BSP_LED_RGB_PIN) X(BSP_VIBRAMOTOR_PIN) \
+    X(BSP_IRDA_TX_PIN) X(BSP_IRDA_RX_PIN) \
+    X(BSP_PCF8574_INT_PIN) X(BSP_ALRT_PIN) \
+    X(BSP_STRIP_EXT_PIN) X(BSP_AUDIO_PIN)
+
+#define BSP_PIN_SUM(gpio)   + BSP_PIN_BIT(gpio)
+#define BSP_PIN_OR(gpio)    | BSP_PIN_BIT(gpio)
+
+_Static_assert((0ULL BSP_PIN_LIST(BSP_PIN_SUM)) == (0ULL BSP_PIN_LIST(BSP_PIN_OR)),
+               "HOPE badge pin configuration assigns the same GPIO to two functions");
+_Static_assert(BSP_LED_RGB_PIXELS <= BSP_LED_RGB_PIXELS_FITTED,
+               "More RGB LED pixels configured than fitted on this HW version");
+_Static_assert(BSP_PCF8574_I2C_ADDR == 0 ||
+               (BSP_PCF8574_I2C_ADDR >= PCF8574_I2C_ADDR_DEFAULT && BSP_PCF8574_I2C_ADDR <= PCF8574_I2C_ADDR_DEFAULT + 7) ||
+               (BSP_PCF8574_I2C_ADDR >= PCF8574A_I2C_ADDR_DEFAULT && BSP_PCF8574_I2C_ADDR <= PCF8574A_I2C_ADDR_DEFAULT + 7),
+               "HW version expander address is not a PCF8574/PCF8574A address");
+
+static const bsp_board_desc_t board_desc = {
+    .hw_version = BSP_HW_VERSION_NAME,
+    .i2c = {
+        .scl = BSP_I2C_SCL,
+        .sda = BSP_I2C_SDA,
+    },
+    .buttons = {
+        [BSP_BUTTON_1_GPIO_INDEX] = {BSP_BUTTON_1_GPIO, BSP_BUTTON_1_ACTIVE_LEVEL},
+        [BSP_BUTTON_2_GPIO_INDEX] = {BSP_BUTTON_2_GPIO, BSP_BUTTON_2_ACTIVE_LEVEL},
+        [BSP_BUTTON_3_GPIO_INDEX] = {BSP_BUTTON_3_PIN, BSP_BUTTON_3_ACTIVE_LEVEL},
+        [BSP_BUTTON_4_GPIO_INDEX] = {BSP_BUTTON_4_PIN, BSP_BUTTON_4_ACTIVE_LEVEL},
+    },
+    .led = {
+        .gpio = BSP_LED_PIN,
+        .active_level = CONFIG_BSP_LED_ACTIVE_LEVEL,
+    },
+    .led_rgb = {
+        .gpio = BSP_LED_RGB_PIN,
+        .pixels = BSP_LED_RGB_PIXELS,
+    },
+    .vibramotor_gpio = BSP_VIBRAMOTOR_PIN,
+    .irda = {
+        .tx = BSP_IRDA_TX_PIN,
+        .rx = BSP_IRDA_RX_PIN,
+    },
+    .pcf8574_int_gpio = BSP_PCF8574_INT_PIN,
+    .fuel_gauge_alrt_gpio = BSP_ALRT_PIN,
+    .pcf8574_addr = BSP_PCF8574_I2C_ADDR,
+    .has = {
+        .vibramotor = BSP_CAPS_VIBRAMOTOR,
+        .fuel_gauge = BSP_CAPS_FUEL_GAUGE,
+        .pcf8574 = BSP_CAPS_PCF8574,
+        .irda = BSP_CAPS_IRDA,
+    },
+};
+
+const bsp_board_desc_t *bsp_get_board_desc(void)
+{
+    return &board_desc;
+}
@@ -0,0 +1,117 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdint.h>
+
+#include "bsp/bsp_color.h"
+
+/* 127 * sin(i * 90° / 64), first quarter turn including the end point */
+static const uint8_t sin_quarter[65] = {
+      0,   3,   6,   9,  12,  16,  19,  22,  25,  28,  31,  34,  37,
+     40,  43,  46,  49,  51,  54,  57,  60,  63,  65,  68,  71,  73,
+     76,  78,  81,  83,  85,  88,  90,  92,  94,  96,  98, 100, 102,
+    104, 106, 107, 109, 111, 112, 113, 115, 116, 117, 118, 120, 121,
+    122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127, 127,
+};
+
+/* Cubic ease-in-out: 4x³ below half, 1 - (2 - 2x)³ / 2 above */
+static const uint8_t ease_table[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,
+      2,   2,   2,   3,   3,   3,   3,   4,   4,   4,   5,   5,   5,   6,   6,   6,
+      7,   7,   8,   8,   9,   9,  10,  10,  11,  11,  12,  13,  13,  14,  15,  15,
+     16,  17,  18,  19,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,
+     31,  33,  34,  35,  36,  38,  39,  41,  42,  43,  45,  46,  48,  49,  51,  53,
+     54,  56,  58,  60,  62,  63,  65,  67,  69,  71,  73,  75,  77,  80,  82,  84,
+     86,  89,  91,  94,  96,  99, 101, 104, 106, 109, 112, 114, 117, 120, 123, 126,
+    129, 132, 135, 138, 141, 143, 146, 149, 151, 154, 156, 159, 161, 164, 166, 169,
+    171, 173, 175, 178, 180, 182, 184, 186, 188, 190, 192, 193, 195, 197, 199, 201,
+    202, 204, 206, 207, 209, 210, 212, 213, 214, 216, 217, 219, 220, 221, 222, 224,
+    225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 236, 237, 238, 239,
+    240, 240, 241, 242, 242, 243, 244, 244, 245, 245, 246, 246, 247, 247, 248, 248,
+    249, 249, 249, 250, 250, 250, 251, 251, 251, 252, 252, 252, 252, 253, 253, 253,
+    253, 253, 253, 254, 254, 254, 254, 254, 254, 254, 254, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+/* bsp_color_hsv(i * 16, 255, 255) */
+const bsp_palette16_t bsp_palette_rainbow = {{
+    {255,   0,   0}, {255,  96,   0}, {255, 192,   0}, {223, 255,   0},
+    {127, 255,   0}, { 31, 255,   0}, {  0, 255,  64}, {  0, 255, 160},
+    {  0, 255, 255}, {  0, 159, 255}, {  0,  63, 255}, { 32,   0, 255},
+    {128,   0, 255}, {224,   0, 255}, {255,   0, 191}, {255,   0,  95},
+}};
+
+const bsp_palette16_t bsp_palette_heat = {{
+    {  0,   0,   0}, { 51,   0,   0}, {102,   0,   0}, {153,   0,   0},
+    {204,   0,   0}, {255,   0,   0}, {255,  51,   0}, {255, 102,   0},
+    {255, 153,   0}, {255, 204,   0}, {255, 255,   0}, {255, 255,  51},
+    {255, 255, 102}, {255, 255, 153}, {255, 255, 204}, {255, 255, 255},
+}};
+
+const bsp_palette16_t bsp_palette_ocean = {{
+    {  0,   0,  32}, {  0,   0,  64}, {  0,   0, 128}, {  0,   0, 192},
+    {  0,  32, 255}, {  0,  64, 255}, {  0, 128, 255}, {  0, 192, 255},
+    {  0, 255, 255}, {  0, 192, 255}, {  0, 128, 255}, {  0,  64, 192},
+    {  0,  32, 128}, { 64, 128, 255}, {128, 192, 255}, {  0,   0,  64},
+}};
+
+bsp_rgb_t bsp_color_hsv(uint8_t hue, uint8_t sat, uint8_t val)
+{
+    // Six sectors of the hue circle, 8 fraction bits within a sector
+    const uint16_t h6 = (uint16_t)hue * 6;
+    const uint8_t sector = h6 >> 8;
+    const uint8_t frac = h6 & 0xFF;
+
+    const uint8_t p = bsp_scale8(val, 255 - sat);
+    const uint8_t q = bsp_scale8(val, 255 - bsp_scale8(sat, frac));
+    const uint8_t t = bsp_scale8(val, 255 - bsp_scale8(sat, 255 - frac));
+
+    switch (sector) {
+    case 0:
+        return BSP_RGB(val, t, p);
+    case 1:
+        return BSP_RGB(q, val, p);
+    case 2:
+        return BSP_RGB(p, val, t);
+    case 3:
+        return BSP_RGB(p, q, val);
+    case 4:
+        return BSP_RGB(t, p, val);
+    default:
+        return BSP_RGB(val, p, q);
+    }
+}
+
+bsp_rgb_t bsp_color_from_palette(const bsp_palette16_t *palette, uint8_t index, uint8_t brightness)
+{
+    const uint8_t entry = index >> 4;
+    const uint8_t frac = (index & 0x0F) << 4;
+
+    bsp_rgb_t color = palette->entries[entry];
+    if (frac) {
+        color = bsp_color_blend(color, palette->entries[(entry + 1) & 0x0F], frac);
+    }
+    return (brightness == 255) ? color : bsp_color_scale(color, brightness);
+}
+
+uint8_t bsp_sin8(uint8_t theta)
+{
+    uint8_t offset = theta & 0x3F;
+    if (theta & 0x40) {
+        // Second and fourth quarters run the table backwards
+        offset = 64 - offset;
+    }
+    const uint8_t s = sin_quarter[offset];
+    return (theta & 0x80) ? 128 - s : 128 + s;
+}
+
+uint8_t bsp_ease8(uint8_t x)
+{
+    return ease_table[x];
+}
@@ -0,0 +1,430 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_evlog.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_EVLOG
+#include <stdio.h>
+
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "BSP-EVLOG";
+
+#define BSP_EVLOG_SUBTYPE           0x40
+#define BSP_EVLOG_TYPE_ERASED       0xFF
+
+/* Sector header, BSP_EVLOG_HEADER_SIZE bytes */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t seq;                   // Increments with every sector started, the highest is the newest
+    uint8_t version;
+    uint8_t record_size;
+    uint16_t boot;                  // Boot counter when the sector was started
+    uint8_t reserved[3];            // Left erased (0xFF)
+    uint8_t crc;                    // CRC-8 over the bytes before
+} bsp_evlog_header_t;
+
+_Static_assert(sizeof(bsp_evlog_header_t) == BSP_EVLOG_HEADER_SIZE, "Header size is part of the flash format");
+
+static const esp_partition_t *log_flash = NULL;     // Partition accessed by the flash helpers
+static const esp_partition_t *log_part = NULL;      // Published last, once the log is usable
+static uint32_t sector_size = 0;
+static uint32_t sector_count = 0;
+static uint32_t head_sector = 0;            // Sector being filled
+static uint32_t head_seq = 0;
+static uint32_t head_offset = 0;            // Next free byte within the head sector
+static uint16_t boot_count = 0;
+static bsp_evlog_record_t buf[CONFIG_BSP_EVLOG_BUF_RECORDS];
+static uint32_t buf_len = 0;
+static uint32_t buf_dropped = 0;
+static bsp_evlog_record_t flush_buf[CONFIG_BSP_EVLOG_BUF_RECORDS];
+static int64_t last_battery_us = 0;
+static portMUX_TYPE buf_lock = portMUX_INITIALIZER_UNLOCKED;    // buf, buf_len, buf_dropped
+static SemaphoreHandle_t log_lock = NULL;                       // Flash and the head position
+static StaticSemaphore_t log_lock_buf;
+static esp_timer_handle_t flush_timer = NULL;
+
+/* CRC-8, polynomial 0x07, init 0; tools/bsp_evlog_decode.py has the same */
+static uint8_t bsp_evlog_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t bsp_evlog_record_crc(const bsp_evlog_record_t *rec)
+{
+    bsp_evlog_record_t tmp = *rec;
+    tmp.crc = 0;
+    return bsp_evlog_crc8((const uint8_t *)&tmp, sizeof(tmp));
+}
+
+static bool bsp_evlog_is_erased(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bsp_evlog_read_header(uint32_t sector, uint32_t *seq, uint16_t *boot)
+{
+    bsp_evlog_header_t hdr;
+    if (esp_partition_read(log_flash, sector * sector_size, &hdr, sizeof(hdr)) != ESP_OK) {
+        return false;
+    }
+    if (hdr.magic != BSP_EVLOG_MAGIC || hdr.version != BSP_EVLOG_VERSION ||
+            hdr.record_size != BSP_EVLOG_RECORD_SIZE ||
+            hdr.crc != bsp_evlog_crc8((const uint8_t *)&hdr, offsetof(bsp_evlog_header_t, crc))) {
+        return false;
+    }
+    *seq = hdr.seq;
+    if (boot != NULL) {
+        *boot = hdr.boot;
+    }
+    return true;
+}
+
+/* Erase a sector and claim it as the new head */
+static esp_err_t bsp_evlog_start_sector(uint32_t sector, uint32_t seq)
+{
+    ESP_RETURN_ON_ERROR(esp_partition_erase_range(log_flash, sector * sector_size, sector_size), TAG,
+                        "Failed to erase sector %lu", (unsigned long)sector);
+
+    bsp_evlog_header_t hdr = {
+        .magic = BSP_EVLOG_MAGIC,
+        .seq = seq,
+        .version = BSP_EVLOG_VERSION,
+        .record_size = BSP_EVLOG_RECORD_SIZE,
+        // A new sector may stay empty until the next boot, the count must not depend on its records
+        .boot = boot_count,
+    };
+    memset(hdr.reserved, 0xFF, sizeof(hdr.reserved));
+    hdr.crc = bsp_evlog_crc8((const uint8_t *)&hdr, offsetof(bsp_evlog_header_t, crc));
+    ESP_RETURN_ON_ERROR(esp_partition_write(log_flash, sector * sector_size, &hdr, sizeof(hdr)), TAG,
+                        "Failed to write sector header");
+
+    head_sector = sector;
+    head_seq = seq;
+    head_offset = BSP_EVLOG_HEADER_SIZE;
+    return ESP_OK;
+}
+
+/* Find the end of the newest sector; returns the last battery sample seen there */
+static uint32_t bsp_evlog_scan_head(void)
+{
+    uint32_t battery_mv = 0;
+    bsp_evlog_record_t rec;
+
+    head_offset = BSP_EVLOG_HEADER_SIZE;
+    while (head_offset + BSP_EVLOG_RECORD_SIZE <= sector_size) {
+        if (esp_partition_read(log_flash, head_sector * sector_size + head_offset, &rec, sizeof(rec)) != ESP_OK ||
+                bsp_evlog_is_erased(&rec, sizeof(rec))) {
+            break;
+        }
+        // Torn records are skipped, never rewritten: flash bits only go from 1 to 0
+        if (rec.crc == bsp_evlog_record_crc(&rec)) {
+            boot_count = rec.boot;
+            if (rec.type == BSP_EVLOG_BATTERY) {
+                battery_mv = rec.arg0;
+            }
+        }
+        head_offset += BSP_EVLOG_RECORD_SIZE;
+    }
+    return battery_mv;
+}
+
+static esp_err_t bsp_evlog_flush_locked(void)
+{
+    // Writers only take the spinlock, they never wait for flash
+    taskENTER_CRITICAL(&buf_lock);
+    const uint32_t len = buf_len;
+    const uint32_t dropped = buf_dropped;
+    memcpy(flush_buf, buf, len * sizeof(buf[0]));
+    buf_len = 0;
+    buf_dropped = 0;
+    taskEXIT_CRITICAL(&buf_lock);
+    if (dropped) {
+        ESP_LOGW(TAG, "%lu records dropped, the buffer was full", (unsigned long)dropped);
+    }
+
+    esp_err_t ret = ESP_OK;
+    uint32_t done = 0;
+    while (done < len && ret == ESP_OK) {
+        if (head_offset + BSP_EVLOG_RECORD_SIZE > sector_size) {
+            ret = bsp_evlog_start_sector((head_sector + 1) % sector_count, head_seq + 1);
+            if (ret != ESP_OK) {
+                break;
+            }
+        }
+        // As many records as fit into the head sector, in one write
+        uint32_t n = (sector_size - head_offset) / BSP_EVLOG_RECORD_SIZE;
+        if (n > len - done) {
+            n = len - done;
+        }
+        ret = esp_partition_write(log_flash, head_sector * sector_size + head_offset, &flush_buf[done],
+                                  n * BSP_EVLOG_RECORD_SIZE);
+        // Skip the slots on failure as well, they may be partially programmed
+        head_offset += n * BSP_EVLOG_RECORD_SIZE;
+        done += n;
+    }
+    // Records that could not be written are dropped, the buffer must not block new ones
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to write the event log: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static esp_err_t bsp_evlog_append(uint8_t type, uint32_t arg0, uint32_t arg1, bool flush)
+{
+    bsp_evlog_record_t rec = {
+        .time_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .boot = boot_count,
+        .type = type,
+        .arg0 = arg0,
+        .arg1 = arg1,
+    };
+    rec.crc = bsp_evlog_record_crc(&rec);
+
+    bool stored = false;
+    taskENTER_CRITICAL(&buf_lock);
+    if (buf_len < CONFIG_BSP_EVLOG_BUF_RECORDS) {
+        buf[buf_len++] = rec;
+        stored = true;
+    } else {
+        buf_dropped++;
+    }
+    const bool full = (buf_len == CONFIG_BSP_EVLOG_BUF_RECORDS);
+    taskEXIT_CRITICAL(&buf_lock);
+
+    if (flush) {
+        return bsp_evlog_flush();
+    }
+    if (full) {
+        // Flash is written by the worker task, so a hot path or a timer callback never erases a sector
+        bsp_worker_post(BSP_WORK_EVLOG_FLUSH);
+    }
+    return stored ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static void bsp_evlog_flush_timer_cb(void *arg)
+{
+    bsp_worker_post(BSP_WORK_EVLOG_FLUSH);
+}
+
+esp_err_t bsp_evlog_init(void)
+{
+    if (log_part != NULL) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, BSP_EVLOG_SUBTYPE,
+                                                           CONFIG_BSP_EVLOG_PARTITION);
+    ESP_RETURN_ON_FALSE(part != NULL, ESP_ERR_NOT_FOUND, TAG, "No \"%s\" partition", CONFIG_BSP_EVLOG_PARTITION);
+    ESP_RETURN_ON_FALSE(part->size >= 2 * part->erase_size, ESP_ERR_INVALID_SIZE, TAG,
+                        "Partition needs at least two sectors");
+    // Before the log is published: a record logged meanwhile may already post a flush
+    if (log_lock == NULL) {
+        log_lock = xSemaphoreCreateMutexStatic(&log_lock_buf);
+    }
+    log_flash = part;
+    sector_size = part->erase_size;
+    sector_count = part->size / part->erase_size;
+
+    // The newest sector is the valid one with the highest sequence number
+    bool found = false;
+    for (uint32_t i = 0; i < sector_count; i++) {
+        uint32_t seq;
+        uint16_t boot;
+        if (bsp_evlog_read_header(i, &seq, &boot) && (!found || (int32_t)(seq - head_seq) > 0)) {
+            found = true;
+            head_sector = i;
+            head_seq = seq;
+            boot_count = boot;
+        }
+    }
+
+    esp_err_t ret;
+    uint32_t battery_mv = 0;
+    if (found) {
+        battery_mv = bsp_evlog_scan_head();
+        ret = ESP_OK;
+    } else {
+        ESP_LOGI(TAG, "Formatting event log");
+        ret = bsp_evlog_start_sector(0, 1);
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    boot_count++;
+
+#if CONFIG_BSP_EVLOG_FLUSH_INTERVAL_S > 0
+    const esp_timer_create_args_t timer_args = {
+        .callback = bsp_evlog_flush_timer_cb,
+        .name = "bsp_evlog",
+    };
+    if (esp_timer_create(&timer_args, &flush_timer) == ESP_OK) {
+        esp_timer_start_periodic(flush_timer, (uint64_t)CONFIG_BSP_EVLOG_FLUSH_INTERVAL_S * 1000000);
+    }
+#endif
+
+    log_part = part;
+
+    const esp_reset_reason_t reason = esp_reset_reason();
+    ESP_LOGI(TAG, "Event log on \"%s\": %lu sectors, boot %u", part->label, (unsigned long)sector_count,
+             boot_count);
+    if (reason == ESP_RST_BROWNOUT) {
+        bsp_evlog_append(BSP_EVLOG_BROWNOUT, battery_mv, 0, false);
+    }
+    return bsp_evlog_append(BSP_EVLOG_RESET, reason, 0, true);
+}
+
+esp_err_t bsp_evlog_write(uint8_t type, uint32_t arg0, uint32_t arg1)
+{
+    ESP_RETURN_ON_FALSE(type != BSP_EVLOG_TYPE_ERASED, ESP_ERR_INVALID_ARG, TAG, "Type 0xFF is reserved");
+    ESP_RETURN_ON_FALSE(log_part != NULL, ESP_ERR_INVALID_STATE, TAG, "Event log is not mounted");
+    return bsp_evlog_append(type, arg0, arg1, false);
+}
+
+esp_err_t bsp_evlog_flush(void)
+{
+    ESP_RETURN_ON_FALSE(log_part != NULL, ESP_ERR_INVALID_STATE, TAG, "Event log is not mounted");
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    esp_err_t ret = bsp_evlog_flush_locked();
+    xSemaphoreGive(log_lock);
+    return ret;
+}
+
+esp_err_t bsp_evlog_dump(void)
+{
+    ESP_RETURN_ON_FALSE(log_part != NULL, ESP_ERR_INVALID_STATE, TAG, "Event log is not mounted");
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    bsp_evlog_flush_locked();
+    // The oldest sector follows the head; sectors without a valid header are skipped
+    for (uint32_t n = 1; n <= sector_count; n++) {
+        const uint32_t sector = (head_sector + n) % sector_count;
+        uint32_t seq;
+        if (!bsp_evlog_read_header(sector, &seq, NULL)) {
+            continue;
+        }
+        for (uint32_t off = BSP_EVLOG_HEADER_SIZE; off + BSP_EVLOG_RECORD_SIZE <= sector_size;
+                off += BSP_EVLOG_RECORD_SIZE) {
+            bsp_evlog_record_t rec;
+            if (esp_partition_read(log_part, sector * sector_size + off, &rec, sizeof(rec)) != ESP_OK ||
+                    bsp_evlog_is_erased(&rec, sizeof(rec))) {
+                break;
+            }
+            if (rec.crc != bsp_evlog_record_crc(&rec)) {
+                continue;
+            }
+            printf("boot %5u %10lu ms  type %3u  %08lx %08lx\n", rec.boot, (unsigned long)rec.time_ms, rec.type,
+                   (unsigned long)rec.arg0, (unsigned long)rec.arg1);
+        }
+    }
+    xSemaphoreGive(log_lock);
+    return ESP_OK;
+}
+
+esp_err_t bsp_evlog_erase(void)
+{
+    ESP_RETURN_ON_FALSE(log_part != NULL, ESP_ERR_INVALID_STATE, TAG, "Event log is not mounted");
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    taskENTER_CRITICAL(&buf_lock);
+    buf_len = 0;
+    buf_dropped = 0;
+    taskEXIT_CRITICAL(&buf_lock);
+    esp_err_t ret = esp_partition_erase_range(log_part, 0, log_part->size);
+    if (ret == ESP_OK) {
+        ret = bsp_evlog_start_sector(0, 1);
+    }
+    xSemaphoreGive(log_lock);
+    return ret;
+}
+
+void bsp_evlog_battery_sample(uint32_t mv)
+{
+    if (log_part == NULL) {
+        return;
+    }
+    const int64_t now = esp_timer_get_time();
+    if (last_battery_us != 0 && now - last_battery_us < (int64_t)CONFIG_BSP_EVLOG_BATTERY_INTERVAL_S * 1000000) {
+        return;
+    }
+    last_battery_us = now;
+    bsp_evlog_append(BSP_EVLOG_BATTERY, mv, 0, false);
+}
+
+void bsp_evlog_i2c_error(uint8_t addr, esp_err_t err)
+{
+    if (log_part != NULL) {
+        bsp_evlog_append(BSP_EVLOG_I2C_ERROR, addr, (uint32_t)err, false);
+    }
+}
+
+#else /* !CONFIG_BSP_EVLOG */
+
+esp_err_t bsp_evlog_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_evlog_write(uint8_t type, uint32_t arg0, uint32_t arg1)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_evlog_flush(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_evlog_dump(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_evlog_erase(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void bsp_evlog_battery_sample(uint32_t mv)
+{
+}
+
+void bsp_evlog_i2c_error(uint8_t addr, esp_err_t err)
+{
+}
+
+#endif /* CONFIG_BSP_EVLOG */
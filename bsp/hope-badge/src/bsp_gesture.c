@@ -0,0 +1,574 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_gesture.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_GESTURE
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_power.h"
+#include "bsp/bsp_metrics.h"
+#include "bsp/bsp_trace.h"
+
+static const char *TAG = "BSP-GESTURE";
+
+#define BSP_GESTURE_EXPANDER_MASK   0x0000FF00UL
+#define BSP_GESTURE_ADDON_MASK      0xFFFF0000UL
+
+/* Matching progress of one table entry */
+typedef struct {
+    uint8_t step;               // Type specific, 0 = idle
+    int64_t deadline_us;        // 0 = no timeout pending
+} bsp_gesture_state_t;
+
+/* LONG_PRESS and CHORD steps */
+#define BSP_GESTURE_STEP_ARMED  1
+#define BSP_GESTURE_STEP_DONE   2       // Fired or spoiled, idle again once the inputs are released
+
+static bsp_gesture_config_t gesture_config;
+static bsp_gesture_state_t gesture_state[CONFIG_BSP_GESTURE_MAX];
+static TaskHandle_t gesture_task = NULL;
+static volatile bool gesture_stop = false;
+static volatile uint32_t gesture_inputs = 0;
+static uint32_t expander_inputs = 0;
+static portMUX_TYPE gesture_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool gesture_isr_added = false;
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t gesture_task_buf;
+static StackType_t gesture_task_stack[BSP_GESTURE_TASK_STACK_SIZE];
+#endif
+
+static int64_t bsp_gesture_time_us(const bsp_gesture_t *g)
+{
+    uint32_t ms = g->time_ms;
+    if (ms == 0) {
+        ms = (g->type == BSP_GESTURE_LONG_PRESS) ? CONFIG_BSP_GESTURE_LONG_MS :
+             (g->type == BSP_GESTURE_CHORD) ? CONFIG_BSP_GESTURE_CHORD_MS : CONFIG_BSP_GESTURE_GAP_MS;
+    }
+    return (int64_t)ms * 1000;
+}
+
+static void bsp_gesture_fire(const bsp_gesture_t *g)
+{
+    bsp_metrics_inc(BSP_METRIC_GESTURES);
+    if (g->callback) {
+        g->callback(g, g->user_arg);
+    }
+}
+
+static void bsp_gesture_on_release(const bsp_gesture_t *g, bsp_gesture_state_t *s, uint32_t pressed)
+{
+    switch (g->type) {
+    case BSP_GESTURE_LONG_PRESS:
+        if ((pressed & g->inputs) != g->inputs) {
+            s->step = 0;
+            s->deadline_us = 0;
+        }
+        break;
+    case BSP_GESTURE_CHORD:
+        if ((pressed & g->inputs) == 0) {
+            s->step = 0;
+            s->deadline_us = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Wrong input in a sequence: continue from the longest tail of the steps matched so far that is also a start
+ * of the sequence and accepts this press, so A A A B still completes A A B. Return false if there is none.
+ */
+static bool bsp_gesture_sequence_fallback(const bsp_gesture_t *g, bsp_gesture_state_t *s, uint32_t down)
+{
+    for (int k = (int)s->step - 1; k >= 0; k--) {
+        if (down & ~g->sequence[k]) {
+            continue;
+        }
+        if (memcmp(g->sequence, &g->sequence[s->step - k], k * sizeof(g->sequence[0])) == 0) {
+            s->step = k;
+            return true;
+        }
+    }
+    s->step = 0;
+    return false;
+}
+
+static void bsp_gesture_on_press(const bsp_gesture_t *g, bsp_gesture_state_t *s, uint32_t pressed, uint32_t down,
+                                 int64_t now)
+{
+    switch (g->type) {
+    case BSP_GESTURE_PRESS:
+        if (down & g->inputs) {
+            bsp_gesture_fire(g);
+        }
+        break;
+
+    case BSP_GESTURE_MULTI_PRESS:
+        if (!(down & g->inputs)) {
+            s->step = 0;
+            s->deadline_us = 0;
+            break;
+        }
+        s->step = (s->step != 0 && now <= s->deadline_us) ? s->step + 1 : 1;
+        s->deadline_us = now + bsp_gesture_time_us(g);
+        if (s->step >= g->count) {
+            s->step = 0;
+            s->deadline_us = 0;
+            bsp_gesture_fire(g);
+        }
+        break;
+
+    case BSP_GESTURE_LONG_PRESS:
+        if (s->step == 0 && (pressed & g->inputs) == g->inputs && !(pressed & ~g->inputs)) {
+            s->step = BSP_GESTURE_STEP_ARMED;
+            s->deadline_us = now + bsp_gesture_time_us(g);
+        } else if (s->step == BSP_GESTURE_STEP_ARMED && (down & ~g->inputs)) {
+            s->step = BSP_GESTURE_STEP_DONE;    // Another input joined, this is some other gesture
+            s->deadline_us = 0;
+        }
+        break;
+
+    case BSP_GESTURE_CHORD:
+        if (s->step == 0 && (down & g->inputs)) {
+            s->step = BSP_GESTURE_STEP_ARMED;
+            s->deadline_us = now + bsp_gesture_time_us(g);
+        }
+        if (s->step != BSP_GESTURE_STEP_ARMED) {
+            break;
+        }
+        if (pressed & ~g->inputs) {
+            s->step = BSP_GESTURE_STEP_DONE;
+            s->deadline_us = 0;
+        } else if ((pressed & g->inputs) == g->inputs) {
+            s->step = BSP_GESTURE_STEP_DONE;
+            s->deadline_us = 0;
+            bsp_gesture_fire(g);
+        }
+        break;
+
+    case BSP_GESTURE_SEQUENCE:
+        if (down & ~g->sequence[s->step]) {
+            if (!bsp_gesture_sequence_fallback(g, s, down)) {
+                s->deadline_us = 0;
+                break;
+            }
+        }
+        if ((pressed & g->sequence[s->step]) == g->sequence[s->step]) {
+            s->step++;
+            s->deadline_us = now + bsp_gesture_time_us(g);
+            if (s->step >= g->count) {
+                s->step = 0;
+                s->deadline_us = 0;
+                bsp_gesture_fire(g);
+            }
+        }
+        break;
+
+    case BSP_GESTURE_COMBO:
+        if ((down & g->trigger) && (pressed & g->trigger) == g->trigger && (pressed & g->inputs) == g->inputs) {
+            bsp_gesture_fire(g);
+        }
+        break;
+    }
+}
+
+/* Handle timeouts due at now, return the next deadline or 0 */
+static int64_t bsp_gesture_expire(int64_t now)
+{
+    int64_t next = 0;
+    for (size_t i = 0; i < gesture_config.num_gestures; i++) {
+        const bsp_gesture_t *g = &gesture_config.gestures[i];
+        bsp_gesture_state_t *s = &gesture_state[i];
+        if (s->deadline_us == 0) {
+            continue;
+        }
+        if (now >= s->deadline_us) {
+            s->deadline_us = 0;
+            if (g->type == BSP_GESTURE_LONG_PRESS) {
+                s->step = BSP_GESTURE_STEP_DONE;
+                bsp_gesture_fire(g);
+            } else if (g->type == BSP_GESTURE_CHORD) {
+                s->step = BSP_GESTURE_STEP_DONE;    // Too slow, wait for the release
+            } else {
+                s->step = 0;
+            }
+            continue;
+        }
+        if (next == 0 || s->deadline_us < next) {
+            next = s->deadline_us;
+        }
+    }
+    return next;
+}
+
+static void bsp_gesture_update(uint32_t old_pressed, uint32_t pressed, int64_t now)
+{
+    const uint32_t changed = old_pressed ^ pressed;
+    const uint32_t down = changed & pressed;
+    const uint32_t up = changed & old_pressed;
+
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        if (changed & BSP_GESTURE_BUTTON(i)) {
+            if (down & BSP_GESTURE_BUTTON(i)) {
+                bsp_metrics_inc(BSP_METRIC_BUTTON_EVENTS);
+                bsp_trace_event(BSP_TRACE_BUTTON_DOWN, i, 0);
+            } else {
+                bsp_trace_event(BSP_TRACE_BUTTON_UP, i, 0);
+            }
+        }
+    }
+
+    if (gesture_config.input_cb) {
+        gesture_config.input_cb(pressed, changed, gesture_config.user_arg);
+    }
+
+    for (size_t i = 0; i < gesture_config.num_gestures; i++) {
+        if (up) {
+            bsp_gesture_on_release(&gesture_config.gestures[i], &gesture_state[i], pressed);
+        }
+        if (down) {
+            bsp_gesture_on_press(&gesture_config.gestures[i], &gesture_state[i], pressed, down, now);
+        }
+    }
+}
+
+static uint32_t bsp_gesture_read_buttons(void)
+{
+    const bsp_board_desc_t *desc = bsp_get_board_desc();
+    uint32_t pressed = 0;
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        if (desc->buttons[i].gpio >= 0 &&
+                gpio_get_level((gpio_num_t)desc->buttons[i].gpio) == desc->buttons[i].active_level) {
+            pressed |= BSP_GESTURE_BUTTON(i);
+        }
+    }
+    return pressed;
+}
+
+/* Arm every button for the transition away from its debounced level */
+static void bsp_gesture_arm(uint32_t pressed)
+{
+    const bsp_board_desc_t *desc = bsp_get_board_desc();
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        const gpio_num_t gpio = (gpio_num_t)desc->buttons[i].gpio;
+        if (desc->buttons[i].gpio < 0) {
+            continue;
+        }
+        const bool is_pressed = (pressed & BSP_GESTURE_BUTTON(i)) != 0;
+        const gpio_int_type_t type = (is_pressed == (desc->buttons[i].active_level != 0)) ?
+                                     GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+#if CONFIG_BSP_PM_LIGHT_SLEEP
+        gpio_wakeup_enable(gpio, type);     // Sets the interrupt type as well
+#else
+        gpio_set_intr_type(gpio, type);
+#endif
+        gpio_intr_enable(gpio);
+    }
+}
+
+static void IRAM_ATTR bsp_gesture_isr(void *arg)
+{
+    // Level interrupt: stays off until the task has read the pin and re-armed it
+    gpio_intr_disable((gpio_num_t)(uintptr_t)arg);
+    TaskHandle_t task = gesture_task;
+    if (task != NULL) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+static void bsp_gesture_expander_update(pcf8574_handle_t dev, uint16_t value)
+{
+    uint32_t field;
+    int shift;
+    if (dev == bsp_pcf8574_get_handle_at(0)) {
+        field = BSP_GESTURE_EXPANDER_MASK;
+        shift = 8;
+    } else if (bsp_pcf8574_get_count() > 1 && dev == bsp_pcf8574_get_handle_at(1)) {
+        field = BSP_GESTURE_ADDON_MASK;
+        shift = 16;
+    } else {
+        return;
+    }
+
+    // Expander inputs are quasi-bidirectional with a weak pull-up: pressed pulls them LOW
+    uint16_t input_mask = 0;
+    pcf8574_get_direction_port(dev, &input_mask);
+    const uint32_t bits = ((uint32_t)(uint16_t)(~value & input_mask) << shift) & field;
+
+    taskENTER_CRITICAL(&gesture_lock);
+    expander_inputs = (expander_inputs & ~field) | bits;
+    taskEXIT_CRITICAL(&gesture_lock);
+}
+
+static void bsp_gesture_expander_cb(pcf8574_handle_t dev, uint16_t value, uint16_t changed, void *arg)
+{
+    bsp_gesture_expander_update(dev, value);
+    TaskHandle_t task = gesture_task;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static uint32_t bsp_gesture_read_inputs(void)
+{
+    taskENTER_CRITICAL(&gesture_lock);
+    const uint32_t expanders = expander_inputs;
+    taskEXIT_CRITICAL(&gesture_lock);
+    return bsp_gesture_read_buttons() | expanders;
+}
+
+static void bsp_gesture_task(void *arg)
+{
+    // Inputs already held at start do not count as presses
+    uint32_t pressed = bsp_gesture_read_inputs();
+    gesture_inputs = pressed;
+    bsp_gesture_arm(pressed);
+
+    TickType_t wait = portMAX_DELAY;
+    while (!gesture_stop) {
+        if (ulTaskNotifyTake(pdTRUE, wait) != 0 && !gesture_stop) {
+            // Let the contacts settle, edges meanwhile are covered by the read below
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_BSP_GESTURE_DEBOUNCE_MS));
+            ulTaskNotifyTake(pdTRUE, 0);
+        }
+        if (gesture_stop) {
+            break;
+        }
+
+        const int64_t now = esp_timer_get_time();
+        bsp_gesture_expire(now);
+        const uint32_t now_pressed = bsp_gesture_read_inputs();
+        if (now_pressed != pressed) {
+            gesture_inputs = now_pressed;
+            bsp_gesture_update(pressed, now_pressed, now);
+            pressed = now_pressed;
+        }
+        // A callback may have stopped the recognizer and removed the ISR handlers
+        if (gesture_stop) {
+            break;
+        }
+        bsp_gesture_arm(pressed);
+
+        const int64_t next = bsp_gesture_expire(now);
+        wait = (next == 0) ? portMAX_DELAY : pdMS_TO_TICKS((next - now + 999) / 1000) + 1;
+    }
+
+    gesture_task = NULL;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t bsp_gesture_check_table(const bsp_gesture_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config->num_gestures <= CONFIG_BSP_GESTURE_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "Table has %u entries, at most %d", (unsigned)config->num_gestures, CONFIG_BSP_GESTURE_MAX);
+    ESP_RETURN_ON_FALSE(config->num_gestures == 0 || config->gestures != NULL, ESP_ERR_INVALID_ARG, TAG,
+                        "Table is required");
+    for (size_t i = 0; i < config->num_gestures; i++) {
+        const bsp_gesture_t *g = &config->gestures[i];
+        bool valid;
+        switch (g->type) {
+        case BSP_GESTURE_MULTI_PRESS:
+            valid = g->inputs != 0 && g->count >= 2;
+            break;
+        case BSP_GESTURE_SEQUENCE:
+            valid = g->sequence != NULL && g->count >= 1;
+            for (uint8_t step = 0; valid && step < g->count; step++) {
+                valid = g->sequence[step] != 0;
+            }
+            break;
+        case BSP_GESTURE_COMBO:
+            valid = g->inputs != 0 && g->trigger != 0 && !(g->inputs & g->trigger);
+            break;
+        case BSP_GESTURE_PRESS:
+        case BSP_GESTURE_LONG_PRESS:
+        case BSP_GESTURE_CHORD:
+            valid = g->inputs != 0;
+            break;
+        default:
+            valid = false;
+            break;
+        }
+        ESP_RETURN_ON_FALSE(valid, ESP_ERR_INVALID_ARG, TAG, "Invalid gesture %u", (unsigned)i);
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_gesture_buttons_init(void)
+{
+    const bsp_board_desc_t *desc = bsp_get_board_desc();
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        if (desc->buttons[i].gpio < 0) {
+            continue;
+        }
+        // Pull towards the released level, interrupts are armed by bsp_gesture_start()
+        const gpio_config_t io_conf = {
+            .pin_bit_mask = (1ULL << desc->buttons[i].gpio),
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = desc->buttons[i].active_level ? GPIO_PULLUP_DISABLE : GPIO_PULLUP_ENABLE,
+            .pull_down_en = desc->buttons[i].active_level ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        ESP_RETURN_ON_ERROR(gpio_config(&io_conf), TAG, "Failed to configure button %d", i + 1);
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_gesture_start(const bsp_gesture_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config != NULL, ESP_ERR_INVALID_ARG, TAG, "Config is required");
+    ESP_RETURN_ON_FALSE(gesture_task == NULL, ESP_ERR_INVALID_STATE, TAG, "Already running");
+    ESP_RETURN_ON_ERROR(bsp_gesture_check_table(config), TAG, "Invalid gesture table");
+
+    gesture_config = *config;
+    memset(gesture_state, 0, sizeof(gesture_state));
+    expander_inputs = 0;
+    gesture_stop = false;
+
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        ret = ESP_OK;   // Already installed
+    }
+    const bsp_board_desc_t *desc = bsp_get_board_desc();
+    for (int i = 0; i < BSP_BUTTON_NUM && ret == ESP_OK; i++) {
+        if (desc->buttons[i].gpio < 0) {
+            continue;
+        }
+        gpio_intr_disable((gpio_num_t)desc->buttons[i].gpio);
+        ret = gpio_isr_handler_add((gpio_num_t)desc->buttons[i].gpio, bsp_gesture_isr,
+                                   (void *)(uintptr_t)desc->buttons[i].gpio);
+        if (ret == ESP_OK) {
+            gesture_isr_added = true;
+        }
+    }
+#if CONFIG_BSP_PM_LIGHT_SLEEP
+    if (ret == ESP_OK) {
+        ret = esp_sleep_enable_gpio_wakeup();
+    }
+#endif
+
+    if (ret == ESP_OK && config->expanders) {
+        ret = bsp_pcf8574_start_events(bsp_gesture_expander_cb, NULL);
+        // The group reports changes only, take the current state once
+        for (uint8_t i = 0; i < bsp_pcf8574_get_count() && i < 2 && ret == ESP_OK; i++) {
+            pcf8574_handle_t dev = bsp_pcf8574_get_handle_at(i);
+            uint16_t value;
+            bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
+            ret = pcf8574_read_port(dev, &value);
+            bsp_power_lock_release(BSP_PM_LOCK_I2C);
+            if (ret == ESP_OK) {
+                bsp_gesture_expander_update(dev, value);
+            }
+        }
+    }
+
+    if (ret == ESP_OK) {
+        TaskHandle_t task = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+        task = xTaskCreateStatic(bsp_gesture_task, "bsp_gesture", BSP_GESTURE_TASK_STACK_SIZE, NULL,
+                                 config->task_priority, gesture_task_stack, &gesture_task_buf);
+#else
+        xTaskCreate(bsp_gesture_task, "bsp_gesture", BSP_GESTURE_TASK_STACK_SIZE, NULL, config->task_priority, &task);
+#endif
+        gesture_task = task;
+        if (task == NULL) {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start gesture recognizer: %s", esp_err_to_name(ret));
+        bsp_gesture_stop();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Recognizing %u gestures", (unsigned)config->num_gestures);
+    return ESP_OK;
+}
+
+esp_err_t bsp_gesture_stop(void)
+{
+    if (gesture_config.expanders) {
+        bsp_pcf8574_stop_events();
+        gesture_config.expanders = false;
+    }
+
+    // Let the task finish, it may be inside a callback
+    gesture_stop = true;
+    TaskHandle_t task = gesture_task;
+    // From a callback the task cannot be waited for: it exits once the callback returns
+    if (task != NULL && task != xTaskGetCurrentTaskHandle()) {
+        while ((task = gesture_task) != NULL) {
+            xTaskNotifyGive(task);
+            vTaskDelay(1);
+        }
+    }
+
+    if (gesture_isr_added) {
+        const bsp_board_desc_t *desc = bsp_get_board_desc();
+        for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+            if (desc->buttons[i].gpio < 0) {
+                continue;
+            }
+            gpio_intr_disable((gpio_num_t)desc->buttons[i].gpio);
+#if CONFIG_BSP_PM_LIGHT_SLEEP
+            gpio_wakeup_disable((gpio_num_t)desc->buttons[i].gpio);
+#endif
+            gpio_isr_handler_remove((gpio_num_t)desc->buttons[i].gpio);
+        }
+        gesture_isr_added = false;
+    }
+    gesture_inputs = 0;
+    return ESP_OK;
+}
+
+uint32_t bsp_gesture_get_inputs(void)
+{
+    return gesture_inputs;
+}
+
+#else /* !CONFIG_BSP_GESTURE */
+
+esp_err_t bsp_gesture_buttons_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_gesture_start(const bsp_gesture_config_t *config)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_gesture_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint32_t bsp_gesture_get_inputs(void)
+{
+    return 0;
+}
+
+#endif /* CONFIG_BSP_GESTURE */
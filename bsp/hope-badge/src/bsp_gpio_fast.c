@@ -0,0 +1,76 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "driver/gpio.h"
+
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_gpio_fast.h"
+
+static const char *TAG = "BSP-GPIO-FAST";
+
+static uint32_t fast_mask = 0;
+
+#define BSP_DESC_BIT(gpio)  (((gpio) >= 0) ? BSP_GPIO_FAST_BIT(gpio) : 0UL)
+
+/* Pins the fast path must not touch: buses, inputs and outputs driven by peripherals */
+static uint32_t bsp_gpio_fast_reserved_mask(void)
+{
+    const bsp_board_desc_t *desc = bsp_get_board_desc();
+    uint32_t mask = BSP_DESC_BIT(desc->i2c.scl) | BSP_DESC_BIT(desc->i2c.sda) |
+                    BSP_DESC_BIT(desc->led_rgb.gpio) |
+                    BSP_DESC_BIT(desc->irda.tx) | BSP_DESC_BIT(desc->irda.rx) |
+                    BSP_DESC_BIT(desc->pcf8574_int_gpio) | BSP_DESC_BIT(desc->fuel_gauge_alrt_gpio);
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        mask |= BSP_DESC_BIT(desc->buttons[i].gpio);
+    }
+    return mask;
+}
+
+esp_err_t bsp_gpio_fast_init(uint32_t mask)
+{
+    const bsp_board_desc_t *desc = bsp_get_board_desc();
+    const uint32_t owned = BSP_DESC_BIT(desc->led.gpio) | BSP_DESC_BIT(desc->vibramotor_gpio);
+    const uint32_t reserved = bsp_gpio_fast_reserved_mask();
+
+    for (int gpio = 0; gpio < 32; gpio++) {
+        if (!(mask & BSP_GPIO_FAST_BIT(gpio))) {
+            continue;
+        }
+        ESP_RETURN_ON_FALSE(GPIO_IS_VALID_OUTPUT_GPIO(gpio), ESP_ERR_INVALID_ARG, TAG,
+                            "GPIO %d is not output capable", gpio);
+        ESP_RETURN_ON_FALSE(!(reserved & BSP_GPIO_FAST_BIT(gpio)), ESP_ERR_INVALID_ARG, TAG,
+                            "GPIO %d is used by the BSP", gpio);
+    }
+
+    // LED and vibration motor pins are configured by their own init functions
+    const uint32_t spare = mask & ~owned & ~fast_mask;
+    if (spare) {
+        gpio_config_t io_config = {
+            .pin_bit_mask = spare,
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        ESP_RETURN_ON_ERROR(gpio_config(&io_config), TAG, "Failed to configure GPIOs");
+        bsp_gpio_fast_write_mask(spare, 0);
+    }
+
+    fast_mask |= mask;
+    return ESP_OK;
+}
+
+uint32_t bsp_gpio_fast_get_mask(void)
+{
+    return fast_mask;
+}
@@ -7,15 +7,29 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 #include <stdbool.h>
+#include <string.h>
 
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include "bsp/bsp_hope.h"
+#include "bsp/bsp_power.h"
+#include "bsp/bsp_metrics.h"
+#include "bsp/bsp_trace.h"
+#include "bsp/bsp_settings.h"
+#include "bsp/bsp_evlog.h"
 #include "bsp_err_check.h"
+#include "bsp_priv.h"
+#include "bsp_log.h"
 #include "button_gpio.h"
+#include "vibramotor.h"
 
 static const char *TAG = "BSP-HOPE";
 
@@ -26,8 +40,96 @@ static i2c_bus_handle_t i2c_bus = NULL;
 static bool i2c_initialized = false;
 static button_handle_t btn[BSP_BUTTON_NUM] = {NULL};
 static led_strip_handle_t led_rgb_handle = NULL;
+static uint8_t led_rgb_frame[BSP_LED_RGB_PIXELS * 3] = {0};
+#if BSP_CAPS_FUEL_GAUGE
 static max17048_handle_t max17048 = NULL;
+#endif
+#if BSP_CAPS_PCF8574
+#define BSP_PCF8574_ADDON_MAX   (CONFIG_BSP_PCF8574_MAX_DEVICES - 1)
 static pcf8574_handle_t pcf_dev = NULL;
+static pcf8574_handle_t pcf_addon[BSP_PCF8574_ADDON_MAX + 1];  // +1 keeps the array non-empty
+static uint8_t pcf_addon_count = 0;
+static pcf8574_group_handle_t pcf_group = NULL;
+static pcf8574_pattern_handle_t pcf_pattern = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+static pcf8574_static_t pcf_dev_buf;
+static pcf8574_static_t pcf_addon_buf[BSP_PCF8574_ADDON_MAX + 1];
+#endif
+#endif
+
+static bsp_init_stage_t init_stages[BSP_INIT_STAGE_MAX] = {
+    [BSP_INIT_STAGE_I2C] = {.name = "i2c"},
+    [BSP_INIT_STAGE_I2C_SCAN] = {.name = "i2c_scan"},
+    [BSP_INIT_STAGE_LED] = {.name = "led"},
+    [BSP_INIT_STAGE_LED_RGB] = {.name = "led_rgb"},
+    [BSP_INIT_STAGE_BUTTONS] = {.name = "buttons"},
+    [BSP_INIT_STAGE_FUEL_GAUGE] = {.name = "fuel_gauge"},
+    [BSP_INIT_STAGE_PCF8574] = {.name = "pcf8574"},
+    [BSP_INIT_STAGE_POWER] = {.name = "power"},
+};
+
+#if CONFIG_BSP_INIT_LAZY
+#define BSP_INIT_LAZY_RETRY_MS  1000
+
+static SemaphoreHandle_t lazy_init_lock = NULL;
+static StaticSemaphore_t lazy_init_lock_buf;
+#endif
+
+static esp_err_t bsp_init_run_stage(bsp_init_stage_id_t id, esp_err_t (*init_fn)(void))
+{
+    bsp_init_stage_t *stage = &init_stages[id];
+    stage->start_us = esp_timer_get_time();
+    stage->err = init_fn();
+    stage->duration_us = esp_timer_get_time() - stage->start_us;
+    stage->done = true;
+    ESP_LOGD(TAG, "Stage %s took %lld us", stage->name, (long long)stage->duration_us);
+    return stage->err;
+}
+
+/* Run a deferred init stage on first use (CONFIG_BSP_INIT_LAZY only) */
+static void bsp_init_lazy(bsp_init_stage_id_t id, esp_err_t (*init_fn)(void))
+{
+#if CONFIG_BSP_INIT_LAZY
+    if (init_stages[id].done) {
+        return;
+    }
+    if (lazy_init_lock) {
+        xSemaphoreTake(lazy_init_lock, portMAX_DELAY);
+    }
+    // A failed stage is retried on a later use, but not more often than BSP_INIT_LAZY_RETRY_MS
+    bsp_init_stage_t *stage = &init_stages[id];
+    const bool retry_due = stage->start_us == 0 ||
+                           esp_timer_get_time() - stage->start_us >= BSP_INIT_LAZY_RETRY_MS * 1000LL;
+    if (!stage->done && retry_due) {
+        esp_err_t err = bsp_init_run_stage(id, init_fn);
+        if (err != ESP_OK) {
+            stage->done = false;
+            ESP_LOGW(TAG, "Lazy init of %s failed: %s", stage->name, esp_err_to_name(err));
+        }
+    }
+    if (lazy_init_lock) {
+        xSemaphoreGive(lazy_init_lock);
+    }
+#endif
+}
+
+const bsp_init_stage_t *bsp_init_get_stages(void)
+{
+    return init_stages;
+}
+
+void bsp_init_print_stages(void)
+{
+    for (int i = 0; i < BSP_INIT_STAGE_MAX; i++) {
+        const bsp_init_stage_t *stage = &init_stages[i];
+        if (!stage->done) {
+            ESP_LOGI(TAG, "%-10s not run", stage->name);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-10s start %8lld us, took %7lld us (%s)", stage->name,
+                 (long long)stage->start_us, (long long)stage->duration_us, esp_err_to_name(stage->err));
+    }
+}
 
 esp_err_t bsp_i2c_init(void)
 {
@@ -56,6 +158,11 @@ esp_err_t bsp_i2c_init(void)
     return ESP_OK;
 }
 
+i2c_bus_handle_t bsp_i2c_get_handle(void)
+{
+    return i2c_bus;
+}
+
 esp_err_t bsp_i2c_deinit(void)
 {
     // Check if I2C bus is initialized
@@ -89,8 +196,27 @@ button_handle_t bsp_get_button_handle(uint8_t btn_num)
     return btn[btn_num];
 }
 
+#if (CONFIG_BSP_METRICS || CONFIG_BSP_TRACE) && !CONFIG_BSP_GESTURE
+static void bsp_button_down_cb(void *button_handle, void *usr_data)
+{
+    bsp_metrics_inc(BSP_METRIC_BUTTON_EVENTS);
+    bsp_trace_event(BSP_TRACE_BUTTON_DOWN, (uint8_t)(uintptr_t)usr_data, 0);
+}
+#endif
+
+#if CONFIG_BSP_TRACE && !CONFIG_BSP_GESTURE
+static void bsp_button_up_cb(void *button_handle, void *usr_data)
+{
+    bsp_trace_event(BSP_TRACE_BUTTON_UP, (uint8_t)(uintptr_t)usr_data, 0);
+}
+#endif
+
 esp_err_t bsp_buttons_init(void)
 {
+#if CONFIG_BSP_GESTURE
+    // The gesture recognizer reads the buttons itself, no iot_button devices
+    return bsp_gesture_buttons_init();
+#else
     // Initialize button 1
     button_config_t btn_1_cfg = {0};
     button_gpio_config_t btn_1_gpio_cfg = {
@@ -121,9 +247,8 @@ esp_err_t bsp_buttons_init(void)
         return ret;
     }
 
-    // Uncomment the following lines if you are not using USB
-
-    /*
+#if CONFIG_BSP_BUTTONS_3_4
+    // Buttons 3 and 4 share the USB D-/D+ pins
     button_config_t btn_3_cfg = {0};
     button_gpio_config_t btn_3_gpio_cfg = {
         .gpio_num = BSP_BUTTON_3_GPIO,
@@ -151,13 +276,30 @@ esp_err_t bsp_buttons_init(void)
         ESP_LOGE(TAG, "Failed to initialize button 4: %s", esp_err_to_name(ret));
         return ret;
     }
-    */
+#endif
+
+    // Count and trace button activity alongside the application callbacks
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        if (btn[i] == NULL) {
+            continue;
+        }
+#if CONFIG_BSP_METRICS || CONFIG_BSP_TRACE
+        iot_button_register_cb(btn[i], BUTTON_PRESS_DOWN, NULL, bsp_button_down_cb, (void *)(uintptr_t)i);
+#endif
+#if CONFIG_BSP_TRACE
+        iot_button_register_cb(btn[i], BUTTON_PRESS_UP, NULL, bsp_button_up_cb, (void *)(uintptr_t)i);
+#endif
+    }
 
     return ret;
+#endif
 }
 
 esp_err_t bsp_led_init(void)
 {
+#if CONFIG_BSP_LED_PWM
+    return bsp_led_pwm_init();
+#else
     // Initialize the LED GPIO
     gpio_config_t led_config = {
         .pin_bit_mask = (1ULL << BSP_LED_IO),
@@ -169,23 +311,24 @@ esp_err_t bsp_led_init(void)
     BSP_ERROR_CHECK_RETURN_ERR(gpio_config(&led_config));
 
     // Set the LED to off initially
-    BSP_ERROR_CHECK_RETURN_ERR(gpio_set_level(BSP_LED_IO, 0));
+    BSP_ERROR_CHECK_RETURN_ERR(gpio_set_level(BSP_LED_IO, !CONFIG_BSP_LED_ACTIVE_LEVEL));
 
     return ESP_OK;
+#endif
 }
 
 esp_err_t bsp_gpio_set_level(gpio_num_t gpio_num, uint32_t level)
 {
     // Check if the GPIO number is valid
     if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
-        ESP_LOGE(TAG, "Invalid GPIO number: %d", gpio_num);
+        BSP_LOGE_FAST("Invalid GPIO number: %d", ESP_OK, gpio_num);
         return ESP_ERR_INVALID_ARG;
     }
 
     // Set the GPIO level
     esp_err_t ret = gpio_set_level(gpio_num, level);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set GPIO level: %s", esp_err_to_name(ret));
+        BSP_LOGE_FAST("Failed to set GPIO %d level", ret, gpio_num);
         return ret;
     }
 
@@ -196,7 +339,7 @@ int8_t bsp_gpio_get_level(gpio_num_t gpio_num)
 {
     // Check if the GPIO number is valid
     if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
-        ESP_LOGE(TAG, "Invalid GPIO number: %d", gpio_num);
+        BSP_LOGE_FAST("Invalid GPIO number: %d", ESP_OK, gpio_num);
         return -1; // Return -1 for invalid GPIO number
     }
 
@@ -209,12 +352,119 @@ int8_t bsp_gpio_get_level(gpio_num_t gpio_num)
 led_strip_handle_t bsp_get_led_rgb_handle(void)
 {
     if (led_rgb_handle == NULL) {
-        ESP_LOGE(TAG, "RGB LED handle is not initialized");
+        bsp_init_lazy(BSP_INIT_STAGE_LED_RGB, bsp_init_led_rgb);
+    }
+    if (led_rgb_handle == NULL) {
+        BSP_LOGE_FAST("RGB LED handle is not initialized", ESP_OK, 0);
         return NULL;
     }
     return led_rgb_handle;
 }
 
+const uint8_t *bsp_led_rgb_get_frame(void)
+{
+    return led_rgb_frame;
+}
+
+esp_err_t bsp_led_rgb_set_pixel(uint32_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
+    if (led_rgb_handle == NULL) {
+        bsp_init_lazy(BSP_INIT_STAGE_LED_RGB, bsp_init_led_rgb);
+    }
+    if (led_rgb_handle == NULL) {
+        BSP_LOGE_FAST("RGB LED handle is not initialized", ESP_OK, 0);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (index >= BSP_LED_RGB_PIXELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bsp_led_rgb_front_take(BSP_LED_RGB_WAIT_FOREVER);
+    led_rgb_frame[index * 3 + 0] = red;
+    led_rgb_frame[index * 3 + 1] = green;
+    led_rgb_frame[index * 3 + 2] = blue;
+
+    esp_err_t ret = led_strip_set_pixel(led_rgb_handle, index, red, green, blue);
+    bsp_led_rgb_front_give();
+    return ret;
+}
+
+esp_err_t bsp_led_rgb_write_frame(const bsp_rgb_t *frame, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        led_rgb_frame[i * 3 + 0] = frame[i].r;
+        led_rgb_frame[i * 3 + 1] = frame[i].g;
+        led_rgb_frame[i * 3 + 2] = frame[i].b;
+        ESP_RETURN_ON_ERROR(led_strip_set_pixel(led_rgb_handle, i, frame[i].r, frame[i].g, frame[i].b), TAG,
+                            "Failed to set pixel");
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_rgb_clear(void)
+{
+    if (led_rgb_handle == NULL) {
+        bsp_init_lazy(BSP_INIT_STAGE_LED_RGB, bsp_init_led_rgb);
+    }
+    if (led_rgb_handle == NULL) {
+        BSP_LOGE_FAST("RGB LED handle is not initialized", ESP_OK, 0);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bsp_led_rgb_front_take(BSP_LED_RGB_WAIT_FOREVER);
+    memset(led_rgb_frame, 0, sizeof(led_rgb_frame));
+
+    bsp_power_lock_acquire(BSP_PM_LOCK_LED);
+    esp_err_t ret = led_strip_clear(led_rgb_handle);
+    bsp_power_lock_release(BSP_PM_LOCK_LED);
+    bsp_led_rgb_front_give();
+
+    return ret;
+}
+
+esp_err_t bsp_led_rgb_refresh(void)
+{
+    if (led_rgb_handle == NULL) {
+        bsp_init_lazy(BSP_INIT_STAGE_LED_RGB, bsp_init_led_rgb);
+    }
+    if (led_rgb_handle == NULL) {
+        BSP_LOGE_FAST("RGB LED handle is not initialized", ESP_OK, 0);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bsp_led_rgb_front_take(BSP_LED_RGB_WAIT_FOREVER);
+    esp_err_t ret = bsp_led_rgb_refresh_locked();
+    bsp_led_rgb_front_give();
+    return ret;
+}
+
+esp_err_t bsp_led_rgb_refresh_locked(void)
+{
+    // Dim the whole frame to the brightness setting, further when load shedding caps the LED current
+    static uint8_t applied_scale = 255;
+    const uint8_t brightness = (uint8_t)bsp_settings_get(BSP_SETTING_LED_RGB_BRIGHTNESS);
+    const uint8_t scale = bsp_load_led_scale(led_rgb_frame, sizeof(led_rgb_frame), brightness);
+    if (scale != 255 || applied_scale != 255) {
+        for (uint32_t i = 0; i < BSP_LED_RGB_PIXELS; i++) {
+            led_strip_set_pixel(led_rgb_handle, i, bsp_scale8(led_rgb_frame[i * 3 + 0], scale),
+                                bsp_scale8(led_rgb_frame[i * 3 + 1], scale),
+                                bsp_scale8(led_rgb_frame[i * 3 + 2], scale));
+        }
+        applied_scale = scale;
+    }
+
+    int64_t start = esp_timer_get_time();
+    bsp_trace_event(BSP_TRACE_LED_REFRESH_START, 0, 0);
+    bsp_power_lock_acquire(BSP_PM_LOCK_LED);
+    esp_err_t ret = led_strip_refresh(led_rgb_handle);
+    bsp_power_lock_release(BSP_PM_LOCK_LED);
+    bsp_trace_event(BSP_TRACE_LED_REFRESH_DONE, 0, (uint16_t)ret);
+    bsp_metrics_record_us(BSP_METRIC_LED_RGB_REFRESH_US, (uint32_t)(esp_timer_get_time() - start));
+    bsp_metrics_inc(ret == ESP_OK ? BSP_METRIC_LED_RGB_REFRESHES : BSP_METRIC_LED_RGB_ERRORS);
+
+    return ret;
+}
+
 esp_err_t bsp_init_led_rgb(void)
 {
 
@@ -246,45 +496,95 @@ esp_err_t bsp_init_led_rgb(void)
     }
     ESP_LOGI(TAG, "Created LED strip object with RMT backend");
 
+#if CONFIG_BSP_LED_RGB_ASYNC
+    ret = bsp_led_rgb_async_init();
+    if (ret != ESP_OK) {
+        led_strip_del(led_rgb_handle);
+        led_rgb_handle = NULL;
+        return ret;
+    }
+#endif
+
+    // Show the frame that was on the ring before deep sleep
+    const bsp_retained_state_t *state = bsp_sleep_get_resume_state();
+    if (state != NULL) {
+        for (uint32_t i = 0; i < BSP_LED_RGB_PIXELS; i++) {
+            const uint8_t *px = &state->led_rgb_frame[i * 3];
+            bsp_led_rgb_set_pixel(i, px[0], px[1], px[2]);
+        }
+        bsp_led_rgb_refresh();
+    }
+
     return ESP_OK;
 }
 
+#if BSP_CAPS_FUEL_GAUGE
 float bsp_get_battery_voltage(void)
 {
     if (max17048 == NULL) {
-        ESP_LOGE(TAG, "MAX17048 fuel gauge handle is not initialized");
+        bsp_init_lazy(BSP_INIT_STAGE_FUEL_GAUGE, bsp_fuel_gauge_init);
+    }
+    if (max17048 == NULL) {
+        BSP_LOGE_FAST("MAX17048 fuel gauge handle is not initialized", ESP_OK, 0);
         return -1.0f; // Return an error value
     }
 
     float voltage = 0;
+    int64_t start = esp_timer_get_time();
+    bsp_trace_event(BSP_TRACE_I2C_START, MAX17048_I2C_ADDR_DEFAULT, 0);
+    bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
     esp_err_t ret = max17048_get_cell_voltage(max17048, &voltage);
+    bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    bsp_trace_event(BSP_TRACE_I2C_DONE, MAX17048_I2C_ADDR_DEFAULT, (uint16_t)ret);
+    bsp_metrics_record_us(BSP_METRIC_FUEL_GAUGE_READ_US, (uint32_t)(esp_timer_get_time() - start));
+    bsp_metrics_inc(ret == ESP_OK ? BSP_METRIC_FUEL_GAUGE_READS : BSP_METRIC_FUEL_GAUGE_ERRORS);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get battery voltage: %s", esp_err_to_name(ret));
+        BSP_LOGE_FAST("Failed to get battery voltage", ret, 0);
+        bsp_evlog_i2c_error(MAX17048_I2C_ADDR_DEFAULT, ret);
         return -1.0f; // Return an error value
     }
 
+    bsp_metrics_set(BSP_METRIC_BATTERY_MV, (int32_t)(voltage * 1000.0f));
+    bsp_evlog_battery_sample((uint32_t)(voltage * 1000.0f));
     return voltage;
 }
 
 float bsp_get_battery_percentage(void)
 {
     if (max17048 == NULL) {
-        ESP_LOGE(TAG, "MAX17048 fuel gauge handle is not initialized");
+        bsp_init_lazy(BSP_INIT_STAGE_FUEL_GAUGE, bsp_fuel_gauge_init);
+    }
+    if (max17048 == NULL) {
+        BSP_LOGE_FAST("MAX17048 fuel gauge handle is not initialized", ESP_OK, 0);
         return -1.0f; // Return an error value
     }
 
     float percent = 0;
+    int64_t start = esp_timer_get_time();
+    bsp_trace_event(BSP_TRACE_I2C_START, MAX17048_I2C_ADDR_DEFAULT, 0);
+    bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
     esp_err_t ret = max17048_get_cell_percent(max17048, &percent);
+    bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    bsp_trace_event(BSP_TRACE_I2C_DONE, MAX17048_I2C_ADDR_DEFAULT, (uint16_t)ret);
+    bsp_metrics_record_us(BSP_METRIC_FUEL_GAUGE_READ_US, (uint32_t)(esp_timer_get_time() - start));
+    bsp_metrics_inc(ret == ESP_OK ? BSP_METRIC_FUEL_GAUGE_READS : BSP_METRIC_FUEL_GAUGE_ERRORS);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get battery percentage: %s", esp_err_to_name(ret));
+        BSP_LOGE_FAST("Failed to get battery percentage", ret, 0);
+        bsp_evlog_i2c_error(MAX17048_I2C_ADDR_DEFAULT, ret);
         return -1.0f; // Return an error value
     }
 
+    bsp_metrics_set(BSP_METRIC_BATTERY_PCT, (int32_t)percent);
     return percent;
 }
 
 esp_err_t bsp_fuel_gauge_init(void)
 {
+    if (!bsp_i2c_device_present(MAX17048_I2C_ADDR_DEFAULT)) {
+        ESP_LOGE(TAG, "MAX17048 fuel gauge not found at 0x%02X", MAX17048_I2C_ADDR_DEFAULT);
+        return ESP_ERR_NOT_FOUND;
+    }
+
     // Initialize the MAX17048 fuel gauge
     max17048 = max17048_create(i2c_bus, MAX17048_I2C_ADDR_DEFAULT);
 
@@ -295,18 +595,152 @@ esp_err_t bsp_fuel_gauge_init(void)
 
     return ESP_OK;
 }
+#else
+float bsp_get_battery_voltage(void)
+{
+    return -1.0f;
+}
+
+float bsp_get_battery_percentage(void)
+{
+    return -1.0f;
+}
+
+esp_err_t bsp_fuel_gauge_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif /* BSP_CAPS_FUEL_GAUGE */
+
+esp_err_t bsp_register_button_callbacks(void)
+{
+    ESP_LOGW(TAG, "No button callbacks registered (not implemented)");
+    return ESP_OK;
+}
+
+#if BSP_CAPS_PCF8574
+static volatile bool pcf_probing = false;
+
+/*
+ * Installed for good by bsp_pcf8574_init(): feeds the trace while it is started and logs failed
+ * transfers of every expander. Transfers finish in task context, only INT comes from the ISR.
+ */
+static void IRAM_ATTR bsp_pcf8574_hook(pcf8574_trace_event_t event, uint8_t dev_addr, esp_err_t err)
+{
+    switch (event) {
+    case PCF8574_TRACE_XFER_START:
+        bsp_trace_event(BSP_TRACE_I2C_START, dev_addr, 0);
+        break;
+    case PCF8574_TRACE_XFER_DONE:
+        bsp_trace_event(BSP_TRACE_I2C_DONE, dev_addr, (uint16_t)err);
+        // A probe of an empty address is expected to fail
+        if (err != ESP_OK && !pcf_probing) {
+            bsp_evlog_i2c_error(dev_addr, err);
+        }
+        break;
+    case PCF8574_TRACE_INTERRUPT:
+        bsp_trace_event(BSP_TRACE_EXPANDER_INT, dev_addr, 0);
+        break;
+    }
+}
+
+static pcf8574_handle_t bsp_pcf8574_create(uint8_t addr)
+{
+#if CONFIG_BSP_STATIC_ALLOC
+    return pcf8574_create_static(i2c_bus, addr, &pcf_dev_buf);
+#else
+    return pcf8574_create(i2c_bus, addr);
+#endif
+}
+
+/* One port read: true if a device acknowledges. Also releases the device's INT. */
+static bool bsp_pcf8574_probe(pcf8574_handle_t dev)
+{
+    uint16_t value = 0;
+    bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
+    pcf_probing = true;
+    esp_err_t ret = pcf8574_read_port(dev, &value);
+    pcf_probing = false;
+    bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    return ret == ESP_OK;
+}
+
+/*
+ * Create handles for the add-on expanders, besides the badge one at main_addr. The addresses are
+ * probed directly: add-ons are plugged in and out between boots, so a cached presence map may be stale.
+ */
+static void bsp_pcf8574_add_expanders(uint8_t main_addr)
+{
+    for (uint8_t i = 0; i < 16 && pcf_addon_count < BSP_PCF8574_ADDON_MAX; i++) {
+        uint8_t addr = (i < 8) ? PCF8574_I2C_ADDR_DEFAULT + i : PCF8574A_I2C_ADDR_DEFAULT + i - 8;
+        if (addr == main_addr) {
+            continue;
+        }
+        pcf8574_type_t type = (i < 8) ? PCF8574_TYPE_PCF8574 : PCF8574_TYPE_PCF8574A;
+#if CONFIG_BSP_PCF8575_ADDONS
+        if (i < 8) {
+            type = PCF8574_TYPE_PCF8575;
+        }
+#endif
+#if CONFIG_BSP_STATIC_ALLOC
+        pcf8574_handle_t dev = pcf8574_create_type_static(i2c_bus, addr, type, &pcf_addon_buf[pcf_addon_count]);
+#else
+        pcf8574_handle_t dev = pcf8574_create_type(i2c_bus, addr, type);
+#endif
+        if (dev == NULL) {
+            ESP_LOGW(TAG, "Failed to create add-on expander handle at 0x%02X", addr);
+            continue;
+        }
+        if (!bsp_pcf8574_probe(dev)) {
+            pcf8574_delete(&dev);
+            continue;
+        }
+        pcf_addon[pcf_addon_count++] = dev;
+        ESP_LOGI(TAG, "Add-on %d-bit expander at 0x%02X", pcf8574_get_pin_count(dev), addr);
+    }
+}
 
 esp_err_t bsp_pcf8574_init(void)
 {
-    // Try default PCF8574 address (0x20) first, then PCF8574A address (0x38) as fallback
-    pcf_dev = pcf8574_create(i2c_bus, PCF8574_I2C_ADDR_DEFAULT);
+    pcf8574_set_trace_hook(bsp_pcf8574_hook);
+
+    // On resume from deep sleep, re-attach at the known address: the expander kept its latch
+    const bsp_retained_state_t *state = bsp_sleep_get_resume_state();
+    if (state != NULL) {
+        if (state->pcf8574_addr == 0) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        pcf_dev = bsp_pcf8574_create(state->pcf8574_addr);
+        if (pcf_dev != NULL) {
+            pcf8574_restore_state(pcf_dev, state->pcf8574_output, state->pcf8574_input_mask);
+            ESP_LOGI(TAG, "PCF8574 restored at 0x%02X", state->pcf8574_addr);
+            bsp_pcf8574_add_expanders(state->pcf8574_addr);
+            return ESP_OK;
+        }
+    }
+
+    // A stored address wins while it answers, otherwise the badge expander is a PCF8574 (0x20) or a PCF8574A (0x38)
+    uint8_t addr = (uint8_t)bsp_settings_get(BSP_SETTING_PCF8574_ADDR);
+    if (addr != 0) {
+        pcf_dev = bsp_pcf8574_create(addr);
+        if (pcf_dev != NULL && !bsp_pcf8574_probe(pcf_dev)) {
+            ESP_LOGW(TAG, "No expander at the stored address 0x%02X, probing the default addresses", addr);
+            pcf8574_delete(&pcf_dev);
+        }
+    }
     if (pcf_dev == NULL) {
-        ESP_LOGW(TAG, "PCF8574 not found at 0x%02X, trying PCF8574A at 0x%02X",
-                 PCF8574_I2C_ADDR_DEFAULT, PCF8574A_I2C_ADDR_DEFAULT);
-        pcf_dev = pcf8574_create(i2c_bus, PCF8574A_I2C_ADDR_DEFAULT);
+        static const uint8_t badge_addrs[] = {PCF8574_I2C_ADDR_DEFAULT, PCF8574A_I2C_ADDR_DEFAULT};
+        for (size_t i = 0; i < sizeof(badge_addrs) / sizeof(badge_addrs[0]) && pcf_dev == NULL; i++) {
+            pcf_dev = bsp_pcf8574_create(badge_addrs[i]);
+            if (pcf_dev != NULL && !bsp_pcf8574_probe(pcf_dev)) {
+                pcf8574_delete(&pcf_dev);
+            }
+            addr = badge_addrs[i];
+        }
         if (pcf_dev == NULL) {
-            ESP_LOGE(TAG, "Failed to create PCF8574 handle at either address");
-            return ESP_FAIL;
+            ESP_LOGW(TAG, "No PCF8574 at 0x%02X or PCF8574A at 0x%02X", PCF8574_I2C_ADDR_DEFAULT,
+                     PCF8574A_I2C_ADDR_DEFAULT);
+            return ESP_ERR_NOT_FOUND;
         }
     }
 
@@ -315,89 +749,379 @@ esp_err_t bsp_pcf8574_init(void)
     esp_err_t ret = pcf8574_set_direction(pcf_dev, io_dir_mask);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set PCF8574 direction: %s", esp_err_to_name(ret));
-        pcf_dev = NULL;
+        pcf8574_delete(&pcf_dev);
+        // The presence map is stale (board changed?), scan again on next boot
+        bsp_i2c_scan_invalidate();
         return ret;
     }
 
-    ESP_LOGI(TAG, "PCF8574 initialized successfully");
+    ESP_LOGI(TAG, "PCF8574 initialized successfully at 0x%02X", addr);
+    bsp_pcf8574_add_expanders(addr);
     return ESP_OK;
 }
 
 pcf8574_handle_t bsp_pcf8574_get_handle(void)
 {
     if (pcf_dev == NULL) {
-        ESP_LOGE(TAG, "PCF8574 handle is not initialized");
+        bsp_init_lazy(BSP_INIT_STAGE_PCF8574, bsp_pcf8574_init);
+    }
+    if (pcf_dev == NULL) {
+        BSP_LOGE_FAST("PCF8574 handle is not initialized", ESP_OK, 0);
     }
     return pcf_dev;
 }
 
-esp_err_t bsp_register_button_callbacks(void)
-{
-    ESP_LOGW(TAG, "No button callbacks registered (not implemented)");
-    return ESP_OK;
-}
-
 esp_err_t bsp_pcf8574_read_ios(uint8_t *data)
 {
     if (pcf_dev == NULL) {
-        ESP_LOGE(TAG, "PCF8574 handle is not initialized");
+        bsp_init_lazy(BSP_INIT_STAGE_PCF8574, bsp_pcf8574_init);
+    }
+    if (pcf_dev == NULL) {
+        BSP_LOGE_FAST("PCF8574 handle is not initialized", ESP_OK, 0);
         return ESP_ERR_INVALID_STATE;
     }
     if (data == NULL) {
-        ESP_LOGE(TAG, "Data pointer is NULL");
+        BSP_LOGE_FAST("Data pointer is NULL", ESP_OK, 0);
         return ESP_ERR_INVALID_ARG;
     }
 
-    return pcf8574_read(pcf_dev, data);
+    int64_t start = esp_timer_get_time();
+    bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
+    esp_err_t ret = pcf8574_read(pcf_dev, data);
+    bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    bsp_metrics_record_us(BSP_METRIC_PCF8574_READ_US, (uint32_t)(esp_timer_get_time() - start));
+
+    return ret;
+}
+
+uint8_t bsp_pcf8574_get_count(void)
+{
+    return (pcf_dev != NULL) ? 1 + pcf_addon_count : 0;
+}
+
+pcf8574_handle_t bsp_pcf8574_get_handle_at(uint8_t index)
+{
+    if (index == 0) {
+        return bsp_pcf8574_get_handle();
+    }
+    return (index <= pcf_addon_count) ? pcf_addon[index - 1] : NULL;
 }
 
+esp_err_t bsp_pcf8574_start_events(pcf8574_group_cb_t callback, void *arg)
+{
+    if (BSP_PCF8574_INT_IO < 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (pcf_group != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (bsp_pcf8574_get_handle() == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const pcf8574_group_config_t group_config = {
+        .int_gpio = (gpio_num_t)BSP_PCF8574_INT_IO,
+#if CONFIG_BSP_PM_LIGHT_SLEEP
+        .wakeup = true,
+#endif
+        .task_priority = 5,
+        .callback = callback,
+        .user_arg = arg,
+    };
+    ESP_RETURN_ON_ERROR(pcf8574_group_create(&group_config, &pcf_group), TAG, "Failed to create PCF8574 group");
+
+    // One read per expander on every INT edge
+    esp_err_t ret = ESP_OK;
+    for (uint8_t i = 0; i < bsp_pcf8574_get_count() && ret == ESP_OK; i++) {
+        bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
+        ret = pcf8574_group_add(pcf_group, bsp_pcf8574_get_handle_at(i));
+        bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    }
+    if (ret != ESP_OK) {
+        pcf8574_group_delete(&pcf_group);
+    }
+    return ret;
+}
+
+esp_err_t bsp_pcf8574_stop_events(void)
+{
+    return pcf8574_group_delete(&pcf_group);
+}
+
+esp_err_t bsp_pcf8574_start_patterns(const pcf8574_pattern_config_t *config, pcf8574_pattern_handle_t *ret_handle)
+{
+    if (config == NULL || ret_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pcf_pattern != NULL || bsp_pcf8574_get_handle() == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_RETURN_ON_ERROR(pcf8574_pattern_create(bsp_pcf8574_get_handle(), config, &pcf_pattern), TAG,
+                        "Failed to create PCF8574 pattern engine");
+    *ret_handle = pcf_pattern;
+    return ESP_OK;
+}
+
+esp_err_t bsp_pcf8574_stop_patterns(void)
+{
+    return pcf8574_pattern_delete(&pcf_pattern);
+}
+#else
+esp_err_t bsp_pcf8574_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint8_t bsp_pcf8574_get_count(void)
+{
+    return 0;
+}
+
+pcf8574_handle_t bsp_pcf8574_get_handle_at(uint8_t index)
+{
+    return NULL;
+}
+
+esp_err_t bsp_pcf8574_start_events(pcf8574_group_cb_t callback, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_pcf8574_stop_events(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_pcf8574_start_patterns(const pcf8574_pattern_config_t *config, pcf8574_pattern_handle_t *ret_handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_pcf8574_stop_patterns(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+pcf8574_handle_t bsp_pcf8574_get_handle(void)
+{
+    return NULL;
+}
+
+esp_err_t bsp_pcf8574_read_ios(uint8_t *data)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif /* BSP_CAPS_PCF8574 */
+
+/* Component counters at the last bsp_metrics_reset(), the metrics report the difference */
+#if BSP_CAPS_PCF8574
+static pcf8574_stats_t pcf_stats_base;
+#endif
+#if BSP_CAPS_VIBRAMOTOR
+static vibramotor_stats_t vib_stats_base;
+#endif
+
+#if BSP_CAPS_PCF8574
+/* Totals over the badge and add-on expanders */
+static void bsp_pcf8574_get_total_stats(pcf8574_stats_t *total)
+{
+    *total = (pcf8574_stats_t) {0};
+    for (uint8_t i = 0; i < bsp_pcf8574_get_count(); i++) {
+        pcf8574_stats_t pcf_stats;
+        if (pcf8574_get_stats(i == 0 ? pcf_dev : pcf_addon[i - 1], &pcf_stats) == ESP_OK) {
+            total->reads += pcf_stats.reads;
+            total->writes += pcf_stats.writes;
+            total->errors += pcf_stats.errors;
+            total->interrupts += pcf_stats.interrupts;
+        }
+    }
+}
+#endif
+
+void bsp_metrics_collect_sources(void)
+{
+#if BSP_CAPS_PCF8574
+    pcf8574_stats_t pcf_total;
+    bsp_pcf8574_get_total_stats(&pcf_total);
+    bsp_metrics_set(BSP_METRIC_PCF8574_READS, (int32_t)(pcf_total.reads - pcf_stats_base.reads));
+    bsp_metrics_set(BSP_METRIC_PCF8574_WRITES, (int32_t)(pcf_total.writes - pcf_stats_base.writes));
+    bsp_metrics_set(BSP_METRIC_PCF8574_ERRORS, (int32_t)(pcf_total.errors - pcf_stats_base.errors));
+    bsp_metrics_set(BSP_METRIC_PCF8574_INTERRUPTS, (int32_t)(pcf_total.interrupts - pcf_stats_base.interrupts));
+#endif
+#if BSP_CAPS_VIBRAMOTOR
+    vibramotor_stats_t vib_stats;
+    vibramotor_get_stats(&vib_stats);
+    bsp_metrics_set(BSP_METRIC_VIBRAMOTOR_RUNS, (int32_t)(vib_stats.runs - vib_stats_base.runs));
+    bsp_metrics_set(BSP_METRIC_VIBRAMOTOR_STOPS, (int32_t)(vib_stats.stops - vib_stats_base.stops));
+    bsp_metrics_set(BSP_METRIC_VIBRAMOTOR_ON_MS, (int32_t)(vib_stats.on_ms - vib_stats_base.on_ms));
+#endif
+}
+
+void bsp_metrics_reset_sources(void)
+{
+#if BSP_CAPS_PCF8574
+    bsp_pcf8574_get_total_stats(&pcf_stats_base);
+#endif
+#if BSP_CAPS_VIBRAMOTOR
+    vibramotor_get_stats(&vib_stats_base);
+#endif
+}
+
+#if !CONFIG_BSP_INIT_LAZY
+static esp_err_t bsp_i2c_scan_stage(void)
+{
+    return bsp_i2c_scan(false);
+}
+
+static void bsp_init_i2c_devices(void)
+{
+    bsp_init_run_stage(BSP_INIT_STAGE_I2C_SCAN, bsp_i2c_scan_stage);
+#if BSP_CAPS_FUEL_GAUGE
+    bsp_init_run_stage(BSP_INIT_STAGE_FUEL_GAUGE, bsp_fuel_gauge_init);
+#endif
+#if BSP_CAPS_PCF8574
+    bsp_init_run_stage(BSP_INIT_STAGE_PCF8574, bsp_pcf8574_init);
+#endif
+}
+#endif
+
+#if CONFIG_BSP_INIT_PARALLEL
+#define BSP_INIT_TASK_STACK_SIZE    3072
+
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t bsp_init_task_buf;
+static StackType_t bsp_init_task_stack[BSP_INIT_TASK_STACK_SIZE];
+#endif
+
+static void bsp_init_i2c_devices_task(void *arg)
+{
+    TaskHandle_t waiter = (TaskHandle_t)arg;
+
+    bsp_init_i2c_devices();
+
+    xTaskNotifyGive(waiter);
+    vTaskDelete(NULL);
+}
+#endif
+
 esp_err_t bsp_init(void)
 {
-    ESP_LOGI(TAG, "Initializing Hope Badge BSP");
+    ESP_LOGI(TAG, "Initializing Hope Badge BSP%s", bsp_deep_sleep_is_resume() ? " (resume from deep sleep)" : "");
+    int64_t init_start = esp_timer_get_time();
     esp_err_t ret = ESP_OK;
     esp_err_t err;
 
-    // Initialize I2C — required by fuel gauge and PCF8574
-    err = bsp_i2c_init();
+    // Hot-path errors are formatted by a low-priority task from here on
+    bsp_log_init();
+    bsp_monitor_init();
+#if CONFIG_BSP_WORKER
+    // Timer-driven flash and bus work runs here, never in the esp_timer task
+    err = bsp_worker_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Worker task not available: %s", esp_err_to_name(err));
+    }
+#endif
+
+#if CONFIG_BSP_SETTINGS
+    // Settings are read from RAM from here on, a missing NVS only means defaults
+    bsp_settings_init();
+#endif
+
+#if CONFIG_BSP_EVLOG
+    // Records the reset reason, early so that a crash later in init still leaves a trace
+    err = bsp_evlog_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Event log not available: %s", esp_err_to_name(err));
+    }
+#endif
+
+#if CONFIG_BSP_INIT_LAZY
+    if (lazy_init_lock == NULL) {
+        lazy_init_lock = xSemaphoreCreateMutexStatic(&lazy_init_lock_buf);
+    }
+#endif
+
+    // Initialize I2C — required by fuel gauge and PCF8574 (no bus traffic yet)
+    err = bsp_init_run_stage(BSP_INIT_STAGE_I2C, bsp_i2c_init);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize I2C: %s", esp_err_to_name(err));
         return err;  // Cannot continue without I2C
     }
 
-    // Initialize buttons
-    err = bsp_buttons_init();
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize buttons: %s", esp_err_to_name(err));
-        if (ret == ESP_OK) ret = err;
+#if CONFIG_BSP_INIT_PARALLEL
+    // Probe the I2C devices while the GPIO and RMT peripherals come up
+#if CONFIG_BSP_STATIC_ALLOC
+    bool i2c_devices_async = xTaskCreateStatic(bsp_init_i2c_devices_task, "bsp_init", BSP_INIT_TASK_STACK_SIZE,
+                                               xTaskGetCurrentTaskHandle(), uxTaskPriorityGet(NULL),
+                                               bsp_init_task_stack, &bsp_init_task_buf) != NULL;
+#else
+    bool i2c_devices_async = xTaskCreate(bsp_init_i2c_devices_task, "bsp_init", BSP_INIT_TASK_STACK_SIZE,
+                                         xTaskGetCurrentTaskHandle(), uxTaskPriorityGet(NULL), NULL) == pdPASS;
+#endif
+    if (!i2c_devices_async) {
+        ESP_LOGW(TAG, "Failed to create init task, probing I2C devices sequentially");
     }
+#endif
 
     // Initialize LED
-    err = bsp_led_init();
+    err = bsp_init_run_stage(BSP_INIT_STAGE_LED, bsp_led_init);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize LED: %s", esp_err_to_name(err));
         if (ret == ESP_OK) ret = err;
     }
 
+#if !CONFIG_BSP_INIT_LAZY
     // Initialize RGB LED
-    err = bsp_init_led_rgb();
+    err = bsp_init_run_stage(BSP_INIT_STAGE_LED_RGB, bsp_init_led_rgb);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize RGB LED: %s", esp_err_to_name(err));
         if (ret == ESP_OK) ret = err;
     }
+#endif
+
+    // Initialize buttons
+    err = bsp_init_run_stage(BSP_INIT_STAGE_BUTTONS, bsp_buttons_init);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize buttons: %s", esp_err_to_name(err));
+        if (ret == ESP_OK) ret = err;
+    }
+
+#if !CONFIG_BSP_INIT_LAZY
+#if CONFIG_BSP_INIT_PARALLEL
+    if (i2c_devices_async) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    } else
+#endif
+    {
+        bsp_init_i2c_devices();
+    }
 
-    // Initialize fuel gauge
-    err = bsp_fuel_gauge_init();
+#if BSP_CAPS_FUEL_GAUGE
+    // Fuel gauge
+    err = init_stages[BSP_INIT_STAGE_FUEL_GAUGE].err;
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize fuel gauge: %s", esp_err_to_name(err));
         if (ret == ESP_OK) ret = err;
     }
+#endif
 
-    // Initialize PCF8574 I/O expander (non-critical)
-    err = bsp_pcf8574_init();
+#if BSP_CAPS_PCF8574
+    // PCF8574 I/O expander (non-critical)
+    err = init_stages[BSP_INIT_STAGE_PCF8574].err;
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "Failed to initialize PCF8574: %s", esp_err_to_name(err));
     }
+#endif
+#endif
+
+    // Configure DFS, light sleep and wake-up sources (non-critical)
+    err = bsp_init_run_stage(BSP_INIT_STAGE_POWER, bsp_power_init);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to initialize power management: %s", esp_err_to_name(err));
+    }
 
+    bsp_metrics_set(BSP_METRIC_INIT_US, (int32_t)(esp_timer_get_time() - init_start));
     ESP_LOGI(TAG, "BSP initialization complete");
 
     return ret;
@@ -0,0 +1,229 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#if CONFIG_BSP_I2C_SCAN_CACHE
+#include "nvs.h"
+#endif
+
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_power.h"
+#include "bsp/bsp_metrics.h"
+#include "bsp/bsp_trace.h"
+#include "bsp_priv.h"
+
+static const char *TAG = "BSP-I2C";
+
+#define BSP_I2C_NVS_NAMESPACE   "bsp"
+#define BSP_I2C_NVS_KEY         "i2c_" BSP_HW_VERSION_NAME
+
+/* One bit per 7-bit address */
+static uint32_t i2c_presence[4] = {0};
+static bool i2c_presence_valid = false;
+
+static inline void bsp_i2c_presence_set(uint8_t addr)
+{
+    i2c_presence[addr >> 5] |= (1UL << (addr & 0x1F));
+}
+
+static inline bool bsp_i2c_presence_get(uint8_t addr)
+{
+    return (i2c_presence[addr >> 5] >> (addr & 0x1F)) & 1;
+}
+
+#if CONFIG_BSP_I2C_SCAN_CACHE
+/* Addresses of the badge devices, probed to validate a cached map */
+static const uint8_t i2c_expected_addrs[] = {
+#if BSP_CAPS_FUEL_GAUGE
+    MAX17048_I2C_ADDR_DEFAULT,
+#endif
+#if BSP_CAPS_PCF8574
+    PCF8574_I2C_ADDR_DEFAULT,
+    PCF8574A_I2C_ADDR_DEFAULT,
+#endif
+};
+
+static esp_err_t bsp_i2c_nvs_open(nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    // NVS belongs to the application: without nvs_flash_init() the scan is just not cached
+    esp_err_t ret = nvs_open(BSP_I2C_NVS_NAMESPACE, mode, handle);
+    if (ret == ESP_ERR_NVS_NOT_INITIALIZED) {
+        ESP_LOGD(TAG, "NVS is not initialized, I2C scan is not cached");
+    }
+    return ret;
+}
+
+/* One read transfer: true if a device acknowledges its address */
+static bool bsp_i2c_probe(i2c_bus_handle_t bus, uint8_t addr)
+{
+    i2c_bus_device_handle_t dev = i2c_bus_device_create(bus, addr, i2c_bus_get_current_clk_speed(bus));
+    if (dev == NULL) {
+        return false;
+    }
+    uint8_t data = 0;
+    bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
+    esp_err_t ret = i2c_bus_read_byte(dev, NULL_I2C_MEM_ADDR, &data);
+    bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    i2c_bus_device_delete(&dev);
+    return ret == ESP_OK;
+}
+
+/* The cached map is only used while every badge device still answers as it did when cached */
+static bool bsp_i2c_cache_valid(void)
+{
+    i2c_bus_handle_t bus = bsp_i2c_get_handle();
+    if (bus == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(i2c_expected_addrs) / sizeof(i2c_expected_addrs[0]); i++) {
+        const uint8_t addr = i2c_expected_addrs[i];
+        if (bsp_i2c_probe(bus, addr) != bsp_i2c_presence_get(addr)) {
+            ESP_LOGI(TAG, "Device at 0x%02X changed since the cached scan", addr);
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t bsp_i2c_cache_load(void)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = bsp_i2c_nvs_open(NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return ret;     // Namespace does not exist before the first scan
+    }
+
+    uint32_t map[4];
+    size_t len = sizeof(map);
+    ret = nvs_get_blob(handle, BSP_I2C_NVS_KEY, map, &len);
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (len != sizeof(map)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(i2c_presence, map, sizeof(i2c_presence));
+    return ESP_OK;
+}
+
+static void bsp_i2c_cache_store(void)
+{
+    nvs_handle_t handle;
+    if (bsp_i2c_nvs_open(NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    esp_err_t ret = nvs_set_blob(handle, BSP_I2C_NVS_KEY, i2c_presence, sizeof(i2c_presence));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to cache I2C scan: %s", esp_err_to_name(ret));
+    }
+}
+#endif
+
+static esp_err_t bsp_i2c_scan_bus(void)
+{
+    i2c_bus_handle_t bus = bsp_i2c_get_handle();
+    if (bus == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t found[128];
+    int64_t start = esp_timer_get_time();
+    bsp_trace_event(BSP_TRACE_I2C_START, 0, 0);
+    bsp_power_lock_acquire(BSP_PM_LOCK_I2C);
+    uint8_t num = i2c_bus_scan(bus, found, sizeof(found));
+    bsp_power_lock_release(BSP_PM_LOCK_I2C);
+    bsp_trace_event(BSP_TRACE_I2C_DONE, 0, num);
+    bsp_metrics_record_us(BSP_METRIC_I2C_SCAN_US, (uint32_t)(esp_timer_get_time() - start));
+    bsp_metrics_inc(BSP_METRIC_I2C_SCANS);
+
+    memset(i2c_presence, 0, sizeof(i2c_presence));
+    for (uint8_t i = 0; i < num && i < sizeof(found); i++) {
+        bsp_i2c_presence_set(found[i] & 0x7F);
+        ESP_LOGI(TAG, "Found device at 0x%02X", found[i]);
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_i2c_scan(bool rescan)
+{
+    if (i2c_presence_valid && !rescan) {
+        return ESP_OK;
+    }
+
+    // Presence map kept in RTC memory across deep sleep
+    const bsp_retained_state_t *state = bsp_sleep_get_resume_state();
+    if (state != NULL && !rescan) {
+        memcpy(i2c_presence, state->i2c_presence, sizeof(i2c_presence));
+        i2c_presence_valid = true;
+        return ESP_OK;
+    }
+
+#if CONFIG_BSP_I2C_SCAN_CACHE
+    if (!rescan && bsp_i2c_cache_load() == ESP_OK && bsp_i2c_cache_valid()) {
+        ESP_LOGD(TAG, "Loaded I2C presence map for HW " BSP_HW_VERSION_NAME " from NVS");
+        i2c_presence_valid = true;
+        return ESP_OK;
+    }
+#endif
+
+    ESP_RETURN_ON_ERROR(bsp_i2c_scan_bus(), TAG, "I2C bus is not initialized");
+    i2c_presence_valid = true;
+
+#if CONFIG_BSP_I2C_SCAN_CACHE
+    bsp_i2c_cache_store();
+#endif
+    return ESP_OK;
+}
+
+bool bsp_i2c_device_present(uint8_t addr)
+{
+    if (addr > 0x7F) {
+        return false;
+    }
+    if (!i2c_presence_valid && bsp_i2c_scan(false) != ESP_OK) {
+        return false;
+    }
+    return (i2c_presence[addr >> 5] >> (addr & 0x1F)) & 1;
+}
+
+bool bsp_i2c_get_presence(uint32_t map[4])
+{
+    if (!i2c_presence_valid) {
+        return false;
+    }
+    memcpy(map, i2c_presence, sizeof(i2c_presence));
+    return true;
+}
+
+esp_err_t bsp_i2c_scan_invalidate(void)
+{
+    i2c_presence_valid = false;
+
+#if CONFIG_BSP_I2C_SCAN_CACHE
+    nvs_handle_t handle;
+    if (bsp_i2c_nvs_open(NVS_READWRITE, &handle) == ESP_OK) {
+        nvs_erase_key(handle, BSP_I2C_NVS_KEY);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+#endif
+    return ESP_OK;
+}
@@ -0,0 +1,167 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_led_async.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_LED_RGB_ASYNC
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "BSP-LED-ASYNC";
+
+/* Taken while the front buffer is being sent or written */
+static SemaphoreHandle_t front_lock = NULL;
+static StaticSemaphore_t front_lock_buf;
+static TaskHandle_t refresh_task = NULL;
+static bsp_rgb_t back_buffer[BSP_LED_RGB_PIXELS];
+static bsp_led_rgb_done_cb_t done_cb = NULL;
+static void *done_cb_arg = NULL;
+
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t refresh_task_buf;
+static StackType_t refresh_task_stack[BSP_LED_RGB_ASYNC_TASK_STACK_SIZE];
+#endif
+
+static void bsp_led_rgb_refresh_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // front_lock was taken by the swap and is released once the frame is out
+        esp_err_t ret = bsp_led_rgb_refresh_locked();
+        bsp_led_rgb_done_cb_t cb = done_cb;
+        void *cb_arg = done_cb_arg;
+        xSemaphoreGive(front_lock);
+        if (cb) {
+            cb(ret, cb_arg);
+        }
+    }
+}
+
+esp_err_t bsp_led_rgb_async_init(void)
+{
+    if (refresh_task != NULL) {
+        return ESP_OK;
+    }
+    if (front_lock == NULL) {
+        // Binary, not a mutex: taken by the swap, given by the refresh task
+        front_lock = xSemaphoreCreateBinaryStatic(&front_lock_buf);
+        xSemaphoreGive(front_lock);
+    }
+
+    // Above the render tasks, so a queued frame goes out as soon as the RMT is free
+#if CONFIG_BSP_STATIC_ALLOC
+    refresh_task = xTaskCreateStatic(bsp_led_rgb_refresh_task, "bsp_led_rgb", BSP_LED_RGB_ASYNC_TASK_STACK_SIZE,
+                                     NULL, configMAX_PRIORITIES - 2, refresh_task_stack, &refresh_task_buf);
+#else
+    xTaskCreate(bsp_led_rgb_refresh_task, "bsp_led_rgb", BSP_LED_RGB_ASYNC_TASK_STACK_SIZE, NULL,
+                configMAX_PRIORITIES - 2, &refresh_task);
+#endif
+    ESP_RETURN_ON_FALSE(refresh_task != NULL, ESP_ERR_NO_MEM, TAG, "Failed to create refresh task");
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_rgb_front_take(uint32_t timeout_ms)
+{
+    if (front_lock == NULL) {
+        return ESP_OK;
+    }
+    const TickType_t ticks = (timeout_ms == BSP_LED_RGB_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTake(front_lock, ticks) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void bsp_led_rgb_front_give(void)
+{
+    if (front_lock != NULL) {
+        xSemaphoreGive(front_lock);
+    }
+}
+
+bsp_rgb_t *bsp_led_rgb_get_back_buffer(void)
+{
+    return back_buffer;
+}
+
+esp_err_t bsp_led_rgb_swap(uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(refresh_task != NULL, ESP_ERR_INVALID_STATE, TAG, "RGB LED is not initialized");
+    ESP_RETURN_ON_ERROR(bsp_led_rgb_front_take(timeout_ms), TAG, "Previous frame still in flight");
+
+    // Copying 3 bytes per pixel is much cheaper than the 30 us per pixel on the wire
+    esp_err_t ret = bsp_led_rgb_write_frame(back_buffer, BSP_LED_RGB_PIXELS);
+    if (ret != ESP_OK) {
+        bsp_led_rgb_front_give();
+        return ret;
+    }
+    xTaskNotifyGive(refresh_task);
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_rgb_wait_done(uint32_t timeout_ms)
+{
+    ESP_RETURN_ON_ERROR(bsp_led_rgb_front_take(timeout_ms), TAG, "Frame still in flight");
+    bsp_led_rgb_front_give();
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_rgb_set_done_callback(bsp_led_rgb_done_cb_t callback, void *arg)
+{
+    // Published as a pair: the refresh task reads both under the front lock
+    bsp_led_rgb_front_take(BSP_LED_RGB_WAIT_FOREVER);
+    done_cb = callback;
+    done_cb_arg = arg;
+    bsp_led_rgb_front_give();
+    return ESP_OK;
+}
+
+#else /* !CONFIG_BSP_LED_RGB_ASYNC */
+
+esp_err_t bsp_led_rgb_async_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_rgb_front_take(uint32_t timeout_ms)
+{
+    return ESP_OK;
+}
+
+void bsp_led_rgb_front_give(void)
+{
+}
+
+bsp_rgb_t *bsp_led_rgb_get_back_buffer(void)
+{
+    return NULL;
+}
+
+esp_err_t bsp_led_rgb_swap(uint32_t timeout_ms)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_rgb_wait_done(uint32_t timeout_ms)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_rgb_set_done_callback(bsp_led_rgb_done_cb_t callback, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_LED_RGB_ASYNC */
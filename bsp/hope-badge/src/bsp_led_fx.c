@@ -0,0 +1,124 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <inttypes.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_check.h"
+
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_led_fx.h"
+
+static const char *TAG = "BSP-FX";
+
+/* Position of time_ms within the period, 0-255 */
+static uint8_t bsp_led_fx_phase(uint32_t time_ms, uint32_t period_ms)
+{
+    if (period_ms == 0) {
+        return 0;
+    }
+    return ((time_ms % period_ms) << 8) / period_ms;
+}
+
+static uint32_t bsp_led_fx_random(uint32_t *seed)
+{
+    // xorshift32, a few cycles and no divides
+    uint32_t x = *seed ? *seed : 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+esp_err_t bsp_led_rgb_show(const bsp_rgb_t *frame, uint32_t count)
+{
+    ESP_RETURN_ON_FALSE(frame != NULL && count <= BSP_LED_RGB_PIXELS, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid frame");
+
+    for (uint32_t i = 0; i < count; i++) {
+        ESP_RETURN_ON_ERROR(bsp_led_rgb_set_pixel(i, frame[i].r, frame[i].g, frame[i].b), TAG,
+                            "Failed to set pixel %" PRIu32, i);
+    }
+    return bsp_led_rgb_refresh();
+}
+
+void bsp_led_fx_chase(bsp_rgb_t *frame, uint32_t count, uint32_t step, bsp_rgb_t color, uint8_t tail)
+{
+    if (count == 0) {
+        return;
+    }
+    const uint32_t head = step % count;
+    for (uint32_t i = 0; i < count; i++) {
+        // Distance behind the head, wrapping around the ring
+        const uint32_t behind = (head + count - i) % count;
+        if (behind == 0) {
+            frame[i] = color;
+        } else if (behind <= tail) {
+            const uint8_t level = 255 - (behind * 255) / (tail + 1);
+            frame[i] = bsp_color_scale(color, bsp_ease8(level));
+        } else {
+            frame[i] = BSP_RGB_BLACK;
+        }
+    }
+}
+
+void bsp_led_fx_breathe(bsp_rgb_t *frame, uint32_t count, uint32_t time_ms, uint32_t period_ms, bsp_rgb_t color)
+{
+    // Start dark: sine shifted by a quarter turn, rescaled from 1-255 to 0-255
+    const uint8_t wave = bsp_sin8(bsp_led_fx_phase(time_ms, period_ms) - 64) - 1;
+    const bsp_rgb_t c = bsp_color_scale(color, bsp_gamma8(wave + (wave >> 7)));
+    for (uint32_t i = 0; i < count; i++) {
+        frame[i] = c;
+    }
+}
+
+void bsp_led_fx_rainbow(bsp_rgb_t *frame, uint32_t count, uint32_t time_ms, uint32_t period_ms,
+                        uint8_t brightness)
+{
+    if (count == 0) {
+        return;
+    }
+    const uint8_t base = bsp_led_fx_phase(time_ms, period_ms);
+    const uint32_t hue_step = 65536 / count;     // 8.8 fixed point
+    uint32_t hue = (uint32_t)base << 8;
+    for (uint32_t i = 0; i < count; i++) {
+        frame[i] = bsp_color_hsv((hue >> 8) & 0xFF, 255, brightness);
+        hue += hue_step;
+    }
+}
+
+void bsp_led_fx_sparkle(bsp_rgb_t *frame, uint32_t count, bsp_rgb_t color, uint8_t chance, uint8_t fade,
+                        uint32_t *seed)
+{
+    if (count == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        frame[i] = bsp_color_scale(frame[i], fade);
+    }
+    const uint32_t r = bsp_led_fx_random(seed);
+    if ((r & 0xFF) < chance) {
+        frame[(r >> 8) % count] = color;
+    }
+}
+
+void bsp_led_fx_spectrum(bsp_rgb_t *frame, uint32_t count, const uint8_t *levels, uint32_t num_levels,
+                         const bsp_palette16_t *palette)
+{
+    if (num_levels == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t band = (i * num_levels) / count;
+        // Stop short of the last palette entry, it blends back into the first
+        const uint8_t index = (uint8_t)((band * 240) / num_levels);
+        frame[i] = bsp_color_from_palette(palette, index, bsp_gamma8(levels[band]));
+    }
+}
@@ -0,0 +1,254 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_led_pwm.h"
+#include "bsp/bsp_settings.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_LED_PWM
+#include "esp_attr.h"
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+
+static const char *TAG = "BSP-LED";
+
+#define BSP_LED_LEDC_MODE       LEDC_LOW_SPEED_MODE
+#define BSP_LED_LEDC_TIMER      LEDC_TIMER_0
+#define BSP_LED_LEDC_CHANNEL    LEDC_CHANNEL_0
+#define BSP_LED_LEDC_RES        LEDC_TIMER_14_BIT
+#define BSP_LED_DUTY_MAX        ((1U << 14) - 1)
+#define BSP_LED_PWM_FREQ_HZ     1000
+#define BSP_LED_BREATHE_MIN_MS  100
+
+typedef enum {
+    BSP_LED_MODE_STEADY = 0,    // Fixed brightness or single fade
+    BSP_LED_MODE_BLINK,         // Timer slowed down to the blink rate
+    BSP_LED_MODE_BREATHE,       // Alternating fades
+} bsp_led_mode_t;
+
+static bool led_initialized = false;
+static bsp_led_mode_t led_mode = BSP_LED_MODE_STEADY;
+static SemaphoreHandle_t led_lock = NULL;
+static StaticSemaphore_t led_lock_buf;
+
+/* Breathe state; breathe_gen invalidates ramps queued before the pattern changed */
+static volatile uint32_t breathe_gen = 0;
+static uint32_t breathe_half_ms = 0;
+static uint32_t breathe_max_duty = 0;
+static bool breathe_up = false;
+
+static uint32_t bsp_led_duty(uint8_t brightness)
+{
+    // Levels are relative to the brightness setting; square law is close enough to perceived brightness
+    const uint32_t level = ((uint32_t)brightness * (uint32_t)bsp_settings_get(BSP_SETTING_LED_BRIGHTNESS)) / 255U;
+    return (level * level * BSP_LED_DUTY_MAX) / (255U * 255U);
+}
+
+/* Stop whatever is running and bring the timer back to the PWM frequency; lock held */
+static esp_err_t bsp_led_stop_pattern(void)
+{
+    breathe_gen++;
+    ledc_fade_stop(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL);
+    if (led_mode == BSP_LED_MODE_BLINK) {
+        ESP_RETURN_ON_ERROR(ledc_set_freq(BSP_LED_LEDC_MODE, BSP_LED_LEDC_TIMER, BSP_LED_PWM_FREQ_HZ), TAG,
+                            "Failed to restore PWM frequency");
+    }
+    led_mode = BSP_LED_MODE_STEADY;
+    return ESP_OK;
+}
+
+static esp_err_t bsp_led_start_fade(uint32_t duty, uint32_t time_ms)
+{
+    ESP_RETURN_ON_ERROR(ledc_set_fade_with_time(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL, duty, time_ms), TAG,
+                        "Failed to set fade");
+    return ledc_fade_start(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL, LEDC_FADE_NO_WAIT);
+}
+
+/* Runs in the timer service task */
+static void bsp_led_breathe_step(void *arg, uint32_t gen)
+{
+    xSemaphoreTake(led_lock, portMAX_DELAY);
+    if (led_mode == BSP_LED_MODE_BREATHE && gen == breathe_gen) {
+        breathe_up = !breathe_up;
+        bsp_led_start_fade(breathe_up ? breathe_max_duty : 0, breathe_half_ms);
+    }
+    xSemaphoreGive(led_lock);
+}
+
+static IRAM_ATTR bool bsp_led_fade_end_cb(const ledc_cb_param_t *param, void *user_arg)
+{
+    BaseType_t woken = pdFALSE;
+    if (param->event == LEDC_FADE_END_EVT && led_mode == BSP_LED_MODE_BREATHE) {
+        xTimerPendFunctionCallFromISR(bsp_led_breathe_step, NULL, breathe_gen, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+esp_err_t bsp_led_pwm_init(void)
+{
+    if (led_initialized) {
+        return ESP_OK;
+    }
+    if (led_lock == NULL) {
+        led_lock = xSemaphoreCreateMutexStatic(&led_lock_buf);
+    }
+
+    // RC_FAST keeps running in light sleep and does not follow DFS
+    const ledc_timer_config_t timer_config = {
+        .speed_mode = BSP_LED_LEDC_MODE,
+        .duty_resolution = BSP_LED_LEDC_RES,
+        .timer_num = BSP_LED_LEDC_TIMER,
+        .freq_hz = BSP_LED_PWM_FREQ_HZ,
+        .clk_cfg = LEDC_USE_RC_FAST_CLK,
+    };
+    ESP_RETURN_ON_ERROR(ledc_timer_config(&timer_config), TAG, "Failed to configure LEDC timer");
+
+    const ledc_channel_config_t channel_config = {
+        .gpio_num = BSP_LED_IO,
+        .speed_mode = BSP_LED_LEDC_MODE,
+        .channel = BSP_LED_LEDC_CHANNEL,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = BSP_LED_LEDC_TIMER,
+        .duty = 0,
+        .hpoint = 0,
+        .sleep_mode = LEDC_SLEEP_MODE_KEEP_ALIVE,
+        .flags.output_invert = (CONFIG_BSP_LED_ACTIVE_LEVEL == 0),
+    };
+    ESP_RETURN_ON_ERROR(ledc_channel_config(&channel_config), TAG, "Failed to configure LEDC channel");
+
+    // The application may have installed the fade service already
+    esp_err_t ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install LEDC fade: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ledc_cbs_t callbacks = {
+        .fade_cb = bsp_led_fade_end_cb,
+    };
+    ESP_RETURN_ON_ERROR(ledc_cb_register(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL, &callbacks, NULL),
+                        TAG, "Failed to register fade callback");
+
+    led_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_set_brightness(uint8_t brightness)
+{
+    ESP_RETURN_ON_FALSE(led_initialized, ESP_ERR_INVALID_STATE, TAG, "LED is not initialized");
+
+    xSemaphoreTake(led_lock, portMAX_DELAY);
+    esp_err_t ret = bsp_led_stop_pattern();
+    if (ret == ESP_OK) {
+        ret = ledc_set_duty(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL, bsp_led_duty(brightness));
+    }
+    if (ret == ESP_OK) {
+        ret = ledc_update_duty(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL);
+    }
+    xSemaphoreGive(led_lock);
+    return ret;
+}
+
+esp_err_t bsp_led_fade_to(uint8_t brightness, uint32_t time_ms)
+{
+    ESP_RETURN_ON_FALSE(led_initialized, ESP_ERR_INVALID_STATE, TAG, "LED is not initialized");
+
+    xSemaphoreTake(led_lock, portMAX_DELAY);
+    esp_err_t ret = bsp_led_stop_pattern();
+    if (ret == ESP_OK) {
+        ret = bsp_led_start_fade(bsp_led_duty(brightness), time_ms);
+    }
+    xSemaphoreGive(led_lock);
+    return ret;
+}
+
+esp_err_t bsp_led_blink(uint32_t period_ms, uint8_t on_percent)
+{
+    ESP_RETURN_ON_FALSE(led_initialized, ESP_ERR_INVALID_STATE, TAG, "LED is not initialized");
+    ESP_RETURN_ON_FALSE(period_ms > 0 && period_ms <= BSP_LED_BLINK_PERIOD_MAX_MS, ESP_ERR_INVALID_ARG, TAG,
+                        "Blink period must be 1 to %d ms", BSP_LED_BLINK_PERIOD_MAX_MS);
+    ESP_RETURN_ON_FALSE(on_percent > 0 && on_percent < 100, ESP_ERR_INVALID_ARG, TAG,
+                        "On time must be 1 to 99 percent");
+
+    const uint32_t freq_hz = (1000 + period_ms / 2) / period_ms;
+
+    xSemaphoreTake(led_lock, portMAX_DELAY);
+    esp_err_t ret = bsp_led_stop_pattern();
+    if (ret == ESP_OK) {
+        ret = ledc_set_freq(BSP_LED_LEDC_MODE, BSP_LED_LEDC_TIMER, freq_hz);
+    }
+    if (ret == ESP_OK) {
+        led_mode = BSP_LED_MODE_BLINK;
+        ret = ledc_set_duty(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL, BSP_LED_DUTY_MAX * on_percent / 100);
+    }
+    if (ret == ESP_OK) {
+        ret = ledc_update_duty(BSP_LED_LEDC_MODE, BSP_LED_LEDC_CHANNEL);
+    }
+    xSemaphoreGive(led_lock);
+    return ret;
+}
+
+esp_err_t bsp_led_breathe(uint32_t period_ms, uint8_t max_brightness)
+{
+    ESP_RETURN_ON_FALSE(led_initialized, ESP_ERR_INVALID_STATE, TAG, "LED is not initialized");
+    ESP_RETURN_ON_FALSE(period_ms >= BSP_LED_BREATHE_MIN_MS && max_brightness > 0, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid breathe parameters");
+
+    xSemaphoreTake(led_lock, portMAX_DELAY);
+    esp_err_t ret = bsp_led_stop_pattern();
+    if (ret == ESP_OK) {
+        breathe_half_ms = period_ms / 2;
+        breathe_max_duty = bsp_led_duty(max_brightness);
+        breathe_up = true;
+        led_mode = BSP_LED_MODE_BREATHE;
+        ret = bsp_led_start_fade(breathe_max_duty, breathe_half_ms);
+    }
+    if (ret != ESP_OK) {
+        led_mode = BSP_LED_MODE_STEADY;
+    }
+    xSemaphoreGive(led_lock);
+    return ret;
+}
+
+#else /* !CONFIG_BSP_LED_PWM */
+
+esp_err_t bsp_led_pwm_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_set_brightness(uint8_t brightness)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_fade_to(uint8_t brightness, uint32_t time_ms)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_blink(uint32_t period_ms, uint8_t on_percent)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_breathe(uint32_t period_ms, uint8_t max_brightness)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_LED_PWM */
@@ -0,0 +1,191 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_led_strip_ext.h"
+
+#if CONFIG_BSP_LED_STRIP_EXT
+#include "esp_attr.h"
+#include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
+#include "bsp/bsp_power.h"
+
+static const char *TAG = "BSP-STRIP";
+
+#define BSP_STRIP_RMT_RES_HZ        (10 * 1000 * 1000)      // 0.1 us per tick
+#define BSP_STRIP_SYMBOLS_PER_PIXEL 24
+#define BSP_STRIP_PIXEL_US          30
+
+#if SOC_RMT_SUPPORT_DMA
+/* The DMA buffer is refilled in halves of 16 pixels, 480 us of interrupt latency headroom */
+#define BSP_STRIP_MEM_SYMBOLS       (32 * BSP_STRIP_SYMBOLS_PER_PIXEL)
+#define BSP_STRIP_WITH_DMA          true
+#else
+/*
+ * Two memory blocks: each ping-pong half holds two pixels, so a refill may be 60 us late. With one
+ * block a half held one pixel and any interrupt latency above 30 us broke the frame. The on-board
+ * ring keeps one block; the ESP32-C3 has four (two TX, two RX).
+ */
+#define BSP_STRIP_MEM_SYMBOLS       (2 * SOC_RMT_MEM_WORDS_PER_CHANNEL)
+#define BSP_STRIP_WITH_DMA          false
+#endif
+
+/* The refill interrupt must keep running while the flash cache is disabled, see Kconfig */
+#if !CONFIG_RMT_ISR_IRAM_SAFE
+#error "CONFIG_BSP_LED_STRIP_EXT requires CONFIG_RMT_ISR_IRAM_SAFE"
+#endif
+
+typedef struct {
+    bsp_led_strip_ext_pixel_cb_t pixel_cb;
+    void *arg;
+    uint32_t count;                 /*!< Pixels in the frame being sent */
+} bsp_strip_frame_t;
+
+/* WS2812 bit timings at 10 MHz: 0 = 0.3 us high + 0.9 us low, 1 = 0.9 us high + 0.3 us low */
+static DRAM_ATTR const rmt_symbol_word_t strip_bit0 = {
+    .level0 = 1, .duration0 = 3, .level1 = 0, .duration1 = 9,
+};
+static DRAM_ATTR const rmt_symbol_word_t strip_bit1 = {
+    .level0 = 1, .duration0 = 9, .level1 = 0, .duration1 = 3,
+};
+/* 300 us low latches the frame, long enough for WS2812B as well */
+static DRAM_ATTR const rmt_symbol_word_t strip_reset = {
+    .level0 = 0, .duration0 = 1500, .level1 = 0, .duration1 = 1500,
+};
+
+static rmt_channel_handle_t strip_chan = NULL;
+static rmt_encoder_handle_t strip_encoder = NULL;
+static bsp_strip_frame_t strip_frame;
+
+/* Called from the RMT interrupt each time half of the channel memory is free */
+static size_t IRAM_ATTR bsp_led_strip_ext_encode(const void *data, size_t data_size, size_t symbols_written,
+                                                 size_t symbols_free, rmt_symbol_word_t *symbols, bool *done,
+                                                 void *arg)
+{
+    const bsp_strip_frame_t *frame = (const bsp_strip_frame_t *)data;
+    uint32_t index = symbols_written / BSP_STRIP_SYMBOLS_PER_PIXEL;
+    size_t written = 0;
+
+    if (index >= frame->count) {
+        symbols[0] = strip_reset;
+        *done = true;
+        return 1;
+    }
+
+    // Render only as many pixels as fit, the rest are asked for on the next refill
+    while (index < frame->count && symbols_free - written >= BSP_STRIP_SYMBOLS_PER_PIXEL) {
+        const bsp_rgb_t c = frame->pixel_cb(index++, frame->arg);
+        const uint32_t grb = ((uint32_t)c.g << 16) | ((uint32_t)c.r << 8) | c.b;
+        for (int bit = BSP_STRIP_SYMBOLS_PER_PIXEL - 1; bit >= 0; bit--) {
+            symbols[written++] = ((grb >> bit) & 0x01) ? strip_bit1 : strip_bit0;
+        }
+    }
+    return written;
+}
+
+esp_err_t bsp_led_strip_ext_init(bsp_led_strip_ext_pixel_cb_t pixel_cb, void *arg)
+{
+    ESP_RETURN_ON_FALSE(pixel_cb != NULL && CONFIG_BSP_LED_STRIP_EXT_GPIO >= 0, ESP_ERR_INVALID_ARG, TAG,
+                        "Pixel callback and GPIO are required");
+    ESP_RETURN_ON_FALSE(strip_chan == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    const rmt_tx_channel_config_t chan_config = {
+        .gpio_num = CONFIG_BSP_LED_STRIP_EXT_GPIO,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = BSP_STRIP_RMT_RES_HZ,
+        .mem_block_symbols = BSP_STRIP_MEM_SYMBOLS,
+        .trans_queue_depth = 1,
+        .flags = {
+            .with_dma = BSP_STRIP_WITH_DMA,
+        },
+    };
+    ESP_RETURN_ON_ERROR(rmt_new_tx_channel(&chan_config, &strip_chan), TAG, "Failed to create RMT channel");
+
+    const rmt_simple_encoder_config_t encoder_config = {
+        .callback = bsp_led_strip_ext_encode,
+        .min_chunk_size = BSP_STRIP_SYMBOLS_PER_PIXEL,
+    };
+    esp_err_t ret = rmt_new_simple_encoder(&encoder_config, &strip_encoder);
+    if (ret == ESP_OK) {
+        ret = rmt_enable(strip_chan);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up RMT encoder: %s", esp_err_to_name(ret));
+        bsp_led_strip_ext_deinit();
+        return ret;
+    }
+
+    strip_frame.pixel_cb = pixel_cb;
+    strip_frame.arg = arg;
+    ESP_LOGI(TAG, "External strip on GPIO %d, up to %d pixels", CONFIG_BSP_LED_STRIP_EXT_GPIO,
+             CONFIG_BSP_LED_STRIP_EXT_PIXELS_NUM);
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_strip_ext_deinit(void)
+{
+    if (strip_chan != NULL) {
+        rmt_disable(strip_chan);
+        rmt_del_channel(strip_chan);
+        strip_chan = NULL;
+    }
+    if (strip_encoder != NULL) {
+        rmt_del_encoder(strip_encoder);
+        strip_encoder = NULL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_led_strip_ext_refresh(uint32_t count)
+{
+    ESP_RETURN_ON_FALSE(strip_chan != NULL, ESP_ERR_INVALID_STATE, TAG, "Strip is not initialized");
+    ESP_RETURN_ON_FALSE(count > 0 && count <= CONFIG_BSP_LED_STRIP_EXT_PIXELS_NUM, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid pixel count %" PRIu32, count);
+
+    const rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
+    // Frame time plus the latch and some slack for interrupt latency
+    const int timeout_ms = (int)((count * BSP_STRIP_PIXEL_US) / 1000) + 10;
+
+    strip_frame.count = count;
+    bsp_power_lock_acquire(BSP_PM_LOCK_LED);
+    esp_err_t ret = rmt_transmit(strip_chan, strip_encoder, &strip_frame, sizeof(strip_frame), &tx_config);
+    if (ret == ESP_OK) {
+        ret = rmt_tx_wait_all_done(strip_chan, timeout_ms);
+    }
+    bsp_power_lock_release(BSP_PM_LOCK_LED);
+    return ret;
+}
+
+#else /* !CONFIG_BSP_LED_STRIP_EXT */
+
+esp_err_t bsp_led_strip_ext_init(bsp_led_strip_ext_pixel_cb_t pixel_cb, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_strip_ext_deinit(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_led_strip_ext_refresh(uint32_t count)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_LED_STRIP_EXT */
@@ -0,0 +1,267 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_load.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_LOAD_SHED
+#include "esp_timer.h"
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_evlog.h"
+#include "bsp/bsp_metrics.h"
+#if BSP_CAPS_VIBRAMOTOR
+#include "vibramotor.h"
+#endif
+
+static const char *TAG = "BSP-LOAD";
+
+#define BSP_LOAD_LED_FULL_MA    (CONFIG_BSP_LOAD_LED_CHANNEL_MA * 3 * BSP_LED_RGB_PIXELS)
+/* Samples the trend looks ahead */
+#define BSP_LOAD_LOOKAHEAD      ((CONFIG_BSP_LOAD_LOOKAHEAD_S * 1000) / CONFIG_BSP_LOAD_SAMPLE_PERIOD_MS)
+
+static esp_timer_handle_t load_timer = NULL;
+static volatile bsp_load_level_t load_level = BSP_LOAD_NORMAL;
+static volatile uint32_t load_budget_ma = 0;
+static volatile uint32_t led_budget_ma = UINT32_MAX;
+static volatile uint32_t led_estimate_ma = 0;
+static volatile bool load_running = false;
+static volatile bool load_restart = false;  // Next sample starts the filter over
+// Owned by the worker task
+static int32_t ocv_x16 = 0;                 // Filtered unloaded cell voltage, mV * 16
+static int32_t slope_x16 = 0;               // Filtered change of ocv_x16 per sample
+static bool ocv_valid = false;
+static bsp_load_cb_t load_cb = NULL;
+static void *load_cb_arg = NULL;
+
+static bool bsp_load_motor_on(void)
+{
+#if BSP_CAPS_VIBRAMOTOR
+    return vibramotor_is_on();
+#else
+    return false;
+#endif
+}
+
+static void bsp_load_motor_hold(bool hold)
+{
+#if BSP_CAPS_VIBRAMOTOR
+    vibramotor_set_hold(hold);
+#endif
+}
+
+uint32_t bsp_load_get_estimate_ma(void)
+{
+    return CONFIG_BSP_LOAD_BASE_MA + led_estimate_ma + (bsp_load_motor_on() ? CONFIG_BSP_LOAD_MOTOR_MA : 0);
+}
+
+/* Leaving a level towards less shedding needs the hysteresis on top, so noise cannot toggle it */
+static bsp_load_level_t bsp_load_classify(uint32_t budget_ma, bsp_load_level_t current)
+{
+    const uint32_t critical_ma = CONFIG_BSP_LOAD_BASE_MA + CONFIG_BSP_LOAD_MOTOR_MA +
+                                 (current >= BSP_LOAD_CRITICAL ? CONFIG_BSP_LOAD_HYSTERESIS_MA : 0);
+    const uint32_t reduced_ma = CONFIG_BSP_LOAD_BASE_MA + CONFIG_BSP_LOAD_MOTOR_MA + BSP_LOAD_LED_FULL_MA +
+                                (current >= BSP_LOAD_REDUCED ? CONFIG_BSP_LOAD_HYSTERESIS_MA : 0);
+    if (budget_ma < critical_ma) {
+        return BSP_LOAD_CRITICAL;
+    }
+    if (budget_ma < reduced_ma) {
+        return BSP_LOAD_REDUCED;
+    }
+    return BSP_LOAD_NORMAL;
+}
+
+static void bsp_load_apply(bsp_load_level_t level, uint32_t budget_ma)
+{
+    // The LEDs get what is left after the base load and, unless it is held, the motor
+    uint32_t reserved_ma = CONFIG_BSP_LOAD_BASE_MA + (level >= BSP_LOAD_CRITICAL ? 0 : CONFIG_BSP_LOAD_MOTOR_MA);
+    led_budget_ma = (level == BSP_LOAD_NORMAL) ? UINT32_MAX :
+                    (budget_ma > reserved_ma) ? budget_ma - reserved_ma : 0;
+    load_budget_ma = budget_ma;
+    bsp_metrics_set(BSP_METRIC_LOAD_BUDGET_MA, (int32_t)budget_ma);
+
+    const bsp_load_level_t old = load_level;
+    if (level == old) {
+        return;
+    }
+    load_level = level;
+    bsp_load_motor_hold(level >= BSP_LOAD_CRITICAL);
+    ESP_LOGW(TAG, "Load level %d -> %d, budget %lu mA", old, level, (unsigned long)budget_ma);
+    bsp_evlog_write(BSP_EVLOG_LOAD, level, budget_ma);
+
+    bsp_load_cb_t cb = load_cb;
+    if (cb) {
+        cb(level, budget_ma, load_cb_arg);
+    }
+}
+
+void bsp_load_sample(void)
+{
+    if (load_restart) {
+        load_restart = false;
+        ocv_valid = false;
+    }
+    const float volts = bsp_get_battery_voltage();
+    // bsp_load_stop() may have run during the read
+    if (volts <= 0.0f || !load_running) {
+        return;     // Keep the last level, a failed read says nothing about the cell
+    }
+
+    // Add back the sag caused by what the BSP draws right now
+    const uint32_t estimate_ma = bsp_load_get_estimate_ma();
+    bsp_metrics_set(BSP_METRIC_LOAD_ESTIMATE_MA, (int32_t)estimate_ma);
+    const int32_t ocv_mv = (int32_t)(volts * 1000.0f) + (int32_t)((estimate_ma * CONFIG_BSP_LOAD_CELL_MOHM) / 1000);
+
+    if (!ocv_valid) {
+        ocv_x16 = ocv_mv * 16;
+        slope_x16 = 0;
+        ocv_valid = true;
+    } else {
+        const int32_t prev = ocv_x16;
+        ocv_x16 += (ocv_mv * 16 - ocv_x16) / 4;
+        slope_x16 += ((ocv_x16 - prev) - slope_x16) / 8;
+    }
+
+    // Only a falling trend is projected: recovery is acted on once it is measured
+    int32_t predicted_x16 = ocv_x16;
+    if (slope_x16 < 0) {
+        predicted_x16 += slope_x16 * BSP_LOAD_LOOKAHEAD;
+    }
+    const int32_t headroom_mv = predicted_x16 / 16 - CONFIG_BSP_LOAD_MIN_MV;
+    const uint32_t budget_ma = (headroom_mv > 0) ? ((uint32_t)headroom_mv * 1000) / CONFIG_BSP_LOAD_CELL_MOHM : 0;
+
+    bsp_load_apply(bsp_load_classify(budget_ma, load_level), budget_ma);
+}
+
+/* The fuel gauge read blocks on I2C and the callback is the application's: neither runs in the esp_timer task */
+static void bsp_load_timer_cb(void *arg)
+{
+    bsp_worker_post(BSP_WORK_LOAD_SAMPLE);
+}
+
+uint8_t bsp_load_led_scale(const uint8_t *frame, size_t len, uint8_t brightness)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += frame[i];
+    }
+    // Current of the frame at full scale, then at the brightness it would be shown at
+    const uint32_t full_ma = (sum * CONFIG_BSP_LOAD_LED_CHANNEL_MA) / 255;
+    const uint32_t budget_ma = led_budget_ma;
+    uint32_t scale = brightness;
+    if ((full_ma * scale) / 255 > budget_ma) {
+        scale = (budget_ma * 255) / full_ma;
+    }
+    led_estimate_ma = (full_ma * scale) / 255;
+    return (uint8_t)scale;
+}
+
+esp_err_t bsp_load_start(void)
+{
+    ESP_RETURN_ON_FALSE(bsp_get_battery_voltage() > 0.0f, ESP_ERR_NOT_FOUND, TAG, "Battery voltage not available");
+
+    if (load_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = bsp_load_timer_cb,
+            .name = "bsp_load",
+            .skip_unhandled_events = true,
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &load_timer), TAG, "Failed to create timer");
+    } else if (esp_timer_is_active(load_timer)) {
+        esp_timer_stop(load_timer);
+    }
+
+    load_restart = true;
+    load_running = true;
+    // The first sample runs on the worker as well, so samples never run concurrently
+    bsp_worker_post(BSP_WORK_LOAD_SAMPLE);
+    return esp_timer_start_periodic(load_timer, (uint64_t)CONFIG_BSP_LOAD_SAMPLE_PERIOD_MS * 1000);
+}
+
+esp_err_t bsp_load_stop(void)
+{
+    if (load_timer != NULL && esp_timer_is_active(load_timer)) {
+        esp_timer_stop(load_timer);
+    }
+    load_running = false;
+    load_level = BSP_LOAD_NORMAL;
+    load_budget_ma = 0;
+    led_budget_ma = UINT32_MAX;
+    bsp_load_motor_hold(false);
+    return ESP_OK;
+}
+
+bsp_load_level_t bsp_load_get_level(void)
+{
+    return load_level;
+}
+
+uint32_t bsp_load_get_budget_ma(void)
+{
+    return load_budget_ma;
+}
+
+esp_err_t bsp_load_set_callback(bsp_load_cb_t cb, void *arg)
+{
+    // Never let the timer see the new argument with the old callback
+    load_cb = NULL;
+    load_cb_arg = arg;
+    load_cb = cb;
+    return ESP_OK;
+}
+
+#else /* !CONFIG_BSP_LOAD_SHED */
+
+uint8_t bsp_load_led_scale(const uint8_t *frame, size_t len, uint8_t brightness)
+{
+    return brightness;
+}
+
+void bsp_load_sample(void)
+{
+}
+
+esp_err_t bsp_load_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_load_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bsp_load_level_t bsp_load_get_level(void)
+{
+    return BSP_LOAD_NORMAL;
+}
+
+uint32_t bsp_load_get_budget_ma(void)
+{
+    return 0;
+}
+
+uint32_t bsp_load_get_estimate_ma(void)
+{
+    return 0;
+}
+
+esp_err_t bsp_load_set_callback(bsp_load_cb_t cb, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_LOAD_SHED */
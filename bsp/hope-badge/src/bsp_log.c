@@ -0,0 +1,225 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#include "bsp_log.h"
+
+typedef struct {
+    const char *tag;
+    const char *fmt;
+    esp_err_t err;
+    int arg;
+    uint8_t level;
+    atomic_bool ready;
+} bsp_log_record_t;
+
+static void bsp_log_emit(esp_log_level_t level, const char *tag, const char *fmt, esp_err_t err, int arg)
+{
+    char msg[128];
+    snprintf(msg, sizeof(msg), fmt, arg);
+    const char *sep = (err != ESP_OK) ? ": " : "";
+    const char *err_name = (err != ESP_OK) ? esp_err_to_name(err) : "";
+    ESP_LOG_LEVEL_LOCAL(level, tag, "%s%s%s", msg, sep, err_name);
+}
+
+#if CONFIG_BSP_LOG_DEFERRED
+
+static const char *TAG = "BSP-LOG";
+
+#define BSP_LOG_RING_SIZE   CONFIG_BSP_LOG_QUEUE_LEN
+#define BSP_LOG_RING_MASK   (BSP_LOG_RING_SIZE - 1)
+#define BSP_LOG_SITES       16
+
+_Static_assert((BSP_LOG_RING_SIZE & BSP_LOG_RING_MASK) == 0, "Log queue length must be a power of two");
+
+static bsp_log_record_t ring[BSP_LOG_RING_SIZE];
+static atomic_uint_least32_t head = 0;
+static atomic_uint_least32_t tail = 0;
+static atomic_uint_least32_t dropped = 0;
+static TaskHandle_t log_task = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t log_task_buf;
+static StackType_t log_task_stack[BSP_LOG_TASK_STACK_SIZE];
+#endif
+
+/* Rate limiting per call site (format string), only touched by the log task */
+typedef struct {
+    const char *tag;
+    const char *fmt;
+    TickType_t window_start;
+    uint32_t count;
+    uint32_t suppressed;
+} bsp_log_site_t;
+
+static bsp_log_site_t sites[BSP_LOG_SITES];
+
+void bsp_log_fast(esp_log_level_t level, const char *tag, const char *fmt, esp_err_t err, int arg)
+{
+    if (level > LOG_LOCAL_LEVEL) {
+        return;
+    }
+    if (log_task == NULL) {
+        bsp_log_emit(level, tag, fmt, err, arg);
+        return;
+    }
+
+    // Reserve a slot; drop the record instead of blocking the caller when the ring is full
+    uint32_t idx = atomic_load_explicit(&head, memory_order_relaxed);
+    do {
+        if (idx - atomic_load_explicit(&tail, memory_order_acquire) >= BSP_LOG_RING_SIZE) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&head, &idx, idx + 1,
+                                                    memory_order_relaxed, memory_order_relaxed));
+
+    bsp_log_record_t *rec = &ring[idx & BSP_LOG_RING_MASK];
+    rec->tag = tag;
+    rec->fmt = fmt;
+    rec->err = err;
+    rec->arg = arg;
+    rec->level = level;
+    atomic_store_explicit(&rec->ready, true, memory_order_release);
+    xTaskNotifyGive(log_task);
+}
+
+static bsp_log_site_t *bsp_log_site(const char *tag, const char *fmt, TickType_t now)
+{
+    bsp_log_site_t *oldest = &sites[0];
+    for (int i = 0; i < BSP_LOG_SITES; i++) {
+        if (sites[i].fmt == fmt) {
+            return &sites[i];
+        }
+        if (sites[i].fmt == NULL) {
+            oldest = &sites[i];
+            break;
+        }
+        if ((TickType_t)(now - sites[i].window_start) > (TickType_t)(now - oldest->window_start)) {
+            oldest = &sites[i];
+        }
+    }
+    *oldest = (bsp_log_site_t) {
+        .tag = tag,
+        .fmt = fmt,
+        .window_start = now,
+    };
+    return oldest;
+}
+
+static void bsp_log_site_restart(bsp_log_site_t *site, TickType_t now)
+{
+    if (site->suppressed) {
+        ESP_LOGW(site->tag, "%lu more \"%s\" messages suppressed", (unsigned long)site->suppressed, site->fmt);
+    }
+    site->window_start = now;
+    site->count = 0;
+    site->suppressed = 0;
+}
+
+static void bsp_log_process(const bsp_log_record_t *rec)
+{
+    const TickType_t now = xTaskGetTickCount();
+    bsp_log_site_t *site = bsp_log_site(rec->tag, rec->fmt, now);
+
+    if (now - site->window_start >= pdMS_TO_TICKS(CONFIG_BSP_LOG_RATE_LIMIT_WINDOW_MS)) {
+        bsp_log_site_restart(site, now);
+    }
+    if (site->count >= CONFIG_BSP_LOG_RATE_LIMIT_BURST) {
+        site->suppressed++;
+        return;
+    }
+    site->count++;
+    bsp_log_emit(rec->level, rec->tag, rec->fmt, rec->err, rec->arg);
+}
+
+static void bsp_log_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_BSP_LOG_RATE_LIMIT_WINDOW_MS));
+
+        uint32_t t = atomic_load_explicit(&tail, memory_order_relaxed);
+        while (t != atomic_load_explicit(&head, memory_order_acquire)) {
+            bsp_log_record_t *rec = &ring[t & BSP_LOG_RING_MASK];
+            if (!atomic_load_explicit(&rec->ready, memory_order_acquire)) {
+                break;      // Reserved but not written yet
+            }
+            bsp_log_process(rec);
+            atomic_store_explicit(&rec->ready, false, memory_order_relaxed);
+            t++;
+            atomic_store_explicit(&tail, t, memory_order_release);
+        }
+
+        uint32_t lost = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+        if (lost) {
+            ESP_LOGW(TAG, "%lu log messages dropped", (unsigned long)lost);
+        }
+        // Report suppressed messages of storms that have ended
+        const TickType_t now = xTaskGetTickCount();
+        for (int i = 0; i < BSP_LOG_SITES; i++) {
+            if (sites[i].suppressed && now - sites[i].window_start >= pdMS_TO_TICKS(CONFIG_BSP_LOG_RATE_LIMIT_WINDOW_MS)) {
+                bsp_log_site_restart(&sites[i], now);
+            }
+        }
+    }
+}
+
+esp_err_t bsp_log_init(void)
+{
+    if (log_task != NULL) {
+        return ESP_OK;
+    }
+
+    TaskHandle_t task = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+    task = xTaskCreateStatic(bsp_log_task, "bsp_log", BSP_LOG_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+                             log_task_stack, &log_task_buf);
+#else
+    xTaskCreate(bsp_log_task, "bsp_log", BSP_LOG_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, &task);
+#endif
+    if (task == NULL) {
+        ESP_LOGE(TAG, "Failed to create log task, logging immediately");
+        return ESP_ERR_NO_MEM;
+    }
+    log_task = task;
+    return ESP_OK;
+}
+
+TaskHandle_t bsp_log_get_task_handle(void)
+{
+    return log_task;
+}
+
+#else /* !CONFIG_BSP_LOG_DEFERRED */
+
+void bsp_log_fast(esp_log_level_t level, const char *tag, const char *fmt, esp_err_t err, int arg)
+{
+    if (level <= LOG_LOCAL_LEVEL) {
+        bsp_log_emit(level, tag, fmt, err, arg);
+    }
+}
+
+esp_err_t bsp_log_init(void)
+{
+    return ESP_OK;
+}
+
+TaskHandle_t bsp_log_get_task_handle(void)
+{
+    return NULL;
+}
+
+#endif /* CONFIG_BSP_LOG_DEFERRED */
@@ -0,0 +1,313 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_metrics.h"
+#include "bsp_priv.h"
+
+#define BSP_METRIC_NAME(id, name) [BSP_METRIC_##id] = name,
+
+static const char *const metric_names[BSP_METRIC_MAX] = {
+    BSP_METRICS_COUNTERS(BSP_METRIC_NAME)
+    BSP_METRICS_GAUGES(BSP_METRIC_NAME)
+    BSP_METRICS_HISTOGRAMS(BSP_METRIC_NAME)
+};
+
+#undef BSP_METRIC_NAME
+
+const char *bsp_metrics_name(bsp_metric_id_t id)
+{
+    if (id < 0 || id >= BSP_METRIC_MAX || metric_names[id] == NULL) {
+        return "?";
+    }
+    return metric_names[id];
+}
+
+#if CONFIG_BSP_METRICS
+#include "esp_console.h"
+
+static const char *TAG = "BSP-METRICS";
+
+#define BSP_METRICS_HIST_NUM    (BSP_METRIC_MAX - BSP_METRIC_HISTOGRAM_FIRST)
+
+enum {
+    BSP_METRIC_TYPE_COUNTER,
+    BSP_METRIC_TYPE_GAUGE,
+    BSP_METRIC_TYPE_HISTOGRAM,
+};
+
+typedef struct {
+    atomic_uint_least32_t count;
+    atomic_uint_least32_t sum_us;
+    atomic_uint_least32_t max_us;
+    atomic_uint_least32_t buckets[BSP_METRICS_HIST_BUCKETS];
+} bsp_metrics_hist_slot_t;
+
+/* Counters and gauges (gauges stored as two's complement) */
+static atomic_uint_least32_t values[BSP_METRIC_HISTOGRAM_FIRST];
+static bsp_metrics_hist_slot_t hists[BSP_METRICS_HIST_NUM];
+
+static inline bool bsp_metrics_is_hist(bsp_metric_id_t id)
+{
+    return id >= BSP_METRIC_HISTOGRAM_FIRST && id < BSP_METRIC_MAX;
+}
+
+static inline int bsp_metrics_type(bsp_metric_id_t id)
+{
+    if (id < BSP_METRIC_GAUGE_FIRST) {
+        return BSP_METRIC_TYPE_COUNTER;
+    }
+    return bsp_metrics_is_hist(id) ? BSP_METRIC_TYPE_HISTOGRAM : BSP_METRIC_TYPE_GAUGE;
+}
+
+void bsp_metrics_add(bsp_metric_id_t id, uint32_t n)
+{
+    if (id >= 0 && id < BSP_METRIC_HISTOGRAM_FIRST) {
+        atomic_fetch_add_explicit(&values[id], n, memory_order_relaxed);
+    }
+}
+
+void bsp_metrics_set(bsp_metric_id_t id, int32_t value)
+{
+    if (id >= 0 && id < BSP_METRIC_HISTOGRAM_FIRST) {
+        atomic_store_explicit(&values[id], (uint32_t)value, memory_order_relaxed);
+    }
+}
+
+static inline unsigned bsp_metrics_bucket(uint32_t us)
+{
+    unsigned bucket = 0;
+    for (uint32_t v = us >> 4; v != 0 && bucket < BSP_METRICS_HIST_BUCKETS - 1; v >>= 2) {
+        bucket++;
+    }
+    return bucket;
+}
+
+void bsp_metrics_record_us(bsp_metric_id_t id, uint32_t us)
+{
+    if (!bsp_metrics_is_hist(id)) {
+        return;
+    }
+
+    bsp_metrics_hist_slot_t *hist = &hists[id - BSP_METRIC_HISTOGRAM_FIRST];
+    atomic_fetch_add_explicit(&hist->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum_us, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->buckets[bsp_metrics_bucket(us)], 1, memory_order_relaxed);
+
+    uint32_t max = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak_explicit(&hist->max_us, &max, us,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+int64_t bsp_metrics_get(bsp_metric_id_t id)
+{
+    if (id < 0 || id >= BSP_METRIC_HISTOGRAM_FIRST) {
+        return 0;
+    }
+    uint32_t v = atomic_load_explicit(&values[id], memory_order_relaxed);
+    return (id < BSP_METRIC_GAUGE_FIRST) ? (int64_t)v : (int64_t)(int32_t)v;
+}
+
+esp_err_t bsp_metrics_get_hist(bsp_metric_id_t id, bsp_metrics_hist_t *out)
+{
+    if (!bsp_metrics_is_hist(id) || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bsp_metrics_hist_slot_t *hist = &hists[id - BSP_METRIC_HISTOGRAM_FIRST];
+    out->count = atomic_load_explicit(&hist->count, memory_order_relaxed);
+    out->sum_us = atomic_load_explicit(&hist->sum_us, memory_order_relaxed);
+    out->max_us = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+    for (int i = 0; i < BSP_METRICS_HIST_BUCKETS; i++) {
+        out->buckets[i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+    }
+    return ESP_OK;
+}
+
+void bsp_metrics_reset(void)
+{
+    // The PCF8574 and vibramotor counters live in the components and are reported relative to now
+    bsp_metrics_reset_sources();
+    for (int i = 0; i < BSP_METRIC_HISTOGRAM_FIRST; i++) {
+        atomic_store_explicit(&values[i], 0, memory_order_relaxed);
+    }
+    for (int i = 0; i < BSP_METRICS_HIST_NUM; i++) {
+        atomic_store_explicit(&hists[i].count, 0, memory_order_relaxed);
+        atomic_store_explicit(&hists[i].sum_us, 0, memory_order_relaxed);
+        atomic_store_explicit(&hists[i].max_us, 0, memory_order_relaxed);
+        for (int b = 0; b < BSP_METRICS_HIST_BUCKETS; b++) {
+            atomic_store_explicit(&hists[i].buckets[b], 0, memory_order_relaxed);
+        }
+    }
+}
+
+void bsp_metrics_print(void)
+{
+    bsp_metrics_collect_sources();
+
+    for (bsp_metric_id_t id = 0; id < BSP_METRIC_MAX; id++) {
+        if (!bsp_metrics_is_hist(id)) {
+            ESP_LOGI(TAG, "%-22s %lld", metric_names[id], (long long)bsp_metrics_get(id));
+            continue;
+        }
+
+        bsp_metrics_hist_t hist;
+        bsp_metrics_get_hist(id, &hist);
+        ESP_LOGI(TAG, "%-22s n=%lu avg=%lu max=%lu us [%lu %lu %lu %lu %lu %lu %lu %lu]", metric_names[id],
+                 (unsigned long)hist.count, (unsigned long)(hist.count ? hist.sum_us / hist.count : 0),
+                 (unsigned long)hist.max_us,
+                 (unsigned long)hist.buckets[0], (unsigned long)hist.buckets[1],
+                 (unsigned long)hist.buckets[2], (unsigned long)hist.buckets[3],
+                 (unsigned long)hist.buckets[4], (unsigned long)hist.buckets[5],
+                 (unsigned long)hist.buckets[6], (unsigned long)hist.buckets[7]);
+    }
+}
+
+static uint8_t *bsp_metrics_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+    return p + 4;
+}
+
+size_t bsp_metrics_snapshot(uint8_t *buf, size_t len)
+{
+    const size_t header_len = 2 + 1 + 1 + 8;
+    const size_t value_len = 2 + 4;
+    const size_t hist_len = 2 + 4 * (3 + BSP_METRICS_HIST_BUCKETS);
+    const size_t needed = header_len + BSP_METRIC_HISTOGRAM_FIRST * value_len + BSP_METRICS_HIST_NUM * hist_len;
+
+    if (buf == NULL || len < needed) {
+        return needed;
+    }
+
+    bsp_metrics_collect_sources();
+
+    uint64_t uptime = (uint64_t)esp_timer_get_time();
+    uint8_t *p = buf;
+    *p++ = BSP_METRICS_SNAPSHOT_MAGIC & 0xFF;
+    *p++ = BSP_METRICS_SNAPSHOT_MAGIC >> 8;
+    *p++ = BSP_METRICS_SNAPSHOT_VERSION;
+    *p++ = BSP_METRIC_MAX;
+    p = bsp_metrics_put_u32(p, (uint32_t)uptime);
+    p = bsp_metrics_put_u32(p, (uint32_t)(uptime >> 32));
+
+    for (bsp_metric_id_t id = 0; id < BSP_METRIC_MAX; id++) {
+        *p++ = (uint8_t)id;
+        *p++ = (uint8_t)bsp_metrics_type(id);
+        if (!bsp_metrics_is_hist(id)) {
+            p = bsp_metrics_put_u32(p, atomic_load_explicit(&values[id], memory_order_relaxed));
+            continue;
+        }
+
+        bsp_metrics_hist_t hist;
+        bsp_metrics_get_hist(id, &hist);
+        p = bsp_metrics_put_u32(p, hist.count);
+        p = bsp_metrics_put_u32(p, hist.sum_us);
+        p = bsp_metrics_put_u32(p, hist.max_us);
+        for (int b = 0; b < BSP_METRICS_HIST_BUCKETS; b++) {
+            p = bsp_metrics_put_u32(p, hist.buckets[b]);
+        }
+    }
+    return needed;
+}
+
+static int bsp_metrics_cmd(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+        bsp_metrics_reset();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        // Sized from the registry, so added metrics never truncate the dump
+        const size_t len = bsp_metrics_snapshot(NULL, 0);
+        uint8_t *snapshot = malloc(len);
+        if (snapshot == NULL) {
+            ESP_LOGE(TAG, "Snapshot needs %u bytes", (unsigned)len);
+            return 1;
+        }
+        bsp_metrics_snapshot(snapshot, len);
+        printf("BSPM:");
+        for (size_t i = 0; i < len; i++) {
+            printf("%02x", snapshot[i]);
+        }
+        printf("\n");
+        free(snapshot);
+        return 0;
+    }
+    bsp_metrics_print();
+    return 0;
+}
+
+esp_err_t bsp_metrics_register_console(void)
+{
+    const esp_console_cmd_t cmd = {
+        .command = "bsp_metrics",
+        .help = "Show BSP metrics. -b: print binary snapshot as hex, -r: reset",
+        .hint = "[-b | -r]",
+        .func = bsp_metrics_cmd,
+    };
+    return esp_console_cmd_register(&cmd);
+}
+
+#else /* !CONFIG_BSP_METRICS */
+
+void bsp_metrics_add(bsp_metric_id_t id, uint32_t n)
+{
+}
+
+void bsp_metrics_set(bsp_metric_id_t id, int32_t value)
+{
+}
+
+void bsp_metrics_record_us(bsp_metric_id_t id, uint32_t us)
+{
+}
+
+int64_t bsp_metrics_get(bsp_metric_id_t id)
+{
+    return 0;
+}
+
+esp_err_t bsp_metrics_get_hist(bsp_metric_id_t id, bsp_metrics_hist_t *out)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void bsp_metrics_reset(void)
+{
+}
+
+void bsp_metrics_print(void)
+{
+}
+
+size_t bsp_metrics_snapshot(uint8_t *buf, size_t len)
+{
+    return 0;
+}
+
+esp_err_t bsp_metrics_register_console(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_METRICS */
@@ -0,0 +1,281 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_monitor.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_MONITOR
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_metrics.h"
+#include "vibramotor.h"
+#include "bsp_log.h"
+
+static const char *TAG = "BSP-MONITOR";
+
+typedef struct {
+    TaskHandle_t task;
+    uint32_t stack_size;
+    uint32_t min_free;          // Lowest high-water mark seen, in bytes
+    bool warned;
+} bsp_monitor_task_t;
+
+static bsp_monitor_task_t tasks[CONFIG_BSP_MONITOR_MAX_TASKS];
+static SemaphoreHandle_t monitor_lock = NULL;
+static StaticSemaphore_t monitor_lock_buf;
+static esp_timer_handle_t monitor_timer = NULL;
+static bool heap_warned = false;
+
+esp_err_t bsp_monitor_init(void)
+{
+    if (monitor_lock == NULL) {
+        monitor_lock = xSemaphoreCreateMutexStatic(&monitor_lock_buf);
+    }
+    return ESP_OK;
+}
+
+static bool bsp_monitor_lock(TickType_t wait)
+{
+    return monitor_lock != NULL && xSemaphoreTake(monitor_lock, wait) == pdTRUE;
+}
+
+static void bsp_monitor_unlock(void)
+{
+    xSemaphoreGive(monitor_lock);
+}
+
+esp_err_t bsp_monitor_add_task(TaskHandle_t task, uint32_t stack_size)
+{
+    if (task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bsp_monitor_lock(portMAX_DELAY)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    for (int i = 0; i < CONFIG_BSP_MONITOR_MAX_TASKS; i++) {
+        if (tasks[i].task == task) {
+            ret = ESP_OK;
+            break;
+        }
+        if (tasks[i].task == NULL) {
+            tasks[i] = (bsp_monitor_task_t) {
+                .task = task,
+                .stack_size = stack_size,
+                .min_free = UINT32_MAX,
+            };
+            ret = ESP_OK;
+            break;
+        }
+    }
+    bsp_monitor_unlock();
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No free slot for task %s", pcTaskGetName(task));
+    }
+    return ret;
+}
+
+esp_err_t bsp_monitor_remove_task(TaskHandle_t task)
+{
+    if (!bsp_monitor_lock(portMAX_DELAY)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    for (int i = 0; i < CONFIG_BSP_MONITOR_MAX_TASKS; i++) {
+        if (task != NULL && tasks[i].task == task) {
+            tasks[i].task = NULL;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    bsp_monitor_unlock();
+    return ret;
+}
+
+static esp_err_t bsp_monitor_sample_wait(TickType_t wait)
+{
+    uint32_t stack_min_free = UINT32_MAX;
+
+    if (!bsp_monitor_lock(wait)) {
+        return (monitor_lock == NULL) ? ESP_ERR_INVALID_STATE : ESP_ERR_TIMEOUT;
+    }
+    for (int i = 0; i < CONFIG_BSP_MONITOR_MAX_TASKS; i++) {
+        bsp_monitor_task_t *t = &tasks[i];
+        if (t->task == NULL) {
+            continue;
+        }
+        // Stack units are bytes on ESP-IDF
+        uint32_t free_bytes = uxTaskGetStackHighWaterMark(t->task);
+        if (free_bytes < t->min_free) {
+            t->min_free = free_bytes;
+        }
+        if (free_bytes < stack_min_free) {
+            stack_min_free = free_bytes;
+        }
+        if (free_bytes < CONFIG_BSP_MONITOR_STACK_WARN_BYTES && !t->warned) {
+            ESP_LOGW(TAG, "Task %s has only %lu bytes of stack left", pcTaskGetName(t->task),
+                     (unsigned long)free_bytes);
+            t->warned = true;
+        }
+    }
+    bsp_monitor_unlock();
+
+    size_t heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    size_t heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    size_t heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    if (heap_free < CONFIG_BSP_MONITOR_HEAP_WARN_BYTES && !heap_warned) {
+        ESP_LOGW(TAG, "Heap low: %u bytes free, largest block %u bytes", (unsigned)heap_free, (unsigned)heap_largest);
+        heap_warned = true;
+    } else if (heap_free >= CONFIG_BSP_MONITOR_HEAP_WARN_BYTES) {
+        heap_warned = false;
+    }
+
+    bsp_metrics_set(BSP_METRIC_HEAP_FREE, (int32_t)heap_free);
+    bsp_metrics_set(BSP_METRIC_HEAP_MIN_FREE, (int32_t)heap_min_free);
+    bsp_metrics_set(BSP_METRIC_HEAP_LARGEST, (int32_t)heap_largest);
+    if (stack_min_free != UINT32_MAX) {
+        bsp_metrics_set(BSP_METRIC_STACK_MIN_FREE, (int32_t)stack_min_free);
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_monitor_sample(void)
+{
+    return bsp_monitor_sample_wait(portMAX_DELAY);
+}
+
+static void bsp_monitor_timer_cb(void *arg)
+{
+    // Never block the esp_timer task: if a task holds the lock, this period is skipped
+    bsp_monitor_sample_wait(0);
+}
+
+esp_err_t bsp_monitor_start(uint32_t period_ms)
+{
+    if (period_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (monitor_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    TaskHandle_t log_task = bsp_log_get_task_handle();
+    if (log_task != NULL) {
+        bsp_monitor_add_task(log_task, BSP_LOG_TASK_STACK_SIZE);
+    }
+    TaskHandle_t worker_task = bsp_worker_get_task_handle();
+    if (worker_task != NULL) {
+        bsp_monitor_add_task(worker_task, BSP_WORKER_TASK_STACK_SIZE);
+    }
+#if BSP_CAPS_VIBRAMOTOR
+    TaskHandle_t vibramotor_task = vibramotor_get_task_handle();
+    if (vibramotor_task != NULL) {
+        bsp_monitor_add_task(vibramotor_task, CONFIG_VIBRAMOTOR_TASK_STACK_SIZE);
+    }
+#endif
+
+    if (monitor_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = bsp_monitor_timer_cb,
+            .name = "bsp_monitor",
+            .skip_unhandled_events = true,
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &monitor_timer), TAG, "Failed to create timer");
+    } else if (esp_timer_is_active(monitor_timer)) {
+        esp_timer_stop(monitor_timer);
+    }
+
+    bsp_monitor_sample();
+    return esp_timer_start_periodic(monitor_timer, (uint64_t)period_ms * 1000);
+}
+
+esp_err_t bsp_monitor_stop(void)
+{
+    if (monitor_timer == NULL || !esp_timer_is_active(monitor_timer)) {
+        return ESP_OK;
+    }
+    return esp_timer_stop(monitor_timer);
+}
+
+esp_err_t bsp_monitor_print(void)
+{
+    ESP_RETURN_ON_ERROR(bsp_monitor_sample(), TAG, "Monitor is not initialized");
+
+    bsp_monitor_lock(portMAX_DELAY);
+    for (int i = 0; i < CONFIG_BSP_MONITOR_MAX_TASKS; i++) {
+        const bsp_monitor_task_t *t = &tasks[i];
+        if (t->task == NULL) {
+            continue;
+        }
+        if (t->stack_size > 0) {
+            ESP_LOGI(TAG, "%-20s min free %5lu of %5lu bytes", pcTaskGetName(t->task),
+                     (unsigned long)t->min_free, (unsigned long)t->stack_size);
+        } else {
+            ESP_LOGI(TAG, "%-20s min free %5lu bytes", pcTaskGetName(t->task), (unsigned long)t->min_free);
+        }
+    }
+    bsp_monitor_unlock();
+
+    ESP_LOGI(TAG, "heap free %u, min free %u, largest block %u",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+    return ESP_OK;
+}
+
+#else /* !CONFIG_BSP_MONITOR */
+
+esp_err_t bsp_monitor_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_monitor_add_task(TaskHandle_t task, uint32_t stack_size)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_monitor_remove_task(TaskHandle_t task)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_monitor_start(uint32_t period_ms)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_monitor_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_monitor_sample(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_monitor_print(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_MONITOR */
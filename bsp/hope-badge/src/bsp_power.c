@@ -0,0 +1,149 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_sleep.h"
+
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_power.h"
+
+#if CONFIG_BSP_PM_ENABLE
+#include "esp_pm.h"
+
+static const char *TAG = "BSP-POWER";
+
+static esp_pm_lock_handle_t pm_locks[BSP_PM_LOCK_MAX] = {NULL};
+static bool power_initialized = false;
+
+static const char *const pm_lock_names[BSP_PM_LOCK_MAX] = {
+    [BSP_PM_LOCK_LED] = "bsp_led",
+    [BSP_PM_LOCK_I2C] = "bsp_i2c",
+};
+
+static void bsp_power_delete_locks(void)
+{
+    for (int i = 0; i < BSP_PM_LOCK_MAX; i++) {
+        if (pm_locks[i] != NULL) {
+            esp_pm_lock_delete(pm_locks[i]);
+            pm_locks[i] = NULL;
+        }
+    }
+}
+
+esp_err_t bsp_power_init(void)
+{
+    if (power_initialized) {
+        ESP_LOGW(TAG, "Power management is already initialized");
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < BSP_PM_LOCK_MAX; i++) {
+        ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, pm_lock_names[i], &pm_locks[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create PM lock %s: %s", pm_lock_names[i], esp_err_to_name(ret));
+            bsp_power_delete_locks();
+            return ret;
+        }
+    }
+
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_BSP_PM_MAX_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_BSP_PM_MIN_FREQ_MHZ,
+#if CONFIG_BSP_PM_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#endif
+    };
+    ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure power management: %s", esp_err_to_name(ret));
+        bsp_power_delete_locks();
+        return ret;
+    }
+
+#if CONFIG_BSP_PM_LIGHT_SLEEP
+    /*
+     * The pins are armed by their owners, each at the level that means "work pending" and only
+     * while that work can be serviced: the buttons by the button driver or bsp_gesture, the PCF8574
+     * INT line by the expander group.
+     */
+    ret = esp_sleep_enable_gpio_wakeup();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable GPIO wake-up: %s", esp_err_to_name(ret));
+        bsp_power_delete_locks();
+        return ret;
+    }
+#endif
+
+    power_initialized = true;
+    ESP_LOGI(TAG, "Power management enabled: %d-%d MHz, light sleep %s",
+             CONFIG_BSP_PM_MIN_FREQ_MHZ, CONFIG_BSP_PM_MAX_FREQ_MHZ,
+             pm_config.light_sleep_enable ? "on" : "off");
+    return ESP_OK;
+}
+
+esp_err_t bsp_power_deinit(void)
+{
+    if (!power_initialized) {
+        return ESP_OK;
+    }
+
+    bsp_power_delete_locks();
+    power_initialized = false;
+    return ESP_OK;
+}
+
+esp_err_t bsp_power_lock_acquire(bsp_pm_lock_t lock)
+{
+    if (lock >= BSP_PM_LOCK_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pm_locks[lock] == NULL) {
+        return ESP_OK;
+    }
+    return esp_pm_lock_acquire(pm_locks[lock]);
+}
+
+esp_err_t bsp_power_lock_release(bsp_pm_lock_t lock)
+{
+    if (lock >= BSP_PM_LOCK_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pm_locks[lock] == NULL) {
+        return ESP_OK;
+    }
+    return esp_pm_lock_release(pm_locks[lock]);
+}
+
+#else /* !CONFIG_BSP_PM_ENABLE */
+
+esp_err_t bsp_power_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t bsp_power_deinit(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t bsp_power_lock_acquire(bsp_pm_lock_t lock)
+{
+    return (lock < BSP_PM_LOCK_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t bsp_power_lock_release(bsp_pm_lock_t lock)
+{
+    return (lock < BSP_PM_LOCK_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+#endif /* CONFIG_BSP_PM_ENABLE */
@@ -0,0 +1,338 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_sched.h"
+
+#if CONFIG_BSP_SCHED
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "bsp/bsp_metrics.h"
+
+static const char *TAG = "BSP-SCHED";
+
+static TaskHandle_t sched_task = NULL;
+static volatile bool sched_stop = false;
+static bsp_sched_job_t *timer_head = NULL;     // Armed jobs, earliest deadline first
+static bsp_sched_job_t *ready_head = NULL;     // Posted and due jobs, in order
+static bsp_sched_job_t *ready_tail = NULL;
+static portMUX_TYPE sched_lock = portMUX_INITIALIZER_UNLOCKED;
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t sched_task_buf;
+static StackType_t sched_task_stack[CONFIG_BSP_SCHED_TASK_STACK_SIZE];
+#endif
+
+/* List helpers, called with sched_lock held */
+
+static void bsp_sched_timer_remove(bsp_sched_job_t *job)
+{
+    for (bsp_sched_job_t **p = &timer_head; *p != NULL; p = &(*p)->next_timer) {
+        if (*p == job) {
+            *p = job->next_timer;
+            break;
+        }
+    }
+    job->next_timer = NULL;
+    job->armed = false;
+}
+
+/* Jobs with equal deadlines keep their arming order. Return true if the job is the new head. */
+static bool bsp_sched_timer_insert(bsp_sched_job_t *job)
+{
+    bsp_sched_job_t **p = &timer_head;
+    while (*p != NULL && (*p)->deadline_us <= job->deadline_us) {
+        p = &(*p)->next_timer;
+    }
+    job->next_timer = *p;
+    *p = job;
+    job->armed = true;
+    return p == &timer_head;
+}
+
+static void IRAM_ATTR bsp_sched_ready_push(bsp_sched_job_t *job)
+{
+    if (job->pending) {
+        return;     // Already queued, runs once
+    }
+    job->pending = true;
+    job->next_ready = NULL;
+    if (ready_tail != NULL) {
+        ready_tail->next_ready = job;
+    } else {
+        ready_head = job;
+    }
+    ready_tail = job;
+}
+
+static bsp_sched_job_t *bsp_sched_ready_pop(void)
+{
+    bsp_sched_job_t *job = ready_head;
+    if (job != NULL) {
+        ready_head = job->next_ready;
+        if (ready_head == NULL) {
+            ready_tail = NULL;
+        }
+        job->next_ready = NULL;
+        job->pending = false;
+    }
+    return job;
+}
+
+static void bsp_sched_ready_remove(bsp_sched_job_t *job)
+{
+    bsp_sched_job_t *prev = NULL;
+    for (bsp_sched_job_t *p = ready_head; p != NULL; prev = p, p = p->next_ready) {
+        if (p != job) {
+            continue;
+        }
+        if (prev != NULL) {
+            prev->next_ready = job->next_ready;
+        } else {
+            ready_head = job->next_ready;
+        }
+        if (ready_tail == job) {
+            ready_tail = prev;
+        }
+        break;
+    }
+    job->next_ready = NULL;
+    job->pending = false;
+}
+
+static void bsp_sched_wake(void)
+{
+    TaskHandle_t task = sched_task;
+    if (task != NULL && task != xTaskGetCurrentTaskHandle()) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static void bsp_sched_task(void *arg)
+{
+    while (!sched_stop) {
+        const int64_t now = esp_timer_get_time();
+        int64_t late_us = -1;
+        int64_t next_us = 0;
+
+        taskENTER_CRITICAL(&sched_lock);
+        // Due timers queue up behind the jobs posted so far
+        while (timer_head != NULL && timer_head->deadline_us <= now) {
+            bsp_sched_job_t *due = timer_head;
+            timer_head = due->next_timer;
+            due->next_timer = NULL;
+            due->armed = false;
+            if (now - due->deadline_us > late_us) {
+                late_us = now - due->deadline_us;
+            }
+            if (due->period_us != 0) {
+                // Keep the phase, skip the periods that are already over
+                const int64_t missed = (now - due->deadline_us) / due->period_us;
+                due->deadline_us += (missed + 1) * due->period_us;
+                bsp_sched_timer_insert(due);
+            }
+            bsp_sched_ready_push(due);
+        }
+        bsp_sched_job_t *job = bsp_sched_ready_pop();
+        if (job == NULL && timer_head != NULL) {
+            next_us = timer_head->deadline_us;
+        }
+        taskEXIT_CRITICAL(&sched_lock);
+
+        if (late_us >= 0) {
+            bsp_metrics_record_us(BSP_METRIC_SCHED_LATE_US, (uint32_t)late_us);
+        }
+
+        if (job != NULL) {
+            const int64_t start = esp_timer_get_time();
+            job->callback(job, job->arg);
+            const uint32_t run_us = (uint32_t)(esp_timer_get_time() - start);
+            bsp_metrics_record_us(BSP_METRIC_SCHED_RUN_US, run_us);
+            bsp_metrics_inc(BSP_METRIC_SCHED_RUNS);
+            if (run_us > CONFIG_BSP_SCHED_SLOW_MS * 1000) {
+                ESP_LOGW(TAG, "Job %s ran for %lu us", job->name ? job->name : "?", (unsigned long)run_us);
+            }
+            continue;
+        }
+
+        TickType_t wait = portMAX_DELAY;
+        if (next_us != 0) {
+            const int64_t remaining_us = next_us - esp_timer_get_time();
+            wait = (remaining_us <= 0) ? 0 : pdMS_TO_TICKS((remaining_us + 999) / 1000) + 1;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+
+    sched_task = NULL;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t bsp_sched_arm(bsp_sched_job_t *job, uint32_t delay_ms, uint32_t period_ms)
+{
+    ESP_RETURN_ON_FALSE(job != NULL && job->callback != NULL, ESP_ERR_INVALID_ARG, TAG, "Job with callback required");
+
+    const int64_t deadline_us = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+    taskENTER_CRITICAL(&sched_lock);
+    if (job->armed) {
+        bsp_sched_timer_remove(job);
+    }
+    job->deadline_us = deadline_us;
+    job->period_us = (int64_t)period_ms * 1000;
+    const bool head = bsp_sched_timer_insert(job);
+    taskEXIT_CRITICAL(&sched_lock);
+
+    // Only an earlier wake-up needs the task
+    if (head) {
+        bsp_sched_wake();
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_sched_after(bsp_sched_job_t *job, uint32_t delay_ms)
+{
+    return bsp_sched_arm(job, delay_ms, 0);
+}
+
+esp_err_t bsp_sched_every(bsp_sched_job_t *job, uint32_t period_ms)
+{
+    ESP_RETURN_ON_FALSE(period_ms != 0, ESP_ERR_INVALID_ARG, TAG, "Period must not be 0");
+    return bsp_sched_arm(job, period_ms, period_ms);
+}
+
+esp_err_t bsp_sched_post(bsp_sched_job_t *job)
+{
+    ESP_RETURN_ON_FALSE(job != NULL && job->callback != NULL, ESP_ERR_INVALID_ARG, TAG, "Job with callback required");
+
+    taskENTER_CRITICAL(&sched_lock);
+    bsp_sched_ready_push(job);
+    taskEXIT_CRITICAL(&sched_lock);
+    bsp_sched_wake();
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR bsp_sched_post_from_isr(bsp_sched_job_t *job, BaseType_t *woken)
+{
+    if (job == NULL || job->callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL_ISR(&sched_lock);
+    bsp_sched_ready_push(job);
+    portEXIT_CRITICAL_ISR(&sched_lock);
+    TaskHandle_t task = sched_task;
+    if (task != NULL) {
+        vTaskNotifyGiveFromISR(task, woken);
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_sched_cancel(bsp_sched_job_t *job)
+{
+    ESP_RETURN_ON_FALSE(job != NULL, ESP_ERR_INVALID_ARG, TAG, "Job required");
+
+    taskENTER_CRITICAL(&sched_lock);
+    if (job->armed) {
+        bsp_sched_timer_remove(job);
+    }
+    if (job->pending) {
+        bsp_sched_ready_remove(job);
+    }
+    taskEXIT_CRITICAL(&sched_lock);
+    return ESP_OK;
+}
+
+esp_err_t bsp_sched_start(const bsp_sched_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config != NULL, ESP_ERR_INVALID_ARG, TAG, "Config is required");
+    ESP_RETURN_ON_FALSE(sched_task == NULL, ESP_ERR_INVALID_STATE, TAG, "Already running");
+
+    sched_stop = false;
+    TaskHandle_t task = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+    task = xTaskCreateStatic(bsp_sched_task, "bsp_sched", CONFIG_BSP_SCHED_TASK_STACK_SIZE, NULL,
+                             config->task_priority, sched_task_stack, &sched_task_buf);
+#else
+    xTaskCreate(bsp_sched_task, "bsp_sched", CONFIG_BSP_SCHED_TASK_STACK_SIZE, NULL, config->task_priority, &task);
+#endif
+    ESP_RETURN_ON_FALSE(task != NULL, ESP_ERR_NO_MEM, TAG, "Failed to create scheduler task");
+    sched_task = task;
+    // Jobs armed before the start may be due already
+    xTaskNotifyGive(task);
+    return ESP_OK;
+}
+
+esp_err_t bsp_sched_stop(void)
+{
+    // Let the task finish, it may be inside a callback
+    sched_stop = true;
+    TaskHandle_t task = sched_task;
+    // From a job the task cannot be waited for: it exits once the job returns
+    if (task == NULL || task == xTaskGetCurrentTaskHandle()) {
+        return ESP_OK;
+    }
+    while ((task = sched_task) != NULL) {
+        xTaskNotifyGive(task);
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+TaskHandle_t bsp_sched_get_task_handle(void)
+{
+    return sched_task;
+}
+
+#else /* !CONFIG_BSP_SCHED */
+
+esp_err_t bsp_sched_start(const bsp_sched_config_t *config)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_sched_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_sched_after(bsp_sched_job_t *job, uint32_t delay_ms)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_sched_every(bsp_sched_job_t *job, uint32_t period_ms)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_sched_post(bsp_sched_job_t *job)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_sched_post_from_isr(bsp_sched_job_t *job, BaseType_t *woken)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_sched_cancel(bsp_sched_job_t *job)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+TaskHandle_t bsp_sched_get_task_handle(void)
+{
+    return NULL;
+}
+
+#endif /* CONFIG_BSP_SCHED */
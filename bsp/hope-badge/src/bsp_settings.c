@@ -0,0 +1,260 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_settings.h"
+
+typedef struct {
+    const char *key;
+    int32_t def;
+    int32_t min;
+    int32_t max;
+} bsp_setting_desc_t;
+
+#define BSP_SETTING_DESC(id, k, d, lo, hi) [BSP_SETTING_##id] = {.key = k, .def = d, .min = lo, .max = hi},
+
+static const bsp_setting_desc_t setting_descs[BSP_SETTING_MAX] = {
+    BSP_SETTINGS_LIST(BSP_SETTING_DESC)
+};
+
+#undef BSP_SETTING_DESC
+
+static inline bool bsp_settings_valid_id(bsp_setting_id_t id)
+{
+    return id >= 0 && id < BSP_SETTING_MAX;
+}
+
+const char *bsp_settings_key(bsp_setting_id_t id)
+{
+    return bsp_settings_valid_id(id) ? setting_descs[id].key : NULL;
+}
+
+#if CONFIG_BSP_SETTINGS
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "bsp/bsp_metrics.h"
+#include "bsp_priv.h"
+
+static const char *TAG = "BSP-SET";
+
+#define BSP_SETTINGS_NVS_NAMESPACE  "bsp"
+
+static int32_t values[BSP_SETTING_MAX];
+static int32_t stored[BSP_SETTING_MAX];         // What NVS holds, the default for absent keys
+static int64_t first_change_us = 0;             // 0 while nothing is pending
+static bool settings_ready = false;
+static bool settings_persist = false;           // NVS is usable
+static esp_timer_handle_t commit_timer = NULL;
+static SemaphoreHandle_t settings_lock = NULL;
+static StaticSemaphore_t settings_lock_buf;
+
+static esp_err_t bsp_settings_nvs_open(nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    // NVS belongs to the application: without nvs_flash_init() the settings are just not persisted
+    return nvs_open(BSP_SETTINGS_NVS_NAMESPACE, mode, handle);
+}
+
+/* Restart the debounce, bounded by the maximum delay since the first unsaved change */
+static void bsp_settings_schedule_locked(void)
+{
+    const int64_t now = esp_timer_get_time();
+    esp_timer_stop(commit_timer);
+
+    if (memcmp(values, stored, sizeof(values)) == 0) {
+        first_change_us = 0;
+        return;
+    }
+    if (first_change_us == 0) {
+        first_change_us = now;
+    }
+    int64_t deadline = now + (int64_t)CONFIG_BSP_SETTINGS_COMMIT_DELAY_MS * 1000;
+    const int64_t latest = first_change_us + (int64_t)CONFIG_BSP_SETTINGS_COMMIT_MAX_DELAY_MS * 1000;
+    if (deadline > latest) {
+        deadline = latest;
+    }
+    esp_timer_start_once(commit_timer, (deadline > now) ? (uint64_t)(deadline - now) : 0);
+}
+
+static void bsp_settings_commit_timer_cb(void *arg)
+{
+    // Writing flash would stall every other esp_timer callback, the worker task commits
+    bsp_worker_post(BSP_WORK_SETTINGS_COMMIT);
+}
+
+esp_err_t bsp_settings_init(void)
+{
+    if (settings_ready) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < BSP_SETTING_MAX; i++) {
+        values[i] = setting_descs[i].def;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t ret = bsp_settings_nvs_open(NVS_READONLY, &handle);
+    if (ret == ESP_OK) {
+        for (int i = 0; i < BSP_SETTING_MAX; i++) {
+            int32_t value;
+            if (nvs_get_i32(handle, setting_descs[i].key, &value) != ESP_OK) {
+                continue;
+            }
+            if (value < setting_descs[i].min || value > setting_descs[i].max) {
+                // Left over from a build with other ranges, the default stays until the next change
+                ESP_LOGW(TAG, "Setting %s out of range (%ld), using default", setting_descs[i].key, (long)value);
+                continue;
+            }
+            values[i] = value;
+        }
+        nvs_close(handle);
+        settings_persist = true;
+    } else if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        settings_persist = true;    // Namespace does not exist before the first commit
+    } else if (ret == ESP_ERR_NVS_NOT_INITIALIZED) {
+        ESP_LOGW(TAG, "NVS is not initialized, settings are not persisted");
+    } else {
+        // Never erase the application's NVS here, just run on defaults
+        ESP_LOGW(TAG, "NVS not available (%s), settings are not persisted", esp_err_to_name(ret));
+    }
+    memcpy(stored, values, sizeof(stored));
+
+    settings_lock = xSemaphoreCreateMutexStatic(&settings_lock_buf);
+    const esp_timer_create_args_t timer_args = {
+        .callback = bsp_settings_commit_timer_cb,
+        .name = "bsp_settings",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &commit_timer), TAG, "Failed to create commit timer");
+
+    settings_ready = true;
+    return ESP_OK;
+}
+
+int32_t bsp_settings_get(bsp_setting_id_t id)
+{
+    return bsp_settings_valid_id(id) ? values[id] : 0;
+}
+
+esp_err_t bsp_settings_set(bsp_setting_id_t id, int32_t value)
+{
+    ESP_RETURN_ON_FALSE(bsp_settings_valid_id(id), ESP_ERR_INVALID_ARG, TAG, "Invalid setting %d", id);
+    ESP_RETURN_ON_FALSE(value >= setting_descs[id].min && value <= setting_descs[id].max, ESP_ERR_INVALID_ARG, TAG,
+                        "Setting %s out of range (%ld)", setting_descs[id].key, (long)value);
+    ESP_RETURN_ON_FALSE(settings_ready, ESP_ERR_INVALID_STATE, TAG, "Settings are not initialized");
+
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+    if (values[id] != value) {
+        values[id] = value;
+        if (settings_persist) {
+            bsp_settings_schedule_locked();
+        } else {
+            stored[id] = value;
+        }
+    }
+    xSemaphoreGive(settings_lock);
+    return ESP_OK;
+}
+
+esp_err_t bsp_settings_reset(bsp_setting_id_t id)
+{
+    ESP_RETURN_ON_FALSE(bsp_settings_valid_id(id), ESP_ERR_INVALID_ARG, TAG, "Invalid setting %d", id);
+    return bsp_settings_set(id, setting_descs[id].def);
+}
+
+esp_err_t bsp_settings_commit(void)
+{
+    ESP_RETURN_ON_FALSE(settings_ready, ESP_ERR_INVALID_STATE, TAG, "Settings are not initialized");
+
+    // Setters wait for the few milliseconds a commit takes
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+
+    // Only settings that differ from flash are written, all under one nvs_commit()
+    uint32_t writes = 0;
+    esp_err_t ret = ESP_OK;
+    nvs_handle_t handle;
+    for (int i = 0; i < BSP_SETTING_MAX; i++) {
+        if (values[i] == stored[i]) {
+            continue;
+        }
+        if (writes == 0) {
+            ret = bsp_settings_nvs_open(NVS_READWRITE, &handle);
+            if (ret != ESP_OK) {
+                break;
+            }
+        }
+        writes++;
+        ret = nvs_set_i32(handle, setting_descs[i].key, values[i]);
+        if (ret != ESP_OK) {
+            break;
+        }
+    }
+    if (writes > 0) {
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+    if (ret == ESP_OK) {
+        memcpy(stored, values, sizeof(stored));
+    } else {
+        // Retry after a full debounce delay rather than right away
+        first_change_us = 0;
+    }
+    bsp_settings_schedule_locked();
+    xSemaphoreGive(settings_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to commit settings: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (writes > 0) {
+        bsp_metrics_inc(BSP_METRIC_SETTINGS_COMMITS);
+        bsp_metrics_add(BSP_METRIC_SETTINGS_WRITES, writes);
+        ESP_LOGD(TAG, "Committed %lu settings", (unsigned long)writes);
+    }
+    return ESP_OK;
+}
+
+#else /* !CONFIG_BSP_SETTINGS */
+
+esp_err_t bsp_settings_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+int32_t bsp_settings_get(bsp_setting_id_t id)
+{
+    return bsp_settings_valid_id(id) ? setting_descs[id].def : 0;
+}
+
+esp_err_t bsp_settings_set(bsp_setting_id_t id, int32_t value)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_settings_reset(bsp_setting_id_t id)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_settings_commit(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_SETTINGS */
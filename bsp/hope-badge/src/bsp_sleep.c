@@ -0,0 +1,141 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+#include "driver/gpio.h"
+
+#include "bsp/bsp_hope.h"
+#include "bsp/bsp_power.h"
+#include "bsp/bsp_settings.h"
+#include "bsp/bsp_evlog.h"
+#include "bsp_priv.h"
+
+static const char *TAG = "BSP-SLEEP";
+
+#define BSP_RETAINED_MAGIC  0x48504531  /* "HPE1" */
+
+#if CONFIG_BSP_DEEP_SLEEP_RETENTION
+/* Zeroed on cold boot, kept across deep sleep */
+static RTC_DATA_ATTR bsp_retained_state_t rtc_state;
+#endif
+
+static uint32_t bsp_retained_crc(const bsp_retained_state_t *state)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(bsp_retained_state_t, crc));
+}
+
+const bsp_retained_state_t *bsp_sleep_get_resume_state(void)
+{
+#if CONFIG_BSP_DEEP_SLEEP_RETENTION
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP) {
+        return NULL;
+    }
+    if (rtc_state.magic != BSP_RETAINED_MAGIC || rtc_state.crc != bsp_retained_crc(&rtc_state)) {
+        ESP_LOGW(TAG, "Retained BSP state is invalid, doing a full init");
+        return NULL;
+    }
+    return &rtc_state;
+#else
+    return NULL;
+#endif
+}
+
+bool bsp_deep_sleep_is_resume(void)
+{
+    return bsp_sleep_get_resume_state() != NULL;
+}
+
+#if CONFIG_BSP_DEEP_SLEEP_RETENTION
+static void bsp_sleep_save_state(void)
+{
+    memset(&rtc_state, 0, sizeof(rtc_state));
+
+    pcf8574_handle_t pcf = bsp_pcf8574_get_handle();
+    if (pcf != NULL) {
+        pcf8574_get_address(pcf, &rtc_state.pcf8574_addr);
+        pcf8574_get_output(pcf, &rtc_state.pcf8574_output);
+        pcf8574_get_direction(pcf, &rtc_state.pcf8574_input_mask);
+    }
+
+    bsp_i2c_get_presence(rtc_state.i2c_presence);
+
+    const uint8_t *frame = bsp_led_rgb_get_frame();
+    memcpy(rtc_state.led_rgb_frame, frame, sizeof(rtc_state.led_rgb_frame));
+
+    rtc_state.magic = BSP_RETAINED_MAGIC;
+    rtc_state.crc = bsp_retained_crc(&rtc_state);
+}
+#endif
+
+static void bsp_sleep_add_wakeup_gpio(int gpio_num, int active_level, uint64_t *low_mask, uint64_t *high_mask)
+{
+    if (gpio_num < 0 || !esp_sleep_is_valid_wakeup_gpio((gpio_num_t)gpio_num)) {
+        return;
+    }
+    if (active_level) {
+        *high_mask |= (1ULL << gpio_num);
+    } else {
+        *low_mask |= (1ULL << gpio_num);
+    }
+}
+
+esp_err_t bsp_deep_sleep_start(uint64_t wakeup_time_us)
+{
+    /*
+     * Only GPIO0-5 can wake the ESP32-C3 from deep sleep. Lines wired elsewhere
+     * (e.g. the default buttons on GPIO9/10) are skipped.
+     */
+    uint64_t low_mask = 0;
+    uint64_t high_mask = 0;
+    const bsp_board_desc_t *board = bsp_get_board_desc();
+    for (int i = 0; i < BSP_BUTTON_NUM; i++) {
+        bsp_sleep_add_wakeup_gpio(board->buttons[i].gpio, board->buttons[i].active_level, &low_mask, &high_mask);
+    }
+    bsp_sleep_add_wakeup_gpio(board->pcf8574_int_gpio, 0, &low_mask, &high_mask);
+    bsp_sleep_add_wakeup_gpio(board->fuel_gauge_alrt_gpio, 0, &low_mask, &high_mask);
+
+    if (low_mask) {
+        ESP_RETURN_ON_ERROR(esp_deep_sleep_enable_gpio_wakeup(low_mask, ESP_GPIO_WAKEUP_GPIO_LOW),
+                            TAG, "Failed to enable low-level wake-up");
+    }
+    if (high_mask) {
+        ESP_RETURN_ON_ERROR(esp_deep_sleep_enable_gpio_wakeup(high_mask, ESP_GPIO_WAKEUP_GPIO_HIGH),
+                            TAG, "Failed to enable high-level wake-up");
+    }
+    if (wakeup_time_us > 0) {
+        ESP_RETURN_ON_ERROR(esp_sleep_enable_timer_wakeup(wakeup_time_us), TAG, "Failed to enable timer wake-up");
+    }
+    if (low_mask == 0 && high_mask == 0 && wakeup_time_us == 0) {
+        ESP_LOGE(TAG, "No wake-up source available");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+#if CONFIG_BSP_DEEP_SLEEP_RETENTION
+    bsp_sleep_save_state();
+#endif
+#if CONFIG_BSP_SETTINGS
+    // RAM is lost in deep sleep, write out changes still waiting for their debounce
+    bsp_settings_commit();
+#endif
+#if CONFIG_BSP_EVLOG
+    bsp_evlog_flush();
+#endif
+
+    ESP_LOGI(TAG, "Entering deep sleep");
+    esp_deep_sleep_start();
+}
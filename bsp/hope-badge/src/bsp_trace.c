@@ -0,0 +1,205 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_trace.h"
+
+#if CONFIG_BSP_TRACE
+#include "esp_attr.h"
+#include "esp_timer.h"
+#if CONFIG_BSP_TRACE_APPTRACE
+#include "esp_app_trace.h"
+#endif
+
+#include "bsp/bsp_hope.h"
+#include "vibramotor.h"
+
+#define BSP_TRACE_RING_SIZE     CONFIG_BSP_TRACE_BUF_EVENTS
+#define BSP_TRACE_RING_MASK     (BSP_TRACE_RING_SIZE - 1)
+#define BSP_TRACE_HEADER_LEN    8
+
+_Static_assert((BSP_TRACE_RING_SIZE & BSP_TRACE_RING_MASK) == 0, "Trace buffer size must be a power of two");
+
+/*
+ * Writers reserve a slot with one atomic increment and publish it by storing the
+ * event id last; the reader stops at the first slot that is not published yet.
+ * There is a single reader (the task calling bsp_trace_dump() or the apptrace flush).
+ */
+static bsp_trace_record_t ring[BSP_TRACE_RING_SIZE];
+static atomic_uint_least32_t head = 0;
+static uint32_t tail = 0;
+static uint32_t lost = 0;
+static atomic_bool enabled = false;
+
+void IRAM_ATTR bsp_trace_event(uint8_t event, uint8_t arg0, uint16_t arg1)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        return;
+    }
+
+    uint32_t idx = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    bsp_trace_record_t *rec = &ring[idx & BSP_TRACE_RING_MASK];
+    rec->timestamp_us = (uint32_t)esp_timer_get_time();
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+    atomic_store_explicit((_Atomic uint8_t *)&rec->event, event, memory_order_release);
+}
+
+#if BSP_CAPS_VIBRAMOTOR
+static void bsp_trace_haptic_cb(bool on)
+{
+    bsp_trace_event(on ? BSP_TRACE_HAPTIC_ON : BSP_TRACE_HAPTIC_OFF, 0, 0);
+}
+#endif
+
+/* The PCF8574 hook is installed by the BSP for good (bsp_hope.c), bsp_trace_event() drops events while stopped */
+esp_err_t bsp_trace_start(void)
+{
+#if BSP_CAPS_VIBRAMOTOR
+    vibramotor_set_step_cb(bsp_trace_haptic_cb);
+#endif
+    atomic_store(&enabled, true);
+    return ESP_OK;
+}
+
+esp_err_t bsp_trace_stop(void)
+{
+    atomic_store(&enabled, false);
+#if BSP_CAPS_VIBRAMOTOR
+    vibramotor_set_step_cb(NULL);
+#endif
+    return ESP_OK;
+}
+
+static inline void bsp_trace_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+size_t bsp_trace_read_packet(uint8_t *buf, size_t len)
+{
+    if (buf == NULL || len < BSP_TRACE_HEADER_LEN + sizeof(bsp_trace_record_t)) {
+        return 0;
+    }
+
+    uint32_t h = atomic_load_explicit(&head, memory_order_acquire);
+    if (h - tail > BSP_TRACE_RING_SIZE) {
+        // Overwritten before they were read
+        lost += h - tail - BSP_TRACE_RING_SIZE;
+        tail = h - BSP_TRACE_RING_SIZE;
+    }
+
+    size_t max = (len - BSP_TRACE_HEADER_LEN) / sizeof(bsp_trace_record_t);
+    if (max > UINT8_MAX) {
+        max = UINT8_MAX;
+    }
+
+    uint8_t *p = buf + BSP_TRACE_HEADER_LEN;
+    size_t count = 0;
+    while (tail != h && count < max) {
+        bsp_trace_record_t *rec = &ring[tail & BSP_TRACE_RING_MASK];
+        uint8_t event = atomic_load_explicit((_Atomic uint8_t *)&rec->event, memory_order_acquire);
+        if (event == 0) {
+            break;      // Reserved but not written yet
+        }
+        bsp_trace_put_u32(p, rec->timestamp_us);
+        p[4] = event;
+        p[5] = rec->arg0;
+        p[6] = rec->arg1 & 0xFF;
+        p[7] = rec->arg1 >> 8;
+        atomic_store_explicit((_Atomic uint8_t *)&rec->event, 0, memory_order_relaxed);
+        p += sizeof(bsp_trace_record_t);
+        tail++;
+        count++;
+    }
+
+    if (count == 0 && lost == 0) {
+        return 0;
+    }
+
+    buf[0] = BSP_TRACE_PACKET_MAGIC & 0xFF;
+    buf[1] = BSP_TRACE_PACKET_MAGIC >> 8;
+    buf[2] = BSP_TRACE_PACKET_VERSION;
+    buf[3] = (uint8_t)count;
+    bsp_trace_put_u32(&buf[4], lost);
+    lost = 0;
+    return BSP_TRACE_HEADER_LEN + count * sizeof(bsp_trace_record_t);
+}
+
+esp_err_t bsp_trace_dump(void)
+{
+    static uint8_t packet[BSP_TRACE_HEADER_LEN + 32 * sizeof(bsp_trace_record_t)];
+    size_t len;
+
+    while ((len = bsp_trace_read_packet(packet, sizeof(packet))) > 0) {
+        printf("BSPT:");
+        for (size_t i = 0; i < len; i++) {
+            printf("%02x", packet[i]);
+        }
+        printf("\n");
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_trace_flush_apptrace(uint32_t timeout_us)
+{
+#if CONFIG_BSP_TRACE_APPTRACE
+    static uint8_t packet[BSP_TRACE_HEADER_LEN + 128 * sizeof(bsp_trace_record_t)];
+    size_t len;
+
+    while ((len = bsp_trace_read_packet(packet, sizeof(packet))) > 0) {
+        esp_err_t ret = esp_apptrace_write(ESP_APPTRACE_DEST_JTAG, packet, len, timeout_us);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return esp_apptrace_flush(ESP_APPTRACE_DEST_JTAG, timeout_us);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#else /* !CONFIG_BSP_TRACE */
+
+esp_err_t bsp_trace_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_trace_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+size_t bsp_trace_read_packet(uint8_t *buf, size_t len)
+{
+    return 0;
+}
+
+esp_err_t bsp_trace_dump(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t bsp_trace_flush_apptrace(uint32_t timeout_us)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif /* CONFIG_BSP_TRACE */
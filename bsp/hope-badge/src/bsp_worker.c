@@ -0,0 +1,99 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#include "bsp/bsp_evlog.h"
+#include "bsp/bsp_load.h"
+#include "bsp/bsp_settings.h"
+#include "bsp_priv.h"
+
+#if CONFIG_BSP_WORKER
+static const char *TAG = "BSP-WORK";
+
+static TaskHandle_t worker_task = NULL;
+#if CONFIG_BSP_STATIC_ALLOC
+static StaticTask_t worker_task_buf;
+static StackType_t worker_task_stack[BSP_WORKER_TASK_STACK_SIZE];
+#endif
+
+static void bsp_worker_task(void *arg)
+{
+    while (1) {
+        uint32_t work = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &work, portMAX_DELAY);
+
+        if (work & BSP_WORK_SETTINGS_COMMIT) {
+            bsp_settings_commit();
+        }
+        if (work & BSP_WORK_EVLOG_FLUSH) {
+            bsp_evlog_flush();
+        }
+        if (work & BSP_WORK_LOAD_SAMPLE) {
+            bsp_load_sample();
+        }
+    }
+}
+
+esp_err_t bsp_worker_init(void)
+{
+    if (worker_task != NULL) {
+        return ESP_OK;
+    }
+
+    TaskHandle_t task = NULL;
+
+    // Just above idle: the work is flash and bus traffic that can wait for the application
+#if CONFIG_BSP_STATIC_ALLOC
+    task = xTaskCreateStatic(bsp_worker_task, "bsp_worker", BSP_WORKER_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+                             worker_task_stack, &worker_task_buf);
+#else
+    xTaskCreate(bsp_worker_task, "bsp_worker", BSP_WORKER_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, &task);
+#endif
+    ESP_RETURN_ON_FALSE(task != NULL, ESP_ERR_NO_MEM, TAG, "Failed to create worker task");
+    worker_task = task;
+    return ESP_OK;
+}
+
+void bsp_worker_post(uint32_t work)
+{
+    TaskHandle_t task = worker_task;
+    if (task != NULL) {
+        xTaskNotify(task, work, eSetBits);
+    }
+}
+
+TaskHandle_t bsp_worker_get_task_handle(void)
+{
+    return worker_task;
+}
+
+#else /* !CONFIG_BSP_WORKER */
+
+esp_err_t bsp_worker_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void bsp_worker_post(uint32_t work)
+{
+}
+
+TaskHandle_t bsp_worker_get_task_handle(void)
+{
+    return NULL;
+}
+
+#endif /* CONFIG_BSP_WORKER */
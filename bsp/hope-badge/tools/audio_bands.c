@@ -0,0 +1,75 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Run the badge audio analysis (bsp/bsp_audio_dsp.h) on a recorded sample
+   file and print the band levels of every frame, one line per frame.
+
+   Input is raw signed 16-bit little-endian mono PCM at the badge sample rate
+   (CONFIG_BSP_AUDIO_SAMPLE_RATE_HZ), for example from:
+
+     sox input.wav -r 20000 -c 1 -b 16 -e signed -t raw input.raw
+
+   Build and run on the host:
+
+     cc -O2 -I../include -o audio_bands audio_bands.c ../src/bsp_audio_dsp.c
+     ./audio_bands input.raw
+*/
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bsp/bsp_audio_dsp.h"
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <s16le mono file>\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint8_t raw[BSP_AUDIO_FFT_SIZE * 2];
+    int16_t samples[BSP_AUDIO_FFT_SIZE];
+    uint32_t bands[BSP_AUDIO_BANDS];
+    uint8_t levels[BSP_AUDIO_BANDS];
+    bsp_audio_agc_t agc = { 0 };
+    unsigned frame = 0;
+
+    while (fread(raw, sizeof(raw), 1, f) == 1) {
+        // Same DC removal as the badge, which sees an offset ADC reading
+        int32_t sum = 0;
+        for (int i = 0; i < BSP_AUDIO_FFT_SIZE; i++) {
+            samples[i] = (int16_t)(raw[2 * i] | (raw[2 * i + 1] << 8));
+            sum += samples[i];
+        }
+        const int32_t mean = sum / BSP_AUDIO_FFT_SIZE;
+        for (int i = 0; i < BSP_AUDIO_FFT_SIZE; i++) {
+            // Halve like the badge, whose 12-bit samples reach half of Q15 full scale
+            samples[i] = (int16_t)((samples[i] - mean) / 2);
+        }
+
+        bsp_audio_analyze(samples, bands);
+        bsp_audio_agc_update(&agc, bands, levels);
+
+        printf("%5u", frame++);
+        for (int b = 0; b < BSP_AUDIO_BANDS; b++) {
+            printf(" %3u", levels[b]);
+        }
+        printf("   ");
+        for (int b = 0; b < BSP_AUDIO_BANDS; b++) {
+            printf(" %6u", (unsigned)bands[b]);
+        }
+        printf("\n");
+    }
+
+    fclose(f);
+    return 0;
+}
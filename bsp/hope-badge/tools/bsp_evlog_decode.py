@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+# HOPE Badge BSP
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Decode a dump of the BSP event log partition (see bsp/bsp_evlog.h) into one
+# line per record, oldest first. Read the partition from a badge with:
+#
+#   parttool.py read_partition --partition-name bsp_log --output bsp_log.bin
+#   python bsp_evlog_decode.py bsp_log.bin
+#   python bsp_evlog_decode.py bsp_log.bin --csv > events.csv
+
+import argparse
+import struct
+import sys
+
+LOG_MAGIC = 0x4C505342
+LOG_VERSION = 1
+SECTOR_SIZE = 4096
+HEADER = struct.Struct('<IIBBH3sB')
+RECORD = struct.Struct('<IHBBII')
+
+RESET = 1
+BROWNOUT = 2
+I2C_ERROR = 3
+BATTERY = 4
+LOAD = 5
+USER = 0x80
+
+LOAD_LEVELS = ['normal', 'reduced', 'critical']
+
+RESET_REASONS = [
+    'unknown', 'poweron', 'ext', 'sw', 'panic', 'int_wdt', 'task_wdt', 'wdt', 'deepsleep', 'brownout', 'sdio',
+    'usb', 'jtag', 'efuse', 'pwr_glitch', 'cpu_lockup',
+]
+
+
+def crc8(data):
+    """CRC-8, polynomial 0x07, init 0 (bsp_evlog_crc8())."""
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def iter_sectors(data, sector_size):
+    """Yield (seq, sector bytes) for every sector with a valid header."""
+    for off in range(0, len(data) - sector_size + 1, sector_size):
+        sector = data[off:off + sector_size]
+        magic, seq, version, record_size, _boot, _, crc = HEADER.unpack_from(sector, 0)
+        if magic != LOG_MAGIC or version != LOG_VERSION or record_size != RECORD.size:
+            continue
+        if crc != crc8(sector[:HEADER.size - 1]):
+            print('warning: bad header CRC in sector %d' % (off // sector_size), file=sys.stderr)
+            continue
+        yield seq, sector
+
+
+def iter_records(data, sector_size):
+    """Yield (seq, boot, time_ms, type, arg0, arg1), oldest first; torn records are reported and skipped."""
+    sectors = sorted(iter_sectors(data, sector_size), key=lambda s: s[0])
+    for seq, sector in sectors:
+        for off in range(HEADER.size, sector_size - RECORD.size + 1, RECORD.size):
+            raw = sector[off:off + RECORD.size]
+            if raw == b'\xff' * RECORD.size:
+                break
+            time_ms, boot, rtype, crc, arg0, arg1 = RECORD.unpack(raw)
+            if crc != crc8(raw[:7] + b'\x00' + raw[8:]):
+                print('warning: skipping torn record in sector seq %d at 0x%x' % (seq, off), file=sys.stderr)
+                continue
+            yield seq, boot, time_ms, rtype, arg0, arg1
+
+
+def describe(rtype, arg0, arg1):
+    if rtype == RESET:
+        reason = RESET_REASONS[arg0] if arg0 < len(RESET_REASONS) else str(arg0)
+        return 'reset', 'reason=%s' % reason
+    if rtype == BROWNOUT:
+        return 'brownout', 'last_battery=%dmV' % arg0 if arg0 else 'last_battery=unknown'
+    if rtype == I2C_ERROR:
+        return 'i2c_error', 'addr=0x%02x err=0x%x' % (arg0, arg1)
+    if rtype == BATTERY:
+        return 'battery', '%dmV' % arg0
+    if rtype == LOAD:
+        level = LOAD_LEVELS[arg0] if arg0 < len(LOAD_LEVELS) else str(arg0)
+        return 'load', 'level=%s budget=%dmA' % (level, arg1)
+    if rtype >= USER:
+        return 'user_%d' % (rtype - USER), 'arg0=0x%08x arg1=0x%08x' % (arg0, arg1)
+    return 'unknown_%d' % rtype, 'arg0=0x%08x arg1=0x%08x' % (arg0, arg1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a HOPE badge BSP event log partition dump')
+    parser.add_argument('input', help='raw partition dump')
+    parser.add_argument('--sector-size', type=int, default=SECTOR_SIZE, help='flash sector size (default 4096)')
+    parser.add_argument('--csv', action='store_true', help='print CSV instead of text')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        data = f.read()
+
+    if args.csv:
+        print('boot,time_ms,type,arg0,arg1')
+    for _, boot, time_ms, rtype, arg0, arg1 in iter_records(data, args.sector_size):
+        if args.csv:
+            print('%d,%d,%d,%d,%d' % (boot, time_ms, rtype, arg0, arg1))
+        else:
+            name, text = describe(rtype, arg0, arg1)
+            print('boot %5d %12.3f s  %-12s %s' % (boot, time_ms / 1000.0, name, text))
+
+
+if __name__ == '__main__':
+    main()
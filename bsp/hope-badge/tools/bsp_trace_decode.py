@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+# HOPE Badge BSP
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Decode BSP trace packets (see bsp/bsp_trace.h) into a Chrome trace JSON file
+# that can be opened in https://ui.perfetto.dev or chrome://tracing.
+#
+# Input is either a console log containing "BSPT:<hex>" lines (bsp_trace_dump())
+# or a raw binary capture of the app_trace stream (bsp_trace_flush_apptrace()).
+#
+#   python bsp_trace_decode.py monitor.log -o trace.json
+#   python bsp_trace_decode.py apptrace.bin --text
+
+import argparse
+import json
+import struct
+import sys
+
+PACKET_MAGIC = 0x5442
+PACKET_VERSION = 1
+HEADER = struct.Struct('<HBBI')
+RECORD = struct.Struct('<IBBH')
+
+I2C_START = 1
+I2C_DONE = 2
+LED_REFRESH_START = 3
+LED_REFRESH_DONE = 4
+HAPTIC_ON = 5
+HAPTIC_OFF = 6
+BUTTON_DOWN = 7
+BUTTON_UP = 8
+EXPANDER_INT = 9
+USER = 0x80
+
+EVENT_NAMES = {
+    I2C_START: 'i2c_start',
+    I2C_DONE: 'i2c_done',
+    LED_REFRESH_START: 'led_refresh_start',
+    LED_REFRESH_DONE: 'led_refresh_done',
+    HAPTIC_ON: 'haptic_on',
+    HAPTIC_OFF: 'haptic_off',
+    BUTTON_DOWN: 'button_down',
+    BUTTON_UP: 'button_up',
+    EXPANDER_INT: 'expander_int',
+}
+
+# Begin/end pairs: begin event -> (end event, timeline row, span name)
+SPANS = {
+    I2C_START: (I2C_DONE, 'i2c', lambda a0: 'scan' if a0 == 0 else '0x%02x' % a0),
+    LED_REFRESH_START: (LED_REFRESH_DONE, 'led_rgb', lambda a0: 'refresh'),
+    HAPTIC_ON: (HAPTIC_OFF, 'vibramotor', lambda a0: 'on'),
+    BUTTON_DOWN: (BUTTON_UP, 'buttons', lambda a0: 'button %d' % (a0 + 1)),
+}
+SPAN_ENDS = {end: begin for begin, (end, _, _) in SPANS.items()}
+
+
+def iter_packets_text(data):
+    for line in data.decode('utf-8', errors='replace').splitlines():
+        pos = line.find('BSPT:')
+        if pos < 0:
+            continue
+        fields = line[pos + 5:].split()
+        hexdata = fields[0] if fields else ''
+        try:
+            yield bytes.fromhex(hexdata)
+        except ValueError:
+            print('warning: skipping malformed line: %s' % line.strip(), file=sys.stderr)
+
+
+def iter_packets_binary(data):
+    off = 0
+    while off + HEADER.size <= len(data):
+        magic, version, count, _ = HEADER.unpack_from(data, off)
+        if magic != PACKET_MAGIC or version != PACKET_VERSION:
+            off += 1    # Resynchronize
+            continue
+        end = off + HEADER.size + count * RECORD.size
+        if end > len(data):
+            break
+        yield data[off:end]
+        off = end
+
+
+def iter_records(packets):
+    """Yield (timestamp_us, event, arg0, arg1, lost) with the 32-bit timestamp unwrapped."""
+    last = None
+    base = 0
+    for packet in packets:
+        if len(packet) < HEADER.size:
+            continue
+        magic, version, count, lost = HEADER.unpack_from(packet, 0)
+        if magic != PACKET_MAGIC or version != PACKET_VERSION:
+            print('warning: skipping packet with bad header', file=sys.stderr)
+            continue
+        if lost:
+            yield (None, None, None, None, lost)
+        for i in range(count):
+            off = HEADER.size + i * RECORD.size
+            if off + RECORD.size > len(packet):
+                break
+            ts, event, arg0, arg1 = RECORD.unpack_from(packet, off)
+            if last is not None and ts < last and last - ts > 0x80000000:
+                base += 1 << 32
+            last = ts
+            yield (base + ts, event, arg0, arg1, 0)
+
+
+def event_name(event):
+    if event >= USER:
+        return 'user_%d' % (event - USER)
+    return EVENT_NAMES.get(event, 'unknown_%d' % event)
+
+
+def to_chrome(records):
+    out = []
+    open_spans = {}
+    t0 = None
+    rel = 0
+    for ts, event, arg0, arg1, lost in records:
+        if lost:
+            # Spans cut by the gap cannot be closed reliably
+            out.append({'name': 'lost %d events' % lost, 'ph': 'i', 's': 'g', 'pid': 0, 'tid': 'trace', 'ts': rel})
+            open_spans.clear()
+            continue
+        if t0 is None:
+            t0 = ts
+        rel = ts - t0
+        if event in SPANS:
+            open_spans[(event, arg0)] = rel
+        elif event in SPAN_ENDS:
+            begin = SPAN_ENDS[event]
+            start = open_spans.pop((begin, arg0), None)
+            _, row, name = SPANS[begin]
+            if start is None:
+                continue
+            span = {'name': name(arg0), 'ph': 'X', 'pid': 0, 'tid': row, 'ts': start, 'dur': rel - start}
+            if event == I2C_DONE and arg0 == 0:
+                span['args'] = {'devices': arg1}
+            elif event in (I2C_DONE, LED_REFRESH_DONE) and arg1 != 0:
+                span['args'] = {'err': '0x%x' % arg1}
+            out.append(span)
+        else:
+            row = 'pcf8574' if event == EXPANDER_INT else 'user'
+            out.append({'name': event_name(event), 'ph': 'i', 's': 't', 'pid': 0, 'tid': row, 'ts': rel,
+                        'args': {'arg0': arg0, 'arg1': arg1}})
+    return {'traceEvents': out, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode HOPE badge BSP trace packets')
+    parser.add_argument('input', help='console log with BSPT: lines, or raw app_trace capture')
+    parser.add_argument('-o', '--output', help='Chrome trace JSON output file (default: stdout)')
+    parser.add_argument('--text', action='store_true', help='print one event per line instead of JSON')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        data = f.read()
+    packets = list(iter_packets_text(data)) if b'BSPT:' in data else list(iter_packets_binary(data))
+    records = list(iter_records(packets))
+
+    if args.text:
+        for ts, event, arg0, arg1, lost in records:
+            if lost:
+                print('--- %d events lost ---' % lost)
+            else:
+                print('%12d us  %-18s arg0=0x%02x arg1=%d' % (ts, event_name(event), arg0, arg1))
+        return
+
+    result = json.dumps(to_chrome(records), indent=1)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(result)
+    else:
+        print(result)
+
+
+if __name__ == '__main__':
+    main()
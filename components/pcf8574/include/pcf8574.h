@@ -2,12 +2,18 @@
  * @file
  * @brief PCF8574 I2C GPIO Expander Driver
  *
- * Driver for the NXP PCF8574/PCF8574A 8-bit I2C I/O expander.
- * Supports full byte and individual pin read/write, pin direction
+ * Driver for the NXP PCF8574/PCF8574A 8-bit and PCF8575 16-bit I2C I/O
+ * expanders. Supports full port and individual pin read/write, pin direction
  * configuration, and interrupt-driven pin change notification.
  *
- * The PCF8574 has quasi-bidirectional I/O: pins written HIGH have a
+ * These devices have quasi-bidirectional I/O: pins written HIGH have a
  * weak internal pull-up (~100 µA) and can be used as inputs.
+ *
+ * All device types share one driver; they differ only in port width. A
+ * PCF8575 transfers both of its ports (P00-P07 first, then P10-P17) in a
+ * single two-byte transaction. The 8-bit functions act on P00-P07 and leave
+ * P10-P17 unchanged; the *_port() functions cover the full width, with
+ * P10-P17 as bits 8-15.
  */
 
 #pragma once
@@ -26,12 +32,58 @@ extern "C" {
 #define PCF8574_I2C_ADDR_DEFAULT    0x20    /*!< Default I2C address for PCF8574 (A2=A1=A0=0) */
 #define PCF8574A_I2C_ADDR_DEFAULT   0x38    /*!< Default I2C address for PCF8574A (A2=A1=A0=0) */
 #define PCF8574_PIN_COUNT           8       /*!< Number of I/O pins on the PCF8574 */
+#define PCF8575_PIN_COUNT           16      /*!< Number of I/O pins on the PCF8575 */
+
+/**
+ * @brief Supported expander types
+ */
+typedef enum {
+    PCF8574_TYPE_PCF8574 = 0,   /*!< PCF8574, 8 pins, addresses 0x20-0x27 */
+    PCF8574_TYPE_PCF8574A,      /*!< PCF8574A, 8 pins, addresses 0x38-0x3F */
+    PCF8574_TYPE_PCF8575,       /*!< PCF8575, 16 pins, addresses 0x20-0x27 */
+} pcf8574_type_t;
 
 /**
  * @brief PCF8574 device handle type (opaque pointer)
  */
 typedef void *pcf8574_handle_t;
 
+/**
+ * @brief Storage for a statically allocated PCF8574 device.
+ *
+ * Opaque; large enough to hold the driver's internal device structure.
+ * See pcf8574_create_static().
+ */
+typedef struct {
+    uintptr_t reserved[12];
+} pcf8574_static_t;
+
+/**
+ * @brief Transfer counters of a PCF8574 device
+ */
+typedef struct {
+    uint32_t reads;         /*!< Port reads */
+    uint32_t writes;        /*!< Port writes */
+    uint32_t errors;        /*!< Failed reads and writes */
+    uint32_t interrupts;    /*!< INT pin interrupts */
+} pcf8574_stats_t;
+
+/**
+ * @brief Events reported to the trace hook
+ */
+typedef enum {
+    PCF8574_TRACE_XFER_START,   /*!< I2C read or write is about to start */
+    PCF8574_TRACE_XFER_DONE,    /*!< I2C read or write finished, err holds the result */
+    PCF8574_TRACE_INTERRUPT,    /*!< INT pin fired (called from ISR context) */
+} pcf8574_trace_event_t;
+
+/**
+ * @brief Trace hook type, see pcf8574_set_trace_hook().
+ *
+ * Must be placed in IRAM and be ISR-safe.
+ */
+typedef void (*pcf8574_trace_hook_t)(pcf8574_trace_event_t event, uint8_t dev_addr, esp_err_t err);
+
 /**
  * @brief Callback type for PCF8574 interrupt events.
  *
@@ -58,6 +110,45 @@ typedef void (*pcf8574_int_cb_t)(void *arg);
  */
 pcf8574_handle_t pcf8574_create(i2c_bus_handle_t bus, uint8_t dev_addr);
 
+/**
+ * @brief Create a PCF8574 device in caller-provided storage.
+ *
+ * Same as pcf8574_create() but the device structure is placed in @p buffer
+ * instead of the heap. The buffer must stay valid until pcf8574_delete().
+ *
+ * @note The I2C device handle is still created by the i2c_bus component.
+ *
+ * @param bus I2C bus handle
+ * @param dev_addr 7-bit I2C device address
+ * @param buffer Storage for the device
+ * @return pcf8574_handle_t Device handle on success, NULL on failure
+ */
+pcf8574_handle_t pcf8574_create_static(i2c_bus_handle_t bus, uint8_t dev_addr, pcf8574_static_t *buffer);
+
+/**
+ * @brief Create a device of the given type.
+ *
+ * pcf8574_create() is the same as this with PCF8574_TYPE_PCF8574.
+ *
+ * @param bus I2C bus handle
+ * @param dev_addr 7-bit I2C device address
+ * @param type Expander type
+ * @return pcf8574_handle_t Device handle on success, NULL on failure
+ */
+pcf8574_handle_t pcf8574_create_type(i2c_bus_handle_t bus, uint8_t dev_addr, pcf8574_type_t type);
+
+/**
+ * @brief Create a device of the given type in caller-provided storage.
+ *
+ * @param bus I2C bus handle
+ * @param dev_addr 7-bit I2C device address
+ * @param type Expander type
+ * @param buffer Storage for the device
+ * @return pcf8574_handle_t Device handle on success, NULL on failure
+ */
+pcf8574_handle_t pcf8574_create_type_static(i2c_bus_handle_t bus, uint8_t dev_addr, pcf8574_type_t type,
+                                            pcf8574_static_t *buffer);
+
 /**
  * @brief Delete a PCF8574 device and free associated resources.
  *
@@ -100,12 +191,147 @@ esp_err_t pcf8574_read(pcf8574_handle_t dev, uint8_t *data);
  */
 esp_err_t pcf8574_write(pcf8574_handle_t dev, uint8_t data);
 
+/**
+ * @brief Get the cached output latch value.
+ *
+ * Returns the last value written with pcf8574_write() or the pin helpers,
+ * without any I2C transaction.
+ *
+ * @param dev Device handle
+ * @param[out] data Pointer to store the cached output byte
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev or data is NULL
+ */
+esp_err_t pcf8574_get_output(pcf8574_handle_t dev, uint8_t *data);
+
+/**
+ * @brief Get the number of I/O pins of the device.
+ *
+ * @param dev Device handle
+ * @return 8 or 16, 0 if dev is NULL
+ */
+uint8_t pcf8574_get_pin_count(pcf8574_handle_t dev);
+
+/*******************************************************************************
+ * Full-port I/O
+ ******************************************************************************/
+
+/**
+ * @brief Read all pins of the device in one transaction.
+ *
+ * On 8-bit devices bits 8-15 read as 0.
+ *
+ * @param dev Device handle
+ * @param[out] data Pointer to store the port value
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev or data is NULL
+ *      - ESP_FAIL on I2C read error
+ */
+esp_err_t pcf8574_read_port(pcf8574_handle_t dev, uint16_t *data);
+
+/**
+ * @brief Write all pins of the device in one transaction.
+ *
+ * Bits beyond the device width are ignored.
+ *
+ * @param dev Device handle
+ * @param data Port value
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev is NULL
+ *      - ESP_FAIL on I2C write error
+ */
+esp_err_t pcf8574_write_port(pcf8574_handle_t dev, uint16_t data);
+
+/**
+ * @brief Get the cached output latch value of all pins.
+ *
+ * @param dev Device handle
+ * @param[out] data Pointer to store the cached port value
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev or data is NULL
+ */
+esp_err_t pcf8574_get_output_port(pcf8574_handle_t dev, uint16_t *data);
+
+/**
+ * @brief Set the I/O direction of all pins, see pcf8574_set_direction().
+ *
+ * @param dev Device handle
+ * @param input_mask Bitmask where 1 = input, 0 = output
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev is NULL
+ *      - ESP_FAIL on I2C write error
+ */
+esp_err_t pcf8574_set_direction_port(pcf8574_handle_t dev, uint16_t input_mask);
+
+/**
+ * @brief Get the direction mask of all pins.
+ *
+ * @param dev Device handle
+ * @param[out] input_mask Pointer to store the direction mask (1 = input)
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev or input_mask is NULL
+ */
+esp_err_t pcf8574_get_direction_port(pcf8574_handle_t dev, uint16_t *input_mask);
+
+/**
+ * @brief Get the 7-bit I2C address of the device.
+ *
+ * @param dev Device handle
+ * @param[out] dev_addr Pointer to store the address
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev or dev_addr is NULL
+ */
+esp_err_t pcf8574_get_address(pcf8574_handle_t dev, uint8_t *dev_addr);
+
+/**
+ * @brief Seed the driver state from a known device state.
+ *
+ * Sets the output cache and direction mask without writing to the device.
+ * Use this when the PCF8574 kept its latch while the host was asleep, so the
+ * handle can be re-attached with no bus traffic.
+ *
+ * @param dev Device handle
+ * @param output Output latch value currently held by the device
+ * @param input_mask Direction mask currently applied (1 = input)
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev is NULL
+ */
+esp_err_t pcf8574_restore_state(pcf8574_handle_t dev, uint8_t output, uint8_t input_mask);
+
+/**
+ * @brief Get the transfer counters of the device.
+ *
+ * @param dev Device handle
+ * @param[out] stats Pointer to store the counters
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if dev or stats is NULL
+ */
+esp_err_t pcf8574_get_stats(pcf8574_handle_t dev, pcf8574_stats_t *stats);
+
+/**
+ * @brief Set a hook called around every I2C transfer and on every interrupt.
+ *
+ * Applies to all devices. Used by profiling tools; pass NULL to remove.
+ *
+ * @param hook Trace hook or NULL
+ */
+void pcf8574_set_trace_hook(pcf8574_trace_hook_t hook);
+
 /*******************************************************************************
  * Pin direction
  ******************************************************************************/
 
 /**
- * @brief Set the I/O direction for all 8 pins.
+ * @brief Set the I/O direction of P00-P07.
  *
  * Bits set to 1 in @p input_mask are configured as inputs (written HIGH
  * to enable the weak pull-up). Bits set to 0 are configured as outputs.
@@ -141,10 +367,10 @@ esp_err_t pcf8574_get_direction(pcf8574_handle_t dev, uint8_t *input_mask);
  * Uses the cached output state to avoid an I2C read.
  *
  * @param dev Device handle
- * @param pin Pin number (0–7)
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices)
  * @return
  *      - ESP_OK on success
- *      - ESP_ERR_INVALID_ARG if dev is NULL or pin > 7
+ *      - ESP_ERR_INVALID_ARG if dev is NULL or pin is out of range
  *      - ESP_FAIL on I2C write error
  */
 esp_err_t pcf8574_set_pin(pcf8574_handle_t dev, uint8_t pin);
@@ -155,10 +381,10 @@ esp_err_t pcf8574_set_pin(pcf8574_handle_t dev, uint8_t pin);
  * Uses the cached output state to avoid an I2C read.
  *
  * @param dev Device handle
- * @param pin Pin number (0–7)
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices)
  * @return
  *      - ESP_OK on success
- *      - ESP_ERR_INVALID_ARG if dev is NULL or pin > 7
+ *      - ESP_ERR_INVALID_ARG if dev is NULL or pin is out of range
  *      - ESP_FAIL on I2C write error
  */
 esp_err_t pcf8574_clear_pin(pcf8574_handle_t dev, uint8_t pin);
@@ -169,10 +395,10 @@ esp_err_t pcf8574_clear_pin(pcf8574_handle_t dev, uint8_t pin);
  * Uses the cached output state to avoid an I2C read.
  *
  * @param dev Device handle
- * @param pin Pin number (0–7)
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices)
  * @return
  *      - ESP_OK on success
- *      - ESP_ERR_INVALID_ARG if dev is NULL or pin > 7
+ *      - ESP_ERR_INVALID_ARG if dev is NULL or pin is out of range
  *      - ESP_FAIL on I2C write error
  */
 esp_err_t pcf8574_toggle_pin(pcf8574_handle_t dev, uint8_t pin);
@@ -183,11 +409,11 @@ esp_err_t pcf8574_toggle_pin(pcf8574_handle_t dev, uint8_t pin);
  * Performs an I2C read to get the actual pin state.
  *
  * @param dev Device handle
- * @param pin Pin number (0–7)
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices)
  * @param[out] level Pointer to store the pin level (0 or 1)
  * @return
  *      - ESP_OK on success
- *      - ESP_ERR_INVALID_ARG if dev or level is NULL, or pin > 7
+ *      - ESP_ERR_INVALID_ARG if dev or level is NULL, or pin is out of range
  *      - ESP_FAIL on I2C read error
  */
 esp_err_t pcf8574_read_pin(pcf8574_handle_t dev, uint8_t pin, uint8_t *level);
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @brief Several PCF8574 devices sharing one INT line
+ *
+ * The INT outputs of PCF8574s are open-drain and can be wired-OR onto a single
+ * host GPIO. A group owns that GPIO: a LOW-level interrupt wakes the group task,
+ * which reads every device once (one transfer each, two bytes for a PCF8575) and
+ * reports the input pins that changed. The interrupt is re-armed only after the
+ * line is released, so a device that changes while the others are read is
+ * picked up by another pass instead of being lost. With `wakeup` set, the same
+ * level is armed as light-sleep wake-up source; it is disarmed while the line is
+ * held LOW, so a stuck line does not keep the chip awake. A line that stays LOW (a device that is
+ * not in the group, or one that stopped answering) is polled with a growing
+ * interval until it is released.
+ *
+ * With CONFIG_PM_ENABLE the group holds a PM lock during a read pass, so the
+ * chip does not enter light sleep in the middle of the transfers.
+ *
+ * Devices in a group must not also use pcf8574_register_interrupt().
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "pcf8574.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCF8574_GROUP_MAX_DEVICES       8       /*!< Devices per group */
+#define PCF8574_GROUP_TASK_STACK_SIZE   3072
+
+/**
+ * @brief Group handle type (opaque pointer)
+ */
+typedef struct pcf8574_group_t *pcf8574_group_handle_t;
+
+/**
+ * @brief Change callback, called from the group task.
+ *
+ * @param dev Device whose inputs changed
+ * @param value Port value read from the device, P10-P17 in bits 8-15 on 16-bit devices
+ * @param changed Input pins that changed since the previous read
+ * @param arg User argument
+ */
+typedef void (*pcf8574_group_cb_t)(pcf8574_handle_t dev, uint16_t value, uint16_t changed, void *arg);
+
+/**
+ * @brief Group configuration
+ */
+typedef struct {
+    gpio_num_t int_gpio;            /*!< Host GPIO wired to all INT outputs */
+    bool wakeup;                    /*!< Also wake the chip from light sleep, needs esp_sleep_enable_gpio_wakeup() */
+    uint8_t task_priority;          /*!< Group task priority */
+    pcf8574_group_cb_t callback;    /*!< Change callback */
+    void *user_arg;                 /*!< Argument passed to the callback */
+} pcf8574_group_config_t;
+
+/**
+ * @brief Create a group and install the INT interrupt.
+ *
+ * @param config Group configuration
+ * @param[out] ret_handle Group handle
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is NULL or the GPIO is invalid
+ *      - ESP_ERR_NO_MEM if allocation fails
+ */
+esp_err_t pcf8574_group_create(const pcf8574_group_config_t *config, pcf8574_group_handle_t *ret_handle);
+
+/**
+ * @brief Remove the interrupt and delete the group. The devices are not deleted.
+ *
+ * May be called from the change callback; the group is then freed by its task
+ * once the callback returns.
+ *
+ * @param[in,out] handle Pointer to the group handle. Will be set to NULL on success.
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t pcf8574_group_delete(pcf8574_group_handle_t *handle);
+
+/**
+ * @brief Add a device to the group.
+ *
+ * Reads the device once to record its current state and release its INT.
+ *
+ * @param handle Group handle
+ * @param dev Device handle
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is NULL
+ *      - ESP_ERR_NO_MEM if the group is full
+ *      - ESP_FAIL on I2C read error
+ */
+esp_err_t pcf8574_group_add(pcf8574_group_handle_t handle, pcf8574_handle_t dev);
+
+/**
+ * @brief Remove a device from the group.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the device is not in the group
+ */
+esp_err_t pcf8574_group_remove(pcf8574_group_handle_t handle, pcf8574_handle_t dev);
+
+/**
+ * @brief Get the port value of a device from the last group read, without bus traffic.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is NULL
+ *      - ESP_ERR_NOT_FOUND if the device is not in the group
+ */
+esp_err_t pcf8574_group_get_input(pcf8574_group_handle_t handle, pcf8574_handle_t dev, uint16_t *value);
+
+/**
+ * @brief Read all devices now, as if INT had fired.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if handle is NULL
+ */
+esp_err_t pcf8574_group_trigger(pcf8574_group_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
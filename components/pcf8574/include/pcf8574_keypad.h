@@ -0,0 +1,125 @@
+/**
+ * @file
+ * @brief PCF8574 keypad matrix scanner
+ *
+ * Scans a key matrix (up to 4x4) wired to one PCF8574. Rows are driven LOW,
+ * columns read through the quasi-bidirectional pull-ups, so a pressed key
+ * pulls its column LOW.
+ *
+ * Between scans all rows are held LOW: any key press changes a column and the
+ * INT line wakes the scan task, so the bus is idle while nobody is typing.
+ * While keys are held the matrix is rescanned every hold_poll_ms, because a
+ * second key on an already LOW column does not raise INT.
+ *
+ * A scan first reads the columns, then swaps roles (columns LOW, rows read)
+ * to find the active rows, and only drives the active rows one by one when
+ * more than one row is pressed. A single key costs five transfers instead of
+ * two per row.
+ *
+ * Without diodes, three keys on the corners of a rectangle make the fourth
+ * corner read as pressed. Such scans are reported as PCF8574_KEYPAD_GHOST and
+ * the previous key state is kept.
+ *
+ * The keypad takes over the row and column pins; other pins keep their cached
+ * levels.
+ *
+ * Rows and columns must be on P00-P07; on a PCF8575 the keypad only uses the
+ * low port and P10-P17 stay free for other uses.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "pcf8574.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCF8574_KEYPAD_TASK_STACK_SIZE  3072
+
+/**
+ * @brief Keypad handle type (opaque pointer)
+ */
+typedef struct pcf8574_keypad_t *pcf8574_keypad_handle_t;
+
+/**
+ * @brief Keypad events
+ */
+typedef enum {
+    PCF8574_KEYPAD_PRESS,       /*!< Key pressed (debounced) */
+    PCF8574_KEYPAD_RELEASE,     /*!< Key released (debounced) */
+    PCF8574_KEYPAD_GHOST,       /*!< Ambiguous scan ignored, key is 0xFF */
+} pcf8574_keypad_event_t;
+
+/**
+ * @brief Keypad event callback, called from the keypad task.
+ *
+ * @param event Event type
+ * @param key Key index: row * number of columns + column, rows and columns
+ *            numbered from the lowest pin of their mask
+ * @param arg User argument
+ */
+typedef void (*pcf8574_keypad_cb_t)(pcf8574_keypad_event_t event, uint8_t key, void *arg);
+
+/**
+ * @brief Keypad configuration
+ */
+typedef struct {
+    uint8_t row_mask;           /*!< Pins connected to the rows */
+    uint8_t col_mask;           /*!< Pins connected to the columns */
+    gpio_num_t int_gpio;        /*!< Host GPIO wired to INT, GPIO_NUM_NC to poll every hold_poll_ms */
+    uint16_t debounce_ms;       /*!< Quiet time after INT before scanning */
+    uint16_t hold_poll_ms;      /*!< Rescan period while keys are held */
+    uint8_t task_priority;      /*!< Scan task priority */
+    pcf8574_keypad_cb_t callback;   /*!< Event callback */
+    void *user_arg;             /*!< Argument passed to the callback */
+} pcf8574_keypad_config_t;
+
+/**
+ * @brief Start scanning a keypad.
+ *
+ * Registers the INT interrupt of @p dev, so no other interrupt may be
+ * registered on the device.
+ *
+ * @param dev Device handle
+ * @param config Keypad configuration
+ * @param[out] ret_handle Keypad handle
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is NULL, the masks overlap or are empty
+ *      - ESP_ERR_NO_MEM if allocation fails
+ *      - ESP_FAIL on I2C error
+ */
+esp_err_t pcf8574_keypad_create(pcf8574_handle_t dev, const pcf8574_keypad_config_t *config,
+                                pcf8574_keypad_handle_t *ret_handle);
+
+/**
+ * @brief Stop scanning and delete the keypad.
+ *
+ * May be called from the key callback; the keypad is then freed by its task
+ * once the callback returns.
+ *
+ * @param[in,out] handle Pointer to the keypad handle. Will be set to NULL on success.
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t pcf8574_keypad_delete(pcf8574_keypad_handle_t *handle);
+
+/**
+ * @brief Get the debounced key state.
+ *
+ * @param handle Keypad handle
+ * @param[out] keys Bit n set if key n is pressed
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is NULL
+ */
+esp_err_t pcf8574_keypad_get_state(pcf8574_keypad_handle_t handle, uint16_t *keys);
+
+#ifdef __cplusplus
+}
+#endif
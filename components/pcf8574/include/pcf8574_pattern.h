@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @brief PCF8574 output pattern engine
+ *
+ * Drives expander outputs with low-frequency PWM, blink or bit-sequence
+ * patterns from a periodic esp_timer. Every tick the combined port value is
+ * computed from all pattern pins and written in one I2C transaction, only
+ * when it differs from the last value written. The bus load is therefore at
+ * most one port write per tick, whatever the number of pins; on a PCF8575 that
+ * covers all 16 pins.
+ *
+ * PWM pins share one phase: they all switch on at the start of the PWM
+ * period and off at their own duty, so a period costs at most one write per
+ * distinct duty value plus one.
+ *
+ * Pins not driven by the engine keep their cached level. Other writers to the
+ * same device (pcf8574_write(), pin helpers) must not run concurrently with
+ * the engine, the same rule as for any other shared pcf8574 handle.
+ *
+ * The ticks run on the esp_timer task and never block it: they only compute
+ * the port value and wake the engine task, which performs the single write.
+ * A write that takes longer than a tick is merged with the ticks meanwhile.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "pcf8574.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCF8574_PATTERN_PWM_STEPS   16      /*!< PWM period in ticks (duty resolution) */
+#define PCF8574_PATTERN_TASK_STACK_SIZE 2048
+
+/**
+ * @brief Pattern engine handle type (opaque pointer)
+ */
+typedef struct pcf8574_pattern_t *pcf8574_pattern_handle_t;
+
+/**
+ * @brief Pattern engine configuration
+ */
+typedef struct {
+    uint32_t tick_ms;           /*!< Tick period in milliseconds (upper bound on the write rate) */
+    uint16_t active_low_mask;   /*!< Pins whose load is on when LOW, e.g. LEDs sunk by the expander */
+    uint8_t task_priority;      /*!< Priority of the task performing the port writes */
+} pcf8574_pattern_config_t;
+
+/**
+ * @brief Create a pattern engine for a device.
+ *
+ * Creates the engine task. The timer only runs while at least one pin has
+ * a pattern, and the task only wakes when the port value changes.
+ *
+ * @param dev Device handle
+ * @param config Engine configuration
+ * @param[out] ret_handle Engine handle
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is NULL or tick_ms is 0
+ *      - ESP_ERR_NO_MEM if allocation or task creation fails
+ */
+esp_err_t pcf8574_pattern_create(pcf8574_handle_t dev, const pcf8574_pattern_config_t *config,
+                                 pcf8574_pattern_handle_t *ret_handle);
+
+/**
+ * @brief Stop all patterns and delete the engine.
+ *
+ * Pins keep the level of the last write. Waits until no tick is running or
+ * pending and the engine task has exited, so it must not be called from an
+ * esp_timer callback.
+ *
+ * @param[in,out] handle Pointer to the engine handle. Will be set to NULL on success.
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t pcf8574_pattern_delete(pcf8574_pattern_handle_t *handle);
+
+/**
+ * @brief Dim a pin with low-frequency PWM.
+ *
+ * @param handle Engine handle
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices), must be an output
+ * @param duty On time in ticks per PWM period, 0 to PCF8574_PATTERN_PWM_STEPS
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is out of range
+ *      - ESP_ERR_INVALID_STATE if the pin is configured as input
+ */
+esp_err_t pcf8574_pattern_set_pwm(pcf8574_pattern_handle_t handle, uint8_t pin, uint8_t duty);
+
+/**
+ * @brief Blink a pin.
+ *
+ * @param handle Engine handle
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices), must be an output
+ * @param on_ticks Ticks on, at least 1
+ * @param off_ticks Ticks off, at least 1
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is out of range
+ *      - ESP_ERR_INVALID_STATE if the pin is configured as input
+ */
+esp_err_t pcf8574_pattern_set_blink(pcf8574_pattern_handle_t handle, uint8_t pin,
+                                    uint16_t on_ticks, uint16_t off_ticks);
+
+/**
+ * @brief Play a repeating on/off sequence on a pin.
+ *
+ * Bit 0 of @p bits is played first; each bit lasts @p ticks_per_step ticks.
+ *
+ * @param handle Engine handle
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices), must be an output
+ * @param bits Sequence, 1 = on
+ * @param length Number of bits, 1 to 32
+ * @param ticks_per_step Ticks per bit, at least 1
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is out of range
+ *      - ESP_ERR_INVALID_STATE if the pin is configured as input
+ */
+esp_err_t pcf8574_pattern_set_sequence(pcf8574_pattern_handle_t handle, uint8_t pin, uint32_t bits,
+                                       uint8_t length, uint16_t ticks_per_step);
+
+/**
+ * @brief Stop the pattern on a pin and leave it on or off.
+ *
+ * Writes the pin immediately if its level changes.
+ *
+ * @param handle Engine handle
+ * @param pin Pin number (0–7, 0–15 on 16-bit devices)
+ * @param on Final state, honoring active_low_mask
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if a parameter is out of range
+ *      - ESP_FAIL on I2C write error
+ */
+esp_err_t pcf8574_pattern_stop(pcf8574_pattern_handle_t handle, uint8_t pin, bool on);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,6 +7,7 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 #include <stdlib.h>
+#include <string.h>
 
 #include "esp_err.h"
 #include "esp_log.h"
@@ -17,19 +18,44 @@
 
 static const char *TAG = "pcf8574";
 
+/**
+ * @brief Port width of each device type
+ */
+static const uint8_t pcf8574_type_pins[] = {
+    [PCF8574_TYPE_PCF8574] = 8,
+    [PCF8574_TYPE_PCF8574A] = 8,
+    [PCF8574_TYPE_PCF8575] = 16,
+};
+
 /**
  * @brief Internal device structure for PCF8574
  */
 typedef struct {
     i2c_bus_device_handle_t i2c_dev;    /*!< I2C device handle */
     uint8_t dev_addr;                    /*!< 7-bit I2C address */
-    uint8_t output_cache;                /*!< Cached output latch state */
-    uint8_t input_mask;                  /*!< Direction mask: 1 = input, 0 = output */
+    uint8_t pin_count;                   /*!< 8 or 16 */
+    uint16_t output_cache;               /*!< Cached output latch state */
+    uint16_t input_mask;                 /*!< Direction mask: 1 = input, 0 = output */
     gpio_num_t int_gpio;                 /*!< Host GPIO for INT pin, or GPIO_NUM_NC */
     pcf8574_int_cb_t int_cb;             /*!< User interrupt callback */
     void *int_cb_arg;                    /*!< User interrupt callback argument */
+    bool is_static;                      /*!< Storage provided by the caller */
+    pcf8574_stats_t stats;               /*!< Transfer counters */
 } pcf8574_device_t;
 
+_Static_assert(sizeof(pcf8574_static_t) >= sizeof(pcf8574_device_t),
+               "pcf8574_static_t is too small for pcf8574_device_t");
+
+static pcf8574_trace_hook_t trace_hook = NULL;
+
+#define PCF8574_TRACE(event, dev, err) \
+    do { \
+        pcf8574_trace_hook_t hook = trace_hook; \
+        if (hook) { \
+            hook((event), (dev)->dev_addr, (err)); \
+        } \
+    } while (0)
+
 /* -------------------------------------------------------------------------- */
 /*  Internal helpers                                                          */
 /* -------------------------------------------------------------------------- */
@@ -38,43 +64,125 @@ typedef struct {
  * @brief Write the effective output value (cache merged with input mask).
  *
  * Input pins are always driven HIGH (weak pull-up) regardless of cache.
+ * 16-bit devices take both ports in one transaction, P00-P07 first.
  */
 static esp_err_t pcf8574_flush(pcf8574_device_t *device)
 {
-    uint8_t value = device->output_cache | device->input_mask;
-    return i2c_bus_write_byte(device->i2c_dev, NULL_I2C_MEM_ADDR, value);
+    uint16_t value = device->output_cache | device->input_mask;
+    esp_err_t ret;
+    PCF8574_TRACE(PCF8574_TRACE_XFER_START, device, ESP_OK);
+    if (device->pin_count == 16) {
+        const uint8_t buf[2] = {value & 0xFF, value >> 8};
+        ret = i2c_bus_write_bytes(device->i2c_dev, NULL_I2C_MEM_ADDR, sizeof(buf), buf);
+    } else {
+        ret = i2c_bus_write_byte(device->i2c_dev, NULL_I2C_MEM_ADDR, (uint8_t)value);
+    }
+    PCF8574_TRACE(PCF8574_TRACE_XFER_DONE, device, ret);
+    device->stats.writes++;
+    if (ret != ESP_OK) {
+        device->stats.errors++;
+    }
+    return ret;
+}
+
+/**
+ * @brief Read all ports in one transaction.
+ */
+static esp_err_t pcf8574_fetch(pcf8574_device_t *device, uint16_t *data)
+{
+    uint8_t buf[2] = {0xFF, 0xFF};
+    esp_err_t ret;
+    PCF8574_TRACE(PCF8574_TRACE_XFER_START, device, ESP_OK);
+    if (device->pin_count == 16) {
+        ret = i2c_bus_read_bytes(device->i2c_dev, NULL_I2C_MEM_ADDR, sizeof(buf), buf);
+    } else {
+        ret = i2c_bus_read_byte(device->i2c_dev, NULL_I2C_MEM_ADDR, &buf[0]);
+        buf[1] = 0;
+    }
+    PCF8574_TRACE(PCF8574_TRACE_XFER_DONE, device, ret);
+    device->stats.reads++;
+    if (ret != ESP_OK) {
+        device->stats.errors++;
+    }
+    *data = buf[0] | (buf[1] << 8);
+    return ret;
 }
 
-static inline bool pcf8574_pin_valid(uint8_t pin)
+static inline bool pcf8574_pin_valid(const pcf8574_device_t *device, uint8_t pin)
 {
-    return pin < PCF8574_PIN_COUNT;
+    return pin < device->pin_count;
+}
+
+static inline uint16_t pcf8574_port_mask(const pcf8574_device_t *device)
+{
+    return (device->pin_count == 16) ? 0xFFFF : 0x00FF;
 }
 
 /* -------------------------------------------------------------------------- */
 /*  Lifecycle                                                                 */
 /* -------------------------------------------------------------------------- */
 
-pcf8574_handle_t pcf8574_create(i2c_bus_handle_t bus, uint8_t dev_addr)
+static esp_err_t pcf8574_device_init(pcf8574_device_t *dev, i2c_bus_handle_t bus, uint8_t dev_addr,
+                                     pcf8574_type_t type)
 {
-    pcf8574_device_t *dev = (pcf8574_device_t *)calloc(1, sizeof(pcf8574_device_t));
-    if (dev == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for PCF8574 device");
-        return NULL;
+    if (type >= sizeof(pcf8574_type_pins) / sizeof(pcf8574_type_pins[0])) {
+        ESP_LOGE(TAG, "Unknown device type %d", type);
+        return ESP_ERR_INVALID_ARG;
     }
     dev->i2c_dev = i2c_bus_device_create(bus, dev_addr, i2c_bus_get_current_clk_speed(bus));
     if (dev->i2c_dev == NULL) {
         ESP_LOGE(TAG, "Failed to create I2C device for PCF8574 at address 0x%02X", dev_addr);
-        free(dev);
-        return NULL;
+        return ESP_FAIL;
     }
     dev->dev_addr = dev_addr;
-    dev->output_cache = 0xFF;   /* Power-on default: all pins HIGH */
-    dev->input_mask = 0xFF;     /* Assume all pins are inputs initially */
+    dev->pin_count = pcf8574_type_pins[type];
+    dev->output_cache = pcf8574_port_mask(dev);     /* Power-on default: all pins HIGH */
+    dev->input_mask = pcf8574_port_mask(dev);       /* Assume all pins are inputs initially */
     dev->int_gpio = GPIO_NUM_NC;
     dev->int_cb = NULL;
     dev->int_cb_arg = NULL;
 
-    ESP_LOGD(TAG, "PCF8574 created at address 0x%02X", dev_addr);
+    ESP_LOGD(TAG, "%d-bit expander created at address 0x%02X", dev->pin_count, dev_addr);
+    return ESP_OK;
+}
+
+pcf8574_handle_t pcf8574_create(i2c_bus_handle_t bus, uint8_t dev_addr)
+{
+    return pcf8574_create_type(bus, dev_addr, PCF8574_TYPE_PCF8574);
+}
+
+pcf8574_handle_t pcf8574_create_type(i2c_bus_handle_t bus, uint8_t dev_addr, pcf8574_type_t type)
+{
+    pcf8574_device_t *dev = (pcf8574_device_t *)calloc(1, sizeof(pcf8574_device_t));
+    if (dev == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for PCF8574 device");
+        return NULL;
+    }
+    if (pcf8574_device_init(dev, bus, dev_addr, type) != ESP_OK) {
+        free(dev);
+        return NULL;
+    }
+    return (pcf8574_handle_t)(dev);
+}
+
+pcf8574_handle_t pcf8574_create_static(i2c_bus_handle_t bus, uint8_t dev_addr, pcf8574_static_t *buffer)
+{
+    return pcf8574_create_type_static(bus, dev_addr, PCF8574_TYPE_PCF8574, buffer);
+}
+
+pcf8574_handle_t pcf8574_create_type_static(i2c_bus_handle_t bus, uint8_t dev_addr, pcf8574_type_t type,
+                                            pcf8574_static_t *buffer)
+{
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    pcf8574_device_t *dev = (pcf8574_device_t *)buffer;
+    memset(dev, 0, sizeof(pcf8574_device_t));
+    if (pcf8574_device_init(dev, bus, dev_addr, type) != ESP_OK) {
+        return NULL;
+    }
+    dev->is_static = true;
     return (pcf8574_handle_t)(dev);
 }
 
@@ -92,7 +200,9 @@ esp_err_t pcf8574_delete(pcf8574_handle_t *dev)
     }
 
     i2c_bus_device_delete(&device->i2c_dev);
-    free(device);
+    if (!device->is_static) {
+        free(device);
+    }
     *dev = NULL;
     return ESP_OK;
 }
@@ -107,8 +217,10 @@ esp_err_t pcf8574_read(pcf8574_handle_t dev, uint8_t *data)
         return ESP_ERR_INVALID_ARG;
     }
 
-    pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    return i2c_bus_read_byte(device->i2c_dev, NULL_I2C_MEM_ADDR, data);
+    uint16_t port = 0;
+    esp_err_t ret = pcf8574_fetch((pcf8574_device_t *)dev, &port);
+    *data = port & 0xFF;
+    return ret;
 }
 
 esp_err_t pcf8574_write(pcf8574_handle_t dev, uint8_t data)
@@ -118,10 +230,94 @@ esp_err_t pcf8574_write(pcf8574_handle_t dev, uint8_t data)
     }
 
     pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    device->output_cache = data;
+    device->output_cache = (device->output_cache & 0xFF00) | data;
+    return pcf8574_flush(device);
+}
+
+esp_err_t pcf8574_get_output(pcf8574_handle_t dev, uint8_t *data)
+{
+    if (dev == NULL || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    *data = device->output_cache & 0xFF;
+    return ESP_OK;
+}
+
+uint8_t pcf8574_get_pin_count(pcf8574_handle_t dev)
+{
+    return (dev != NULL) ? ((pcf8574_device_t *)dev)->pin_count : 0;
+}
+
+esp_err_t pcf8574_read_port(pcf8574_handle_t dev, uint16_t *data)
+{
+    if (dev == NULL || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return pcf8574_fetch((pcf8574_device_t *)dev, data);
+}
+
+esp_err_t pcf8574_write_port(pcf8574_handle_t dev, uint16_t data)
+{
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    device->output_cache = data & pcf8574_port_mask(device);
     return pcf8574_flush(device);
 }
 
+esp_err_t pcf8574_get_output_port(pcf8574_handle_t dev, uint16_t *data)
+{
+    if (dev == NULL || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *data = ((pcf8574_device_t *)dev)->output_cache;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_get_address(pcf8574_handle_t dev, uint8_t *dev_addr)
+{
+    if (dev == NULL || dev_addr == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    *dev_addr = device->dev_addr;
+    return ESP_OK;
+}
+
+void pcf8574_set_trace_hook(pcf8574_trace_hook_t hook)
+{
+    trace_hook = hook;
+}
+
+esp_err_t pcf8574_get_stats(pcf8574_handle_t dev, pcf8574_stats_t *stats)
+{
+    if (dev == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = ((pcf8574_device_t *)dev)->stats;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_restore_state(pcf8574_handle_t dev, uint8_t output, uint8_t input_mask)
+{
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    device->output_cache = (device->output_cache & 0xFF00) | output;
+    device->input_mask = (device->input_mask & 0xFF00) | input_mask;
+    return ESP_OK;
+}
+
 /* -------------------------------------------------------------------------- */
 /*  Pin direction                                                             */
 /* -------------------------------------------------------------------------- */
@@ -133,7 +329,7 @@ esp_err_t pcf8574_set_direction(pcf8574_handle_t dev, uint8_t input_mask)
     }
 
     pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    device->input_mask = input_mask;
+    device->input_mask = (device->input_mask & 0xFF00) | input_mask;
     return pcf8574_flush(device);
 }
 
@@ -144,7 +340,28 @@ esp_err_t pcf8574_get_direction(pcf8574_handle_t dev, uint8_t *input_mask)
     }
 
     pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    *input_mask = device->input_mask;
+    *input_mask = device->input_mask & 0xFF;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_set_direction_port(pcf8574_handle_t dev, uint16_t input_mask)
+{
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    device->input_mask = input_mask & pcf8574_port_mask(device);
+    return pcf8574_flush(device);
+}
+
+esp_err_t pcf8574_get_direction_port(pcf8574_handle_t dev, uint16_t *input_mask)
+{
+    if (dev == NULL || input_mask == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *input_mask = ((pcf8574_device_t *)dev)->input_mask;
     return ESP_OK;
 }
 
@@ -154,45 +371,46 @@ esp_err_t pcf8574_get_direction(pcf8574_handle_t dev, uint8_t *input_mask)
 
 esp_err_t pcf8574_set_pin(pcf8574_handle_t dev, uint8_t pin)
 {
-    if (dev == NULL || !pcf8574_pin_valid(pin)) {
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    if (device == NULL || !pcf8574_pin_valid(device, pin)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    device->output_cache |= (1 << pin);
+    device->output_cache |= (1U << pin);
     return pcf8574_flush(device);
 }
 
 esp_err_t pcf8574_clear_pin(pcf8574_handle_t dev, uint8_t pin)
 {
-    if (dev == NULL || !pcf8574_pin_valid(pin)) {
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    if (device == NULL || !pcf8574_pin_valid(device, pin)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    device->output_cache &= ~(1 << pin);
+    device->output_cache &= ~(1U << pin);
     return pcf8574_flush(device);
 }
 
 esp_err_t pcf8574_toggle_pin(pcf8574_handle_t dev, uint8_t pin)
 {
-    if (dev == NULL || !pcf8574_pin_valid(pin)) {
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    if (device == NULL || !pcf8574_pin_valid(device, pin)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    pcf8574_device_t *device = (pcf8574_device_t *)dev;
-    device->output_cache ^= (1 << pin);
+    device->output_cache ^= (1U << pin);
     return pcf8574_flush(device);
 }
 
 esp_err_t pcf8574_read_pin(pcf8574_handle_t dev, uint8_t pin, uint8_t *level)
 {
-    if (dev == NULL || level == NULL || !pcf8574_pin_valid(pin)) {
+    pcf8574_device_t *device = (pcf8574_device_t *)dev;
+    if (device == NULL || level == NULL || !pcf8574_pin_valid(device, pin)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t port_data = 0;
-    esp_err_t ret = pcf8574_read(dev, &port_data);
+    uint16_t port_data = 0;
+    esp_err_t ret = pcf8574_fetch(device, &port_data);
     if (ret == ESP_OK) {
         *level = (port_data >> pin) & 0x01;
     }
@@ -206,6 +424,8 @@ esp_err_t pcf8574_read_pin(pcf8574_handle_t dev, uint8_t pin, uint8_t *level)
 static void IRAM_ATTR pcf8574_isr_handler(void *arg)
 {
     pcf8574_device_t *device = (pcf8574_device_t *)arg;
+    device->stats.interrupts++;
+    PCF8574_TRACE(PCF8574_TRACE_INTERRUPT, device, ESP_OK);
     if (device->int_cb) {
         device->int_cb(device->int_cb_arg);
     }
@@ -0,0 +1,373 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+#include "pcf8574_group.h"
+
+static const char *TAG = "pcf8574_group";
+
+/* Read passes per interrupt while the INT line stays LOW */
+#define PCF8574_GROUP_MAX_PASSES    4
+/* Polling interval while the INT line stays LOW, doubled up to the maximum */
+#define PCF8574_GROUP_RETRY_MIN_MS  10
+#define PCF8574_GROUP_RETRY_MAX_MS  1000
+
+typedef struct {
+    pcf8574_handle_t dev;
+    uint16_t value;                 /*!< Port value of the last read */
+} pcf8574_group_entry_t;
+
+typedef struct {
+    pcf8574_handle_t dev;
+    uint16_t value;
+    uint16_t changed;
+} pcf8574_group_event_t;
+
+struct pcf8574_group_t {
+    pcf8574_group_config_t config;
+    volatile TaskHandle_t task;     /*!< Cleared by the task as its last access to the object */
+    SemaphoreHandle_t lock;
+    volatile bool stop;
+    volatile bool free_on_exit;     /*!< Deleted from its own callback, the task frees the group */
+    bool stuck_warned;
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock;   /*!< Keeps the chip out of light sleep during a read pass */
+#endif
+    uint8_t count;
+    pcf8574_group_entry_t entries[PCF8574_GROUP_MAX_DEVICES];
+};
+
+/* -------------------------------------------------------------------------- */
+/*  Internal helpers                                                          */
+/* -------------------------------------------------------------------------- */
+
+static void IRAM_ATTR pcf8574_group_isr(void *arg)
+{
+    pcf8574_group_handle_t group = (pcf8574_group_handle_t)arg;
+    BaseType_t woken = pdFALSE;
+    // Level interrupt: stays off until the task has read the devices and the line is released
+    gpio_intr_disable(group->config.int_gpio);
+    vTaskNotifyGiveFromISR(group->task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/* Arm the LOW level of the released line, also as light-sleep wake-up source if configured */
+static void pcf8574_group_arm(pcf8574_group_handle_t group)
+{
+    if (group->config.wakeup) {
+        gpio_wakeup_enable(group->config.int_gpio, GPIO_INTR_LOW_LEVEL);
+    } else {
+        gpio_set_intr_type(group->config.int_gpio, GPIO_INTR_LOW_LEVEL);
+    }
+    gpio_intr_enable(group->config.int_gpio);
+}
+
+static int pcf8574_group_find(pcf8574_group_handle_t group, pcf8574_handle_t dev)
+{
+    for (int i = 0; i < group->count; i++) {
+        if (group->entries[i].dev == dev) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Read every device once; return the number of devices with changed inputs.
+ */
+static int pcf8574_group_read_all(pcf8574_group_handle_t group, pcf8574_group_event_t *events)
+{
+    int num_events = 0;
+
+    xSemaphoreTake(group->lock, portMAX_DELAY);
+    for (int i = 0; i < group->count; i++) {
+        pcf8574_group_entry_t *entry = &group->entries[i];
+        uint16_t value = 0;
+        if (pcf8574_read_port(entry->dev, &value) != ESP_OK) {
+            continue;
+        }
+        uint16_t input_mask = 0;
+        pcf8574_get_direction_port(entry->dev, &input_mask);
+        uint16_t changed = (value ^ entry->value) & input_mask;
+        entry->value = value;
+        if (changed) {
+            events[num_events++] = (pcf8574_group_event_t) {
+                .dev = entry->dev,
+                .value = value,
+                .changed = changed,
+            };
+        }
+    }
+    xSemaphoreGive(group->lock);
+    return num_events;
+}
+
+static void pcf8574_group_free(pcf8574_group_handle_t group)
+{
+#if CONFIG_PM_ENABLE
+    if (group->pm_lock != NULL) {
+        esp_pm_lock_delete(group->pm_lock);
+    }
+#endif
+    vSemaphoreDelete(group->lock);
+    free(group);
+}
+
+/**
+ * @brief Read until the INT line is released; return false if it stays LOW.
+ */
+static bool pcf8574_group_read_passes(pcf8574_group_handle_t group, pcf8574_group_event_t *events)
+{
+    for (int pass = 0; pass < PCF8574_GROUP_MAX_PASSES && !group->stop; pass++) {
+        int num_events = pcf8574_group_read_all(group, events);
+        // Callbacks run without the lock so they may use the group API
+        for (int i = 0; i < num_events; i++) {
+            group->config.callback(events[i].dev, events[i].value, events[i].changed, group->config.user_arg);
+        }
+        // Every device was read, so a LOW line means a device changed again meanwhile
+        if (gpio_get_level(group->config.int_gpio) != 0) {
+            return true;
+        }
+    }
+    return group->stop;
+}
+
+static void pcf8574_group_task(void *arg)
+{
+    pcf8574_group_handle_t group = (pcf8574_group_handle_t)arg;
+    pcf8574_group_event_t events[PCF8574_GROUP_MAX_DEVICES];
+    TickType_t wait = portMAX_DELAY;
+    uint32_t retry_ms = PCF8574_GROUP_RETRY_MIN_MS;
+
+    while (!group->stop) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+#if CONFIG_PM_ENABLE
+        if (group->pm_lock != NULL) {
+            esp_pm_lock_acquire(group->pm_lock);
+        }
+#endif
+        const bool released = pcf8574_group_read_passes(group, events);
+#if CONFIG_PM_ENABLE
+        if (group->pm_lock != NULL) {
+            esp_pm_lock_release(group->pm_lock);
+        }
+#endif
+
+        if (released) {
+            if (!group->stop) {
+                pcf8574_group_arm(group);
+            }
+            wait = portMAX_DELAY;
+            retry_ms = PCF8574_GROUP_RETRY_MIN_MS;
+            continue;
+        }
+        // The level interrupt stays off while the line is held LOW, so poll until it is released.
+        // A held line must not keep the chip out of light sleep either.
+        if (group->config.wakeup) {
+            gpio_wakeup_disable(group->config.int_gpio);
+        }
+        if (!group->stuck_warned) {
+            ESP_LOGW(TAG, "INT GPIO %d stays LOW, is a device missing from the group?", group->config.int_gpio);
+            group->stuck_warned = true;
+        }
+        wait = pdMS_TO_TICKS(retry_ms);
+        retry_ms = (retry_ms * 2 > PCF8574_GROUP_RETRY_MAX_MS) ? PCF8574_GROUP_RETRY_MAX_MS : retry_ms * 2;
+    }
+
+    // Once the task is cleared pcf8574_group_delete() may free the group: read the flag first
+    const bool free_on_exit = group->free_on_exit;
+    group->task = NULL;
+    if (free_on_exit) {
+        pcf8574_group_free(group);
+    }
+    vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*  Public API                                                                */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t pcf8574_group_create(const pcf8574_group_config_t *config, pcf8574_group_handle_t *ret_handle)
+{
+    if (config == NULL || ret_handle == NULL || config->callback == NULL ||
+            !GPIO_IS_VALID_GPIO(config->int_gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_group_handle_t group = calloc(1, sizeof(struct pcf8574_group_t));
+    if (group == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    group->config = *config;
+    group->lock = xSemaphoreCreateMutex();
+    if (group->lock == NULL) {
+        free(group);
+        return ESP_ERR_NO_MEM;
+    }
+#if CONFIG_PM_ENABLE
+    esp_err_t pm_ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "pcf8574_group", &group->pm_lock);
+    if (pm_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create PM lock: %s", esp_err_to_name(pm_ret));
+        pcf8574_group_free(group);
+        return pm_ret;
+    }
+#endif
+    if (xTaskCreate(pcf8574_group_task, "pcf8574_group", PCF8574_GROUP_TASK_STACK_SIZE, group,
+                    config->task_priority, (TaskHandle_t *)&group->task) != pdPASS) {
+        pcf8574_group_free(group);
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* PCF8574 INT is active-LOW, open-drain */
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << config->int_gpio),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret == ESP_OK) {
+        ret = gpio_install_isr_service(0);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            ret = ESP_OK;   /* Already installed */
+        }
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(config->int_gpio, pcf8574_group_isr, group);
+    }
+    if (ret == ESP_OK) {
+        pcf8574_group_arm(group);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up INT GPIO %d: %s", config->int_gpio, esp_err_to_name(ret));
+        group->config.int_gpio = GPIO_NUM_NC;   /* No handler to remove */
+        pcf8574_group_delete(&group);
+        return ret;
+    }
+
+    *ret_handle = group;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_group_delete(pcf8574_group_handle_t *handle)
+{
+    if (handle == NULL || *handle == NULL) {
+        return ESP_OK;
+    }
+
+    pcf8574_group_handle_t group = *handle;
+    if (group->config.int_gpio != GPIO_NUM_NC) {
+        gpio_isr_handler_remove(group->config.int_gpio);
+        if (group->config.wakeup) {
+            gpio_wakeup_disable(group->config.int_gpio);
+        }
+        gpio_reset_pin(group->config.int_gpio);
+    }
+    // Let the task finish a read pass rather than deleting it with the bus locked
+    group->stop = true;
+    *handle = NULL;
+    if (xTaskGetCurrentTaskHandle() == group->task) {
+        // Called from the change callback: the task frees the group once the callback returns
+        group->free_on_exit = true;
+        return ESP_OK;
+    }
+    TaskHandle_t task;
+    while ((task = group->task) != NULL) {
+        xTaskNotifyGive(task);
+        vTaskDelay(1);
+    }
+    pcf8574_group_free(group);
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_group_add(pcf8574_group_handle_t handle, pcf8574_handle_t dev)
+{
+    if (handle == NULL || dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Reading releases the device's INT and gives the baseline for change detection
+    uint16_t value = 0;
+    ESP_RETURN_ON_ERROR(pcf8574_read_port(dev, &value), TAG, "Failed to read device");
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    int index = pcf8574_group_find(handle, dev);
+    if (index >= 0) {
+        handle->entries[index].value = value;
+    } else if (handle->count < PCF8574_GROUP_MAX_DEVICES) {
+        handle->entries[handle->count++] = (pcf8574_group_entry_t) {
+            .dev = dev,
+            .value = value,
+        };
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(handle->lock);
+    return ret;
+}
+
+esp_err_t pcf8574_group_remove(pcf8574_group_handle_t handle, pcf8574_handle_t dev)
+{
+    if (handle == NULL || dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    int index = pcf8574_group_find(handle, dev);
+    if (index >= 0) {
+        handle->entries[index] = handle->entries[--handle->count];
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(handle->lock);
+    return ret;
+}
+
+esp_err_t pcf8574_group_get_input(pcf8574_group_handle_t handle, pcf8574_handle_t dev, uint16_t *value)
+{
+    if (handle == NULL || dev == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    int index = pcf8574_group_find(handle, dev);
+    if (index >= 0) {
+        *value = handle->entries[index].value;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(handle->lock);
+    return ret;
+}
+
+esp_err_t pcf8574_group_trigger(pcf8574_group_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xTaskNotifyGive(handle->task);
+    return ESP_OK;
+}
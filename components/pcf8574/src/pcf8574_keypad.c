@@ -0,0 +1,309 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdlib.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "pcf8574_keypad.h"
+
+static const char *TAG = "pcf8574_keypad";
+
+#define PCF8574_KEYPAD_SCAN_RETRIES     3
+
+struct pcf8574_keypad_t {
+    pcf8574_handle_t dev;
+    pcf8574_keypad_config_t config;
+    uint8_t num_cols;
+    volatile TaskHandle_t task;     /*!< Cleared by the task as its last access to the object */
+    volatile bool stop;
+    volatile bool free_on_exit;     /*!< Deleted from its own callback, the task frees the keypad */
+    uint16_t keys;                  /*!< Debounced key state */
+};
+
+/* -------------------------------------------------------------------------- */
+/*  Internal helpers                                                          */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Drive @p low_mask LOW and release the other keypad pins (HIGH = input).
+ */
+static esp_err_t pcf8574_keypad_drive(pcf8574_keypad_handle_t kp, uint8_t low_mask)
+{
+    const uint8_t pins = kp->config.row_mask | kp->config.col_mask;
+    uint8_t current = 0;
+    pcf8574_get_output(kp->dev, &current);
+    return pcf8574_write(kp->dev, (current & ~pins) | (pins & ~low_mask));
+}
+
+/**
+ * @brief Read the pins of @p mask that are pulled LOW.
+ */
+static esp_err_t pcf8574_keypad_read_low(pcf8574_keypad_handle_t kp, uint8_t mask, uint8_t *low)
+{
+    uint8_t port = 0xFF;
+    esp_err_t ret = pcf8574_read(kp->dev, &port);
+    *low = ~port & mask;
+    return ret;
+}
+
+/**
+ * @brief Add the keys of one row to a key bitmap.
+ */
+static uint16_t pcf8574_keypad_row_keys(pcf8574_keypad_handle_t kp, int row_index, uint8_t cols_low)
+{
+    uint16_t keys = 0;
+    int col_index = 0;
+    for (int pin = 0; pin < PCF8574_PIN_COUNT; pin++) {
+        if (!(kp->config.col_mask & (1 << pin))) {
+            continue;
+        }
+        if (cols_low & (1 << pin)) {
+            keys |= 1 << (row_index * kp->num_cols + col_index);
+        }
+        col_index++;
+    }
+    return keys;
+}
+
+/**
+ * @brief Scan the matrix. Leaves all rows LOW (idle) on return.
+ *
+ * @param[out] keys Pressed keys
+ * @param[out] ghost Set if the scan is ambiguous
+ * @param[out] idle_cols Columns LOW in the idle state at the start of the scan
+ */
+static esp_err_t pcf8574_keypad_scan(pcf8574_keypad_handle_t kp, uint16_t *keys, bool *ghost, uint8_t *idle_cols)
+{
+    const uint8_t row_mask = kp->config.row_mask;
+    const uint8_t col_mask = kp->config.col_mask;
+    uint8_t cols = 0;
+    uint8_t rows = 0;
+
+    *keys = 0;
+    *ghost = false;
+
+    // Idle state: rows LOW, so the columns show every pressed key
+    ESP_RETURN_ON_ERROR(pcf8574_keypad_read_low(kp, col_mask, &cols), TAG, "Column read failed");
+    *idle_cols = cols;
+    if (cols == 0) {
+        return ESP_OK;
+    }
+
+    // Reverse roles to find the active rows
+    esp_err_t ret = pcf8574_keypad_drive(kp, col_mask);
+    if (ret == ESP_OK) {
+        ret = pcf8574_keypad_read_low(kp, row_mask, &rows);
+    }
+
+    uint8_t row_cols[PCF8574_PIN_COUNT] = {0};
+    int row_index = 0;
+    for (int pin = 0; pin < PCF8574_PIN_COUNT && ret == ESP_OK; pin++) {
+        if (!(row_mask & (1 << pin))) {
+            continue;
+        }
+        if (rows & (1 << pin)) {
+            if (rows == (1 << pin)) {
+                // Single active row: the idle column read is already its row
+                row_cols[pin] = cols;
+            } else {
+                ret = pcf8574_keypad_drive(kp, 1 << pin);
+                if (ret == ESP_OK) {
+                    ret = pcf8574_keypad_read_low(kp, col_mask, &row_cols[pin]);
+                }
+            }
+            *keys |= pcf8574_keypad_row_keys(kp, row_index, row_cols[pin]);
+        }
+        row_index++;
+    }
+
+    // Two rows sharing two columns form a rectangle, one corner may be a ghost
+    for (int a = 0; a < PCF8574_PIN_COUNT && ret == ESP_OK; a++) {
+        for (int b = a + 1; b < PCF8574_PIN_COUNT; b++) {
+            if (__builtin_popcount(row_cols[a] & row_cols[b]) >= 2) {
+                *ghost = true;
+            }
+        }
+    }
+
+    esp_err_t idle_ret = pcf8574_keypad_drive(kp, row_mask);
+    return (ret != ESP_OK) ? ret : idle_ret;
+}
+
+static void IRAM_ATTR pcf8574_keypad_isr_cb(void *arg)
+{
+    pcf8574_keypad_handle_t kp = (pcf8574_keypad_handle_t)arg;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(kp->task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void pcf8574_keypad_emit(pcf8574_keypad_handle_t kp, uint16_t keys)
+{
+    uint16_t changed = keys ^ kp->keys;
+    kp->keys = keys;
+    for (int key = 0; changed && !kp->stop; key++, changed >>= 1) {
+        if (changed & 0x01) {
+            kp->config.callback((keys & (1 << key)) ? PCF8574_KEYPAD_PRESS : PCF8574_KEYPAD_RELEASE, key,
+                                kp->config.user_arg);
+        }
+    }
+}
+
+static void pcf8574_keypad_task(void *arg)
+{
+    pcf8574_keypad_handle_t kp = (pcf8574_keypad_handle_t)arg;
+    const bool polled = (kp->config.int_gpio == GPIO_NUM_NC);
+
+    while (!kp->stop) {
+        // Sleep until INT, poll only while keys are held or without an INT line
+        TickType_t wait = (kp->keys || polled) ? pdMS_TO_TICKS(kp->config.hold_poll_ms) : portMAX_DELAY;
+        if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+            // Wait for the contacts to settle, restarting on every new edge
+            while (!kp->stop && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kp->config.debounce_ms)) > 0) {
+            }
+        }
+        if (kp->stop) {
+            break;
+        }
+
+        uint16_t keys = 0;
+        bool ghost = false;
+        esp_err_t ret = ESP_OK;
+        for (int i = 0; i < PCF8574_KEYPAD_SCAN_RETRIES; i++) {
+            uint8_t cols_before = 0;
+            uint8_t cols_after = 0;
+            ret = pcf8574_keypad_scan(kp, &keys, &ghost, &cols_before);
+            // The scan toggles the inputs and raises INT; drop those edges, then check
+            // nothing changed during the scan. Later edges raise INT again.
+            ulTaskNotifyTake(pdTRUE, 0);
+            if (ret == ESP_OK) {
+                ret = pcf8574_keypad_read_low(kp, kp->config.col_mask, &cols_after);
+            }
+            if (ret != ESP_OK || cols_after == cols_before) {
+                break;
+            }
+        }
+
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Scan failed: %s", esp_err_to_name(ret));
+        } else if (ghost) {
+            kp->config.callback(PCF8574_KEYPAD_GHOST, 0xFF, kp->config.user_arg);
+        } else {
+            pcf8574_keypad_emit(kp, keys);
+        }
+    }
+
+    // Once the task is cleared pcf8574_keypad_delete() may free the keypad: read the flag first
+    const bool free_on_exit = kp->free_on_exit;
+    kp->task = NULL;
+    if (free_on_exit) {
+        free(kp);
+    }
+    vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*  Public API                                                                */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t pcf8574_keypad_create(pcf8574_handle_t dev, const pcf8574_keypad_config_t *config,
+                                pcf8574_keypad_handle_t *ret_handle)
+{
+    if (dev == NULL || config == NULL || ret_handle == NULL || config->callback == NULL ||
+            config->row_mask == 0 || config->col_mask == 0 || (config->row_mask & config->col_mask)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_keypad_handle_t kp = calloc(1, sizeof(struct pcf8574_keypad_t));
+    if (kp == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    kp->dev = dev;
+    kp->config = *config;
+    kp->num_cols = __builtin_popcount(config->col_mask);
+    if (kp->config.hold_poll_ms == 0) {
+        kp->config.hold_poll_ms = 20;
+    }
+
+    // The keypad pins are driven through the output latch, not the direction mask
+    uint8_t output = 0xFF;
+    uint8_t input_mask = 0;
+    pcf8574_get_output(dev, &output);
+    pcf8574_get_direction(dev, &input_mask);
+    esp_err_t ret = pcf8574_restore_state(dev, output, input_mask & ~(config->row_mask | config->col_mask));
+    if (ret == ESP_OK) {
+        ret = pcf8574_keypad_drive(kp, config->row_mask);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up keypad pins: %s", esp_err_to_name(ret));
+        free(kp);
+        return ret;
+    }
+
+    if (xTaskCreate(pcf8574_keypad_task, "pcf8574_keypad", PCF8574_KEYPAD_TASK_STACK_SIZE, kp,
+                    config->task_priority, (TaskHandle_t *)&kp->task) != pdPASS) {
+        free(kp);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (config->int_gpio != GPIO_NUM_NC) {
+        ret = pcf8574_register_interrupt(dev, config->int_gpio, pcf8574_keypad_isr_cb, kp);
+        if (ret != ESP_OK) {
+            pcf8574_keypad_delete(&kp);
+            return ret;
+        }
+    }
+
+    // Pick up keys already held at start-up
+    xTaskNotifyGive(kp->task);
+    *ret_handle = kp;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_keypad_delete(pcf8574_keypad_handle_t *handle)
+{
+    if (handle == NULL || *handle == NULL) {
+        return ESP_OK;
+    }
+
+    pcf8574_keypad_handle_t kp = *handle;
+    if (kp->config.int_gpio != GPIO_NUM_NC) {
+        pcf8574_unregister_interrupt(kp->dev);
+    }
+    // Let the task finish a scan in progress rather than deleting it with the bus locked
+    kp->stop = true;
+    *handle = NULL;
+    if (xTaskGetCurrentTaskHandle() == kp->task) {
+        // Called from the key callback: the task frees the keypad once the callback returns
+        kp->free_on_exit = true;
+        return ESP_OK;
+    }
+    TaskHandle_t task;
+    while ((task = kp->task) != NULL) {
+        xTaskNotifyGive(task);
+        vTaskDelay(1);
+    }
+    free(kp);
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_keypad_get_state(pcf8574_keypad_handle_t handle, uint16_t *keys)
+{
+    if (handle == NULL || keys == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *keys = handle->keys;
+    return ESP_OK;
+}
@@ -0,0 +1,343 @@
+/* HOPE Badge BSP
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdlib.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "pcf8574_pattern.h"
+
+static const char *TAG = "pcf8574_pattern";
+
+typedef enum {
+    PCF8574_PATTERN_NONE = 0,
+    PCF8574_PATTERN_PWM,
+    PCF8574_PATTERN_BLINK,
+    PCF8574_PATTERN_SEQUENCE,
+} pcf8574_pattern_type_t;
+
+typedef struct {
+    pcf8574_pattern_type_t type;
+    uint8_t duty;                   /*!< PWM on ticks per PCF8574_PATTERN_PWM_STEPS */
+    uint16_t on_ticks;              /*!< Blink on ticks */
+    uint32_t bits;                  /*!< Sequence bits, bit 0 first */
+    uint8_t length;                 /*!< Sequence length in bits */
+    uint16_t ticks_per_step;        /*!< Sequence ticks per bit */
+    uint32_t period;                /*!< Blink or sequence length in ticks */
+    uint32_t counter;               /*!< Position in the period */
+} pcf8574_pattern_pin_t;
+
+struct pcf8574_pattern_t {
+    pcf8574_handle_t dev;
+    esp_timer_handle_t timer;
+    uint32_t tick_ms;
+    uint16_t active_low_mask;
+    uint16_t active_mask;           /*!< Pins driven by the engine */
+    uint8_t pwm_phase;
+    bool running;                   /*!< Timer started */
+    volatile bool retry;            /*!< Last write failed, write even if the byte is unchanged */
+    volatile bool deleting;         /*!< Next tick is the last one, it only wakes the deleter */
+    volatile bool exit;             /*!< The write task exits on its next wake-up */
+    TaskHandle_t deleter;
+    TaskHandle_t task;              /*!< Performs the port writes computed by the ticks */
+    uint16_t pending_mask;          /*!< Pins and levels of the last tick, for the task to write */
+    uint16_t pending_on;
+    portMUX_TYPE spin;              /*!< Pin state, phase and the pending write; taken by ticks */
+    SemaphoreHandle_t lock;         /*!< Serializes port writes of the task and callers */
+    uint8_t pin_count;
+    pcf8574_pattern_pin_t pins[PCF8575_PIN_COUNT];
+};
+
+/* -------------------------------------------------------------------------- */
+/*  Internal helpers                                                          */
+/* -------------------------------------------------------------------------- */
+
+static bool pcf8574_pattern_pin_on(pcf8574_pattern_pin_t *p, uint8_t pwm_phase)
+{
+    bool on = false;
+    switch (p->type) {
+    case PCF8574_PATTERN_PWM:
+        return pwm_phase < p->duty;
+    case PCF8574_PATTERN_BLINK:
+        on = p->counter < p->on_ticks;
+        break;
+    case PCF8574_PATTERN_SEQUENCE:
+        on = (p->bits >> (p->counter / p->ticks_per_step)) & 0x01;
+        break;
+    default:
+        return false;
+    }
+    if (++p->counter >= p->period) {
+        p->counter = 0;
+    }
+    return on;
+}
+
+/**
+ * @brief Merge the engine pins into the cached port value and write it if it changed.
+ */
+static esp_err_t pcf8574_pattern_apply(pcf8574_pattern_handle_t handle, uint16_t mask, uint16_t on_mask)
+{
+    uint16_t current = 0;
+    pcf8574_get_output_port(handle->dev, &current);
+
+    uint16_t value = (current & ~mask) | ((on_mask ^ handle->active_low_mask) & mask);
+    if (value == current && !handle->retry) {
+        return ESP_OK;
+    }
+    esp_err_t ret = pcf8574_write_port(handle->dev, value);
+    handle->retry = (ret != ESP_OK);
+    return ret;
+}
+
+/* Never blocks the esp_timer task: the tick only computes the levels, the I2C write runs on the engine task */
+static void pcf8574_pattern_tick(void *arg)
+{
+    pcf8574_pattern_handle_t handle = (pcf8574_pattern_handle_t)arg;
+    uint16_t on_mask = 0;
+
+    if (handle->deleting) {
+        // Called once more by pcf8574_pattern_delete(): the engine is not touched after this
+        xTaskNotifyGive(handle->deleter);
+        return;
+    }
+    taskENTER_CRITICAL(&handle->spin);
+    const uint16_t mask = handle->active_mask;
+    for (int pin = 0; pin < handle->pin_count; pin++) {
+        if ((mask & (1U << pin)) && pcf8574_pattern_pin_on(&handle->pins[pin], handle->pwm_phase)) {
+            on_mask |= (1U << pin);
+        }
+    }
+    handle->pwm_phase = (handle->pwm_phase + 1) % PCF8574_PATTERN_PWM_STEPS;
+    const bool changed = mask != handle->pending_mask || on_mask != handle->pending_on || handle->retry;
+    handle->pending_mask = mask;
+    handle->pending_on = on_mask;
+    taskEXIT_CRITICAL(&handle->spin);
+
+    if (changed && mask) {
+        xTaskNotifyGive(handle->task);
+    }
+}
+
+static void pcf8574_pattern_task(void *arg)
+{
+    pcf8574_pattern_handle_t handle = (pcf8574_pattern_handle_t)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (handle->exit) {
+            break;
+        }
+        xSemaphoreTake(handle->lock, portMAX_DELAY);
+        taskENTER_CRITICAL(&handle->spin);
+        const uint16_t mask = handle->pending_mask;
+        const uint16_t on_mask = handle->pending_on;
+        taskEXIT_CRITICAL(&handle->spin);
+        if (mask) {
+            pcf8574_pattern_apply(handle, mask, on_mask);
+        }
+        xSemaphoreGive(handle->lock);
+    }
+
+    // Last access to the engine, pcf8574_pattern_delete() frees it once woken
+    xTaskNotifyGive(handle->deleter);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t pcf8574_pattern_check_pin(pcf8574_pattern_handle_t handle, uint8_t pin)
+{
+    if (handle == NULL || pin >= handle->pin_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint16_t input_mask = 0;
+    pcf8574_get_direction_port(handle->dev, &input_mask);
+    if (input_mask & (1U << pin)) {
+        ESP_LOGE(TAG, "P%d is configured as input", pin);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t pcf8574_pattern_start_pin(pcf8574_pattern_handle_t handle, uint8_t pin,
+                                           const pcf8574_pattern_pin_t *pattern)
+{
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    taskENTER_CRITICAL(&handle->spin);
+    handle->pins[pin] = *pattern;
+    handle->active_mask |= (1U << pin);
+    taskEXIT_CRITICAL(&handle->spin);
+    if (!handle->running) {
+        ret = esp_timer_start_periodic(handle->timer, (uint64_t)handle->tick_ms * 1000);
+        handle->running = (ret == ESP_OK);
+    }
+    xSemaphoreGive(handle->lock);
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to start timer");
+    return ESP_OK;
+}
+
+/* -------------------------------------------------------------------------- */
+/*  Public API                                                                */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t pcf8574_pattern_create(pcf8574_handle_t dev, const pcf8574_pattern_config_t *config,
+                                 pcf8574_pattern_handle_t *ret_handle)
+{
+    if (dev == NULL || config == NULL || ret_handle == NULL || config->tick_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pcf8574_pattern_handle_t handle = calloc(1, sizeof(struct pcf8574_pattern_t));
+    if (handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    handle->dev = dev;
+    handle->tick_ms = config->tick_ms;
+    handle->active_low_mask = config->active_low_mask;
+    handle->pin_count = pcf8574_get_pin_count(dev);
+    portMUX_INITIALIZE(&handle->spin);
+    handle->lock = xSemaphoreCreateMutex();
+    if (handle->lock == NULL) {
+        free(handle);
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(pcf8574_pattern_task, "pcf8574_pattern", PCF8574_PATTERN_TASK_STACK_SIZE, handle,
+                    config->task_priority, &handle->task) != pdPASS) {
+        vSemaphoreDelete(handle->lock);
+        free(handle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = pcf8574_pattern_tick,
+        .arg = handle,
+        .name = "pcf8574_pattern",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &handle->timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create timer: %s", esp_err_to_name(ret));
+        // The task has not run yet or is waiting for a tick: it can be deleted right away
+        vTaskDelete(handle->task);
+        vSemaphoreDelete(handle->lock);
+        free(handle);
+        return ret;
+    }
+
+    *ret_handle = handle;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_pattern_delete(pcf8574_pattern_handle_t *handle)
+{
+    if (handle == NULL || *handle == NULL) {
+        return ESP_OK;
+    }
+
+    pcf8574_pattern_handle_t h = *handle;
+    xSemaphoreTake(h->lock, portMAX_DELAY);
+    if (h->running) {
+        esp_timer_stop(h->timer);
+    }
+    /*
+     * A tick may already be dispatched. Ticks run one at a time in the esp_timer task, so once a
+     * final one-shot call has run, none is running or pending and the engine can be freed.
+     */
+    h->deleter = xTaskGetCurrentTaskHandle();
+    h->deleting = true;
+    esp_err_t ret = esp_timer_start_once(h->timer, 0);
+    xSemaphoreGive(h->lock);
+    if (ret == ESP_OK) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    // No tick can wake the task any more: let it finish a write in progress and exit
+    h->exit = true;
+    xTaskNotifyGive(h->task);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    esp_timer_delete(h->timer);
+    vSemaphoreDelete(h->lock);
+    free(h);
+    *handle = NULL;
+    return ESP_OK;
+}
+
+esp_err_t pcf8574_pattern_set_pwm(pcf8574_pattern_handle_t handle, uint8_t pin, uint8_t duty)
+{
+    ESP_RETURN_ON_ERROR(pcf8574_pattern_check_pin(handle, pin), TAG, "Invalid pin");
+    if (duty > PCF8574_PATTERN_PWM_STEPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const pcf8574_pattern_pin_t pattern = {
+        .type = PCF8574_PATTERN_PWM,
+        .duty = duty,
+    };
+    return pcf8574_pattern_start_pin(handle, pin, &pattern);
+}
+
+esp_err_t pcf8574_pattern_set_blink(pcf8574_pattern_handle_t handle, uint8_t pin,
+                                    uint16_t on_ticks, uint16_t off_ticks)
+{
+    ESP_RETURN_ON_ERROR(pcf8574_pattern_check_pin(handle, pin), TAG, "Invalid pin");
+    if (on_ticks == 0 || off_ticks == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const pcf8574_pattern_pin_t pattern = {
+        .type = PCF8574_PATTERN_BLINK,
+        .on_ticks = on_ticks,
+        .period = (uint32_t)on_ticks + off_ticks,
+    };
+    return pcf8574_pattern_start_pin(handle, pin, &pattern);
+}
+
+esp_err_t pcf8574_pattern_set_sequence(pcf8574_pattern_handle_t handle, uint8_t pin, uint32_t bits,
+                                       uint8_t length, uint16_t ticks_per_step)
+{
+    ESP_RETURN_ON_ERROR(pcf8574_pattern_check_pin(handle, pin), TAG, "Invalid pin");
+    if (length == 0 || length > 32 || ticks_per_step == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const pcf8574_pattern_pin_t pattern = {
+        .type = PCF8574_PATTERN_SEQUENCE,
+        .bits = bits,
+        .length = length,
+        .ticks_per_step = ticks_per_step,
+        .period = (uint32_t)length * ticks_per_step,
+    };
+    return pcf8574_pattern_start_pin(handle, pin, &pattern);
+}
+
+esp_err_t pcf8574_pattern_stop(pcf8574_pattern_handle_t handle, uint8_t pin, bool on)
+{
+    if (handle == NULL || pin >= handle->pin_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Under the lock so the task cannot write the pin between the stop and the final level
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    taskENTER_CRITICAL(&handle->spin);
+    handle->active_mask &= ~(1U << pin);
+    handle->pending_mask &= ~(1U << pin);
+    handle->pins[pin].type = PCF8574_PATTERN_NONE;
+    taskEXIT_CRITICAL(&handle->spin);
+    if (handle->active_mask == 0 && handle->running) {
+        esp_timer_stop(handle->timer);
+        handle->running = false;
+    }
+    esp_err_t ret = pcf8574_pattern_apply(handle, 1U << pin, on ? (1U << pin) : 0);
+    xSemaphoreGive(handle->lock);
+    return ret;
+}
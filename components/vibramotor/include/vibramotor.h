@@ -5,8 +5,12 @@
 
 #pragma once
 
+#include <stdbool.h>
+
 #include "sdkconfig.h"
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,9 +22,24 @@ typedef struct {
     uint32_t repeat_count;
 } vibramotor_params_t;
 
+typedef struct {
+    uint32_t runs;          // Patterns started
+    uint32_t stops;         // Running patterns cut short by vibramotor_stop()
+    uint32_t on_ms;         // Total motor on time
+} vibramotor_stats_t;
+
+// Called by the worker task each time the motor is switched on or off
+typedef void (*vibramotor_step_cb_t)(bool on);
+
 esp_err_t vibramotor_init(uint8_t gpio_num);
 esp_err_t vibramotor_run(uint16_t time_on_ms, uint16_t time_off_ms, uint16_t cycles);
 void vibramotor_stop(void);
+void vibramotor_get_stats(vibramotor_stats_t *stats);
+TaskHandle_t vibramotor_get_task_handle(void);
+void vibramotor_set_step_cb(vibramotor_step_cb_t cb);
+// While held the motor stays off; patterns keep running silently, e.g. to shed load on a weak battery
+void vibramotor_set_hold(bool hold);
+bool vibramotor_is_on(void);
 
 #ifdef __cplusplus
 }
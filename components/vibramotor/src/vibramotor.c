@@ -10,87 +10,215 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "sdkconfig.h"
 #include "driver/gpio.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_check.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 
 #include "vibramotor.h"
 
 static const char *TAG = "Vibramotor";
 static int8_t vibramotor_gpio_num = -1;
 
+#define VIBRAMOTOR_CMD_STOP     1
+#define VIBRAMOTOR_CMD_RUN      2
+
+/*
+ * A single worker task plays the patterns. It is created once and then driven by
+ * task notifications, so starting or stopping a pattern never allocates memory.
+ */
 static TaskHandle_t vibramotor_task_handle = NULL;
+#if CONFIG_VIBRAMOTOR_STATIC_ALLOC
+static StaticTask_t vibramotor_task_buf;
+static StackType_t vibramotor_task_stack[CONFIG_VIBRAMOTOR_TASK_STACK_SIZE];
+#endif
+
+// Pattern for the next VIBRAMOTOR_CMD_RUN, guarded by vibramotor_spinlock
+static vibramotor_params_t vibramotor_params;
+static portMUX_TYPE vibramotor_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static vibramotor_stats_t vibramotor_stats;
+static vibramotor_step_cb_t vibramotor_step_cb = NULL;
+static volatile bool vibramotor_on = false;
+static volatile bool vibramotor_hold = false;     // Patterns keep their timing, the motor stays off
+
+#if CONFIG_PM_ENABLE
+// Keeps the chip out of light sleep while a pattern is running
+static esp_pm_lock_handle_t vibramotor_pm_lock = NULL;
+#endif
 
-static void vibramotor_run_task(void *pvParameters)
+static void vibramotor_pm_lock_acquire(void)
 {
-    vibramotor_params_t params;
-    memcpy(&params, pvParameters, sizeof(vibramotor_params_t));
+#if CONFIG_PM_ENABLE
+    if (vibramotor_pm_lock != NULL) {
+        esp_pm_lock_acquire(vibramotor_pm_lock);
+    }
+#endif
+}
 
-    // Free the heap-allocated parameters now that we have a local copy
-    free(pvParameters);
+static void vibramotor_pm_lock_release(void)
+{
+#if CONFIG_PM_ENABLE
+    if (vibramotor_pm_lock != NULL) {
+        esp_pm_lock_release(vibramotor_pm_lock);
+    }
+#endif
+}
 
-    uint32_t on_time = params.time_on_ms;
-    uint32_t off_time = params.time_off_ms;
-    uint32_t repeat_count = params.repeat_count;
+static void vibramotor_set(bool on)
+{
+    on = on && !vibramotor_hold;
+    vibramotor_on = on;
+    gpio_set_level(vibramotor_gpio_num, on);
+    vibramotor_step_cb_t cb = vibramotor_step_cb;
+    if (cb) {
+        cb(on);
+    }
+}
 
-    for (uint32_t i = 0; i < repeat_count; i++) {
-        gpio_set_level(vibramotor_gpio_num, 1);
-        vTaskDelay(pdMS_TO_TICKS(on_time));
-        gpio_set_level(vibramotor_gpio_num, 0);
-        vTaskDelay(pdMS_TO_TICKS(off_time));
+/**
+ * @brief Wait for @p ms, returning early with the command if a new one arrives.
+ */
+static uint32_t vibramotor_wait(uint32_t ms)
+{
+    uint32_t cmd = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &cmd, pdMS_TO_TICKS(ms)) != pdTRUE) {
+        return 0;
     }
+    return cmd;
+}
+
+static void vibramotor_task(void *pvParameters)
+{
+    uint32_t cmd = 0;
+
+    while (1) {
+        if (cmd == 0) {
+            xTaskNotifyWait(0, UINT32_MAX, &cmd, portMAX_DELAY);
+        }
+        if (cmd != VIBRAMOTOR_CMD_RUN) {
+            cmd = 0;
+            continue;
+        }
+        cmd = 0;
 
-    // Ensure motor is off and clear handle before self-deleting
-    gpio_set_level(vibramotor_gpio_num, 0);
-    vibramotor_task_handle = NULL;
-    vTaskDelete(NULL);
+        vibramotor_params_t params;
+        taskENTER_CRITICAL(&vibramotor_spinlock);
+        params = vibramotor_params;
+        taskEXIT_CRITICAL(&vibramotor_spinlock);
+
+        vibramotor_pm_lock_acquire();
+        for (uint32_t i = 0; i < params.repeat_count && cmd == 0; i++) {
+            TickType_t start = xTaskGetTickCount();
+            vibramotor_set(true);
+            cmd = vibramotor_wait(params.time_on_ms);
+            vibramotor_set(false);
+            vibramotor_stats.on_ms += pdTICKS_TO_MS(xTaskGetTickCount() - start);
+            if (cmd == 0) {
+                cmd = vibramotor_wait(params.time_off_ms);
+            }
+        }
+
+        // Only a stop that cut a pattern short counts, not one while idle or a replacing run
+        if (cmd == VIBRAMOTOR_CMD_STOP) {
+            vibramotor_stats.stops++;
+        }
+
+        // Ensure motor is off; a pending command is handled on the next iteration
+        vibramotor_on = false;
+        gpio_set_level(vibramotor_gpio_num, 0);
+        vibramotor_pm_lock_release();
+    }
 }
 
 void vibramotor_stop(void)
 {
     if (vibramotor_task_handle != NULL) {
-        vTaskDelete(vibramotor_task_handle);
-        vibramotor_task_handle = NULL;
+        xTaskNotify(vibramotor_task_handle, VIBRAMOTOR_CMD_STOP, eSetValueWithOverwrite);
     }
 
     // Ensure motor is off regardless
     if (vibramotor_gpio_num >= 0) {
+        vibramotor_on = false;
         gpio_set_level(vibramotor_gpio_num, 0);
     }
 }
 
 esp_err_t vibramotor_run(uint16_t time_on_ms, uint16_t time_off_ms, uint16_t cycles)
 {
-    if (vibramotor_gpio_num == -1) {
+    if (vibramotor_gpio_num == -1 || vibramotor_task_handle == NULL) {
         ESP_LOGE(TAG, "Vibramotor GPIO not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Stop any currently running vibration before starting a new one
-    vibramotor_stop();
+    taskENTER_CRITICAL(&vibramotor_spinlock);
+    vibramotor_params.time_on_ms = time_on_ms;
+    vibramotor_params.time_off_ms = time_off_ms;
+    vibramotor_params.repeat_count = cycles;
+    taskEXIT_CRITICAL(&vibramotor_spinlock);
 
-    // Heap-allocate params so the task can safely read them after this function returns
-    vibramotor_params_t *params = malloc(sizeof(vibramotor_params_t));
-    if (params == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate vibramotor params");
-        return ESP_ERR_NO_MEM;
+    // Replaces any currently running pattern
+    xTaskNotify(vibramotor_task_handle, VIBRAMOTOR_CMD_RUN, eSetValueWithOverwrite);
+    vibramotor_stats.runs++;
+    return ESP_OK;
+}
+
+void vibramotor_set_hold(bool hold)
+{
+    vibramotor_hold = hold;
+    if (hold && vibramotor_gpio_num >= 0) {
+        // A running pulse is cut now, later pulses of the pattern stay off
+        vibramotor_on = false;
+        gpio_set_level(vibramotor_gpio_num, 0);
     }
+}
 
-    params->time_on_ms = time_on_ms;
-    params->time_off_ms = time_off_ms;
-    params->repeat_count = cycles;
+bool vibramotor_is_on(void)
+{
+    return vibramotor_on;
+}
 
-    BaseType_t xret = xTaskCreate(vibramotor_run_task, "vibramotor_task", 2048,
-                                  params, 5, &vibramotor_task_handle);
-    if (xret != pdPASS) {
-        free(params);
-        ESP_LOGE(TAG, "Failed to create vibramotor task");
-        return ESP_FAIL;
+void vibramotor_set_step_cb(vibramotor_step_cb_t cb)
+{
+    vibramotor_step_cb = cb;
+}
+
+TaskHandle_t vibramotor_get_task_handle(void)
+{
+    return vibramotor_task_handle;
+}
+
+void vibramotor_get_stats(vibramotor_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = vibramotor_stats;
     }
+}
 
+static esp_err_t vibramotor_task_create(void)
+{
+    if (vibramotor_task_handle != NULL) {
+        return ESP_OK;
+    }
+
+#if CONFIG_VIBRAMOTOR_STATIC_ALLOC
+    vibramotor_task_handle = xTaskCreateStatic(vibramotor_task, "vibramotor_task",
+                                               CONFIG_VIBRAMOTOR_TASK_STACK_SIZE, NULL,
+                                               CONFIG_VIBRAMOTOR_TASK_PRIORITY,
+                                               vibramotor_task_stack, &vibramotor_task_buf);
+#else
+    xTaskCreate(vibramotor_task, "vibramotor_task", CONFIG_VIBRAMOTOR_TASK_STACK_SIZE, NULL,
+                CONFIG_VIBRAMOTOR_TASK_PRIORITY, &vibramotor_task_handle);
+#endif
+    if (vibramotor_task_handle == NULL) {
+        ESP_LOGE(TAG, "Failed to create vibramotor task");
+        return ESP_ERR_NO_MEM;
+    }
     return ESP_OK;
 }
 
@@ -126,7 +254,18 @@ esp_err_t vibramotor_init(uint8_t gpio_num)
         return ret;
     }
 
+#if CONFIG_PM_ENABLE
+    if (vibramotor_pm_lock == NULL) {
+        ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "vibramotor", &vibramotor_pm_lock);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create PM lock: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+#endif
+
     vibramotor_gpio_num = gpio_num;
+    ESP_RETURN_ON_ERROR(vibramotor_task_create(), TAG, "Failed to start vibramotor");
     ESP_LOGI(TAG, "Vibramotor initialized on GPIO %d", gpio_num);
 
     return ESP_OK;
@@ -14,31 +14,123 @@
 #include "freertos/task.h"
 #include "iot_button.h"
 #include "led_strip.h"
+#include "nvs_flash.h"
 
 #include "bsp/bsp.h"
 #include "vibramotor.h"
 
 static const char *TAG = "badge main";
 
+#if !CONFIG_BSP_SCHED
 static TaskHandle_t led_rgb_task_handle = NULL;
+#endif
 void led_rgb_blink_task(void *pvParameters);
 void led_rgb_ring_task(void *pvParameters);
 
-static void btn_1_event_cb(void *arg, void *data)
+#if CONFIG_BSP_SCHED
+/*
+ * With CONFIG_BSP_SCHED the LED effects and the battery monitor run as jobs on the BSP
+ * scheduler task, sharing its stack instead of one task each.
+ */
+static void led_rgb_ring_job(bsp_sched_job_t *job, void *arg);
+static void led_rgb_blink_job(bsp_sched_job_t *job, void *arg);
+static void led_rgb_toggle_job(bsp_sched_job_t *job, void *arg);
+static void led_blink_job(bsp_sched_job_t *job, void *arg);
+static void battery_monitor_job(bsp_sched_job_t *job, void *arg);
+
+static bsp_sched_job_t led_rgb_ring = BSP_SCHED_JOB_INIT(led_rgb_ring_job, NULL, "led_rgb_ring");
+static bsp_sched_job_t led_rgb_blink = BSP_SCHED_JOB_INIT(led_rgb_blink_job, NULL, "led_rgb_blink");
+static bsp_sched_job_t led_rgb_toggle = BSP_SCHED_JOB_INIT(led_rgb_toggle_job, NULL, "led_rgb_toggle");
+static bsp_sched_job_t led_blink = BSP_SCHED_JOB_INIT(led_blink_job, NULL, "led_blink");
+static bsp_sched_job_t battery_monitor = BSP_SCHED_JOB_INIT(battery_monitor_job, NULL, "battery_monitor");
+static bsp_sched_job_t *led_rgb_job = NULL;
+#endif
+
+static void led_rgb_toggle_blink(void)
 {
-    iot_button_print_event((button_handle_t)arg);
-
+#if CONFIG_BSP_SCHED
+    // The LED jobs belong to the scheduler task: switch them from a job, not from the button context
+    bsp_sched_post(&led_rgb_toggle);
+#else
     if (led_rgb_task_handle != NULL) {
+        bsp_monitor_remove_task(led_rgb_task_handle);
         vTaskDelete(led_rgb_task_handle);
         led_rgb_task_handle = NULL;
         // Clear the strip when stopping
-        led_strip_handle_t led_rgb = bsp_get_led_rgb_handle();
-        if (led_rgb) {
-            led_strip_clear(led_rgb);
-        }
+        bsp_led_rgb_clear();
     } else {
         xTaskCreate(led_rgb_blink_task, "led_rgb_blink_task", 2048, NULL, 5, &led_rgb_task_handle);
+        bsp_monitor_add_task(led_rgb_task_handle, 2048);
     }
+#endif
+}
+
+#if CONFIG_BSP_GESTURE
+static void gesture_cb(const bsp_gesture_t *gesture, void *arg)
+{
+    ESP_LOGI(TAG, "Gesture: %s", (const char *)arg);
+    if (gesture->type == BSP_GESTURE_PRESS) {
+        led_rgb_toggle_blink();
+    }
+}
+
+// Button 1 + 2 + 1 + 2 within the default gap
+static const uint32_t btn_code[] = {
+    BSP_GESTURE_BUTTON(BSP_BUTTON_1_GPIO_INDEX), BSP_GESTURE_BUTTON(BSP_BUTTON_2_GPIO_INDEX),
+    BSP_GESTURE_BUTTON(BSP_BUTTON_1_GPIO_INDEX), BSP_GESTURE_BUTTON(BSP_BUTTON_2_GPIO_INDEX),
+};
+
+static const bsp_gesture_t btn_gestures[] = {
+    {
+        .type = BSP_GESTURE_PRESS,
+        .inputs = BSP_GESTURE_BUTTON(BSP_BUTTON_1_GPIO_INDEX),
+        .callback = gesture_cb,
+        .user_arg = "button 1 press",
+    },
+    {
+        .type = BSP_GESTURE_MULTI_PRESS,
+        .inputs = BSP_GESTURE_BUTTON(BSP_BUTTON_2_GPIO_INDEX),
+        .count = 2,
+        .callback = gesture_cb,
+        .user_arg = "button 2 double click",
+    },
+    {
+        .type = BSP_GESTURE_LONG_PRESS,
+        .inputs = BSP_GESTURE_BUTTON(BSP_BUTTON_2_GPIO_INDEX),
+        .time_ms = 5000,
+        .callback = gesture_cb,
+        .user_arg = "button 2 long press",
+    },
+    {
+        .type = BSP_GESTURE_CHORD,
+        .inputs = BSP_GESTURE_BUTTON(BSP_BUTTON_1_GPIO_INDEX) | BSP_GESTURE_BUTTON(BSP_BUTTON_2_GPIO_INDEX),
+        .callback = gesture_cb,
+        .user_arg = "buttons 1 + 2 chord",
+    },
+    {
+        .type = BSP_GESTURE_SEQUENCE,
+        .sequence = btn_code,
+        .count = sizeof(btn_code) / sizeof(btn_code[0]),
+        .callback = gesture_cb,
+        .user_arg = "code 1-2-1-2",
+    },
+};
+
+static esp_err_t btn_register_callbacks(void)
+{
+    // One recognizer task for all buttons instead of per-button iot_button callbacks
+    const bsp_gesture_config_t config = {
+        .gestures = btn_gestures,
+        .num_gestures = sizeof(btn_gestures) / sizeof(btn_gestures[0]),
+        .task_priority = 10,
+    };
+    return bsp_gesture_start(&config);
+}
+#else
+static void btn_1_event_cb(void *arg, void *data)
+{
+    iot_button_print_event((button_handle_t)arg);
+    led_rgb_toggle_blink();
 }
 
 static void btn_2_event_cb(void *arg, void *data)
@@ -76,6 +168,7 @@ static esp_err_t btn_register_callbacks(void)
 
     return ret;
 }
+#endif
 
 void led_rgb_blink_task(void *pvParameters)
 {
@@ -92,15 +185,15 @@ void led_rgb_blink_task(void *pvParameters)
         esp_err_t ret;
         if (led_on_off) {
             for (int i = 0; i < BSP_LED_RGB_PIXELS; i++) {
-                ret = led_strip_set_pixel(led_rgb, i, 5, 5, 5);
+                ret = bsp_led_rgb_set_pixel(i, 5, 5, 5);
                 if (ret != ESP_OK) {
                     ESP_LOGE(TAG, "Failed to set pixel %d: %s", i, esp_err_to_name(ret));
                     break;
                 }
             }
-            led_strip_refresh(led_rgb);
+            bsp_led_rgb_refresh();
         } else {
-            led_strip_clear(led_rgb);
+            bsp_led_rgb_clear();
         }
         led_on_off = !led_on_off;
         vTaskDelay(pdMS_TO_TICKS(500));
@@ -116,22 +209,27 @@ void led_rgb_ring_task(void *pvParameters)
         return;
     }
 
-    int num_leds = BSP_LED_RGB_PIXELS;
-    int current_led = 0;
+    // With CONFIG_BSP_LED_RGB_ASYNC render into the BSP back buffer and let the BSP send it
+    bsp_rgb_t local_frame[BSP_LED_RGB_PIXELS];
+    bsp_rgb_t *back = bsp_led_rgb_get_back_buffer();
+    bsp_rgb_t *frame = (back != NULL) ? back : local_frame;
+    uint32_t step = 0;
+
+    /* Steps to show a frame
+
+    1. Render the effect into the frame (purple head with a 3-pixel tail)
+    2. Show the frame on the strip (swap returns while it is being sent)
+    3. Advance the head
 
-    /* Steps to set the pixel
-    
-    1. Clear the strip
-    2. Set the pixel at current_led to a color (e.g., purple)
-    3. Refresh the strip to show the changes
-    
     */
 
     while (1) {
-        led_strip_clear(led_rgb);
-        led_strip_set_pixel(led_rgb, current_led, 50, 0, 50);
-        led_strip_refresh(led_rgb);
-        current_led = (current_led + 1) % num_leds;
+        bsp_led_fx_chase(frame, BSP_LED_RGB_PIXELS, step++, BSP_RGB(50, 0, 50), 3);
+        if (back != NULL) {
+            bsp_led_rgb_swap(BSP_LED_RGB_WAIT_FOREVER);
+        } else {
+            bsp_led_rgb_show(frame, BSP_LED_RGB_PIXELS);
+        }
         vTaskDelay(pdMS_TO_TICKS(40)); // Adjust delay for speed of ring
     }
 }
@@ -141,11 +239,8 @@ void led_blink_task(void *pvParameters)
     bool led_on_off = false;
 
     while (1) {
-        if (led_on_off) {
-            bsp_gpio_set_level(BSP_LED_IO, 0);
-        } else {
-            bsp_gpio_set_level(BSP_LED_IO, 1);
-        }
+        // BSP_LED_IO is configured by bsp_led_init(), no per-call validation needed
+        bsp_gpio_fast_write(BSP_LED_IO, !led_on_off);
 
         led_on_off = !led_on_off;
         vTaskDelay(pdMS_TO_TICKS(100));
@@ -169,16 +264,115 @@ void led_battery_monitor_task(void *pvParameters)
     }
 }
 
+#if CONFIG_BSP_SCHED
+static void led_rgb_ring_job(bsp_sched_job_t *job, void *arg)
+{
+    static bsp_rgb_t local_frame[BSP_LED_RGB_PIXELS];
+    static uint32_t step = 0;
+
+    // With CONFIG_BSP_LED_RGB_ASYNC render into the BSP back buffer and let the BSP send it
+    bsp_rgb_t *back = bsp_led_rgb_get_back_buffer();
+    bsp_rgb_t *frame = (back != NULL) ? back : local_frame;
+    bsp_led_fx_chase(frame, BSP_LED_RGB_PIXELS, step++, BSP_RGB(50, 0, 50), 3);
+    if (back != NULL) {
+        bsp_led_rgb_swap(BSP_LED_RGB_WAIT_FOREVER);
+    } else {
+        bsp_led_rgb_show(frame, BSP_LED_RGB_PIXELS);
+    }
+}
+
+static void led_rgb_blink_job(bsp_sched_job_t *job, void *arg)
+{
+    static bool led_on_off = false;
+
+    if (led_on_off) {
+        for (int i = 0; i < BSP_LED_RGB_PIXELS; i++) {
+            bsp_led_rgb_set_pixel(i, 5, 5, 5);
+        }
+        bsp_led_rgb_refresh();
+    } else {
+        bsp_led_rgb_clear();
+    }
+    led_on_off = !led_on_off;
+}
+
+static void led_rgb_toggle_job(bsp_sched_job_t *job, void *arg)
+{
+    if (led_rgb_job != NULL) {
+        bsp_sched_cancel(led_rgb_job);
+        led_rgb_job = NULL;
+        // Clear the strip when stopping
+        bsp_led_rgb_clear();
+    } else {
+        led_rgb_job = &led_rgb_blink;
+        bsp_sched_every(led_rgb_job, 500);
+    }
+}
+
+static void led_blink_job(bsp_sched_job_t *job, void *arg)
+{
+    static bool led_on_off = false;
+
+    bsp_gpio_fast_write(BSP_LED_IO, !led_on_off);
+    led_on_off = !led_on_off;
+}
+
+static void battery_monitor_job(bsp_sched_job_t *job, void *arg)
+{
+    float voltage = bsp_get_battery_voltage();
+    float percentage = bsp_get_battery_percentage();
+    if (voltage < 0 || percentage < 0) {
+        ESP_LOGE(TAG, "Failed to read battery voltage or percentage");
+    } else {
+        ESP_LOGI(TAG, "Battery Voltage: %.2f V, Percentage: %.2f%%", voltage, percentage);
+    }
+}
+
+static esp_err_t start_jobs(void)
+{
+    const bsp_sched_config_t sched_config = {
+        .task_priority = 8,
+    };
+    esp_err_t ret = bsp_sched_start(&sched_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    bsp_monitor_add_task(bsp_sched_get_task_handle(), CONFIG_BSP_SCHED_TASK_STACK_SIZE);
+
+    // LED RGB ring (button 1 toggles to blink mode)
+    led_rgb_job = &led_rgb_ring;
+    bsp_sched_every(led_rgb_job, 40);
+
+    // Blink the LED in hardware (CONFIG_BSP_LED_PWM), otherwise from a job
+    if (bsp_led_blink(200, 50) != ESP_OK) {
+        bsp_sched_every(&led_blink, 100);
+    }
+    bsp_sched_every(&battery_monitor, 10000);
+    return ESP_OK;
+}
+#endif
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "Starting HOPE badge basic example");
 
+    // The BSP settings live in NVS, which belongs to the application
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS not available, BSP settings are not persisted: %s", esp_err_to_name(ret));
+    }
+
     // Initialize BSP (I2C, buttons, LEDs, fuel gauge, etc.)
-    esp_err_t ret = bsp_init();
+    ret = bsp_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize BSP: %s", esp_err_to_name(ret));
         return;
     }
+    bsp_init_print_stages();
 
     // Register callbacks for button events
     ret = btn_register_callbacks();
@@ -194,13 +388,30 @@ void app_main(void)
         return;
     }
 
+#if CONFIG_BSP_SCHED
+    ret = start_jobs();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the scheduler: %s", esp_err_to_name(ret));
+        return;
+    }
+#else
     // Start the LED RGB ring task (button 1 toggles to blink mode)
     xTaskCreate(led_rgb_ring_task, "led_rgb_ring_task", 2048, NULL, 8, &led_rgb_task_handle);
+    bsp_monitor_add_task(led_rgb_task_handle, 2048);
 
-    // Start the LED blink task
-    xTaskCreate(led_blink_task, "led_blink_task", 2048, NULL, 7, NULL);
+    // Blink the LED in hardware (CONFIG_BSP_LED_PWM), otherwise from a task
+    TaskHandle_t task_handle = NULL;
+    if (bsp_led_blink(200, 50) != ESP_OK) {
+        xTaskCreate(led_blink_task, "led_blink_task", 2048, NULL, 7, &task_handle);
+        bsp_monitor_add_task(task_handle, 2048);
+    }
     // Start the battery monitor task (needs extra stack for float formatting)
-    xTaskCreate(led_battery_monitor_task, "battery_monitor", 3072, NULL, 5, NULL);
+    xTaskCreate(led_battery_monitor_task, "battery_monitor", 3072, NULL, 5, &task_handle);
+    bsp_monitor_add_task(task_handle, 3072);
+#endif
+
+    // Track stack and heap headroom of the tasks above and the vibramotor task
+    bsp_monitor_start(5000);
 
     // Start the vibramotor run task for 250 ms on, 100 ms off, for 6 cycles
     vibramotor_run(250, 100, 6);